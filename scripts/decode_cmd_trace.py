@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+import argparse
+import struct
+
+# keep in sync with CommandType in src/common.h
+CMD_NAMES = [
+    "read", "read_p", "read_copy", "read_copy_p", "write", "write_p",
+    "write_copy", "write_copy_p", "activate", "precharge", "refresh_bank",
+    "refresh", "self_refresh_enter", "self_refresh_exit",
+    "readcopy_FPM_timing", "readcopy_PSM_timing",
+    "readcopy_PSM_precharge_timing", "writecopy_FPM_timing",
+    "writecopy_PSM_timing", "writecopy_FPM_PRECHARGE_timing",
+    "writecopy_PSM_PRECHARGE_timing"
+]
+
+# keep in sync with CommandRecord in src/cmd_trace.h
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<QQQiiHBbbbBB")
+
+
+def decode(trace_file):
+    """
+    yields (clk, cmd, channel, rank, bankgroup, bank, row, col) per record
+    """
+    with open(trace_file, "rb") as fp:
+        magic, version, record_size = HEADER.unpack(fp.read(HEADER.size))
+        assert magic == b"DS3CMDTR", "not a DRAMsim3 command trace"
+        assert version == 1 and record_size == RECORD.size, \
+            "unsupported command trace version"
+        while True:
+            data = fp.read(RECORD.size)
+            if len(data) < RECORD.size:
+                break
+            clk, _, _, row, col, chan, cmd, rank, bg, bank, _, _ = \
+                RECORD.unpack(data)
+            yield clk, CMD_NAMES[cmd], chan, rank, bg, bank, row, col
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="Convert a binary command trace into per channel text "
+                    "traces that validation.py takes")
+    parser.add_argument("trace", help="binary command trace")
+    parser.add_argument("-o", "--output-prefix", default="",
+                        help="prefix of the text traces, "
+                             "ch_<n>cmd.trace is appended")
+    args = parser.parse_args()
+
+    outputs = {}
+    for clk, cmd, chan, rank, bg, bank, row, col in decode(args.trace):
+        if chan not in outputs:
+            outputs[chan] = open("%sch_%dcmd.trace" % (args.output_prefix, chan), "w")
+        outputs[chan].write("{:<18} {:<20} {:>3} {:>3} {:>3} {:>3} {:>#8x} {:>#8x}\n".format(
+            clk, cmd, chan, rank, bg, bank, row, col))
+    for fp in outputs.values():
+        fp.close()
@@ -0,0 +1,140 @@
+#include "address_mapping.h"
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+#include <iostream>
+
+namespace dramsim3 {
+
+namespace {
+int PopCount(uint64_t bits) {
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+// the address bit the k'th lowest bit of mask is, -1 past the last one
+int NthBit(uint64_t mask, int k) {
+    for (int i = 0; i < 64; i++) {
+        if (mask & (1ull << i)) {
+            if (k == 0) {
+                return i;
+            }
+            k--;
+        }
+    }
+    return -1;
+}
+}  // namespace
+
+BitFieldMapping::BitFieldMapping() : num_bytes_(0) {
+    for (int i = 0; i < kNumFields; i++) {
+        bits_[i] = 0;
+        offsets_[i] = 0;
+        widths_[i] = 0;
+    }
+}
+
+void BitFieldMapping::SetField(AddressField field, uint64_t bits,
+                               const std::vector<uint64_t>& xor_terms) {
+    int i = static_cast<int>(field);
+    bits_[i] = bits;
+    xor_terms_[i] = xor_terms;
+    return;
+}
+
+void BitFieldMapping::Build() {
+    uint64_t used = 0;
+    int offset = 0;
+    for (int i = 0; i < kNumFields; i++) {
+        if (used & bits_[i]) {
+            std::cerr << "Address fields share address bits" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        used |= bits_[i];
+        widths_[i] = PopCount(bits_[i]);
+        offsets_[i] = offset;
+        offset += widths_[i];
+        for (auto term : xor_terms_[i]) {
+            if (PopCount(term) != widths_[i] || (term & bits_[i])) {
+                std::cerr << "An XOR term of an address field has to have "
+                             "as many bits as the field, none of its own"
+                          << std::endl;
+                AbruptExit(__FILE__, __LINE__);
+            }
+        }
+    }
+
+    // what each address bit adds to the packed fields
+    uint64_t contribution[64] = {};
+    for (int i = 0; i < kNumFields; i++) {
+        for (int k = 0; k < widths_[i]; k++) {
+            contribution[NthBit(bits_[i], k)] ^= 1ull << (offsets_[i] + k);
+            for (auto term : xor_terms_[i]) {
+                contribution[NthBit(term, k)] ^= 1ull << (offsets_[i] + k);
+            }
+        }
+    }
+    num_bytes_ = 0;
+    for (int a = 0; a < 64; a++) {
+        if (contribution[a] != 0) {
+            num_bytes_ = a / 8 + 1;
+        }
+    }
+    tables_.assign(num_bytes_ * 256, 0);
+    for (int b = 0; b < num_bytes_; b++) {
+        for (int value = 0; value < 256; value++) {
+            uint64_t packed = 0;
+            for (int j = 0; j < 8; j++) {
+                if (value & (1 << j)) {
+                    packed ^= contribution[b * 8 + j];
+                }
+            }
+            tables_[b * 256 + value] = packed;
+        }
+    }
+    return;
+}
+
+Address BitFieldMapping::Map(uint64_t hex_addr) const {
+#ifdef __BMI2__
+    int fields[kNumFields];
+    for (int i = 0; i < kNumFields; i++) {
+        uint64_t value = _pext_u64(hex_addr, bits_[i]);
+        for (auto term : xor_terms_[i]) {
+            value ^= _pext_u64(hex_addr, term);
+        }
+        fields[i] = static_cast<int>(value);
+    }
+    return Address(fields[0], fields[1], fields[2], fields[3], fields[4],
+                   fields[5]);
+#else
+    uint64_t packed = 0;
+    for (int b = 0; b < num_bytes_; b++) {
+        packed ^= tables_[b * 256 + ((hex_addr >> (8 * b)) & 0xff)];
+    }
+    return Address(Field(packed, 0), Field(packed, 1), Field(packed, 2),
+                   Field(packed, 3), Field(packed, 4), Field(packed, 5));
+#endif
+}
+
+void BitFieldMapping::Map(const uint64_t* hex_addrs, size_t count,
+                          Address* addrs) const {
+    for (size_t i = 0; i < count; i++) {
+        addrs[i] = Map(hex_addrs[i]);
+    }
+    return;
+}
+
+uint64_t BitFieldMapping::FieldAddressBits(AddressField field) const {
+    int i = static_cast<int>(field);
+    uint64_t bits = bits_[i];
+    for (auto term : xor_terms_[i]) {
+        bits |= term;
+    }
+    return bits;
+}
+
+}  // namespace dramsim3
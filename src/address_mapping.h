@@ -0,0 +1,54 @@
+#ifndef __ADDRESS_MAPPING_H
+#define __ADDRESS_MAPPING_H
+
+#include <string>
+#include <vector>
+#include "common.h"
+
+namespace dramsim3 {
+
+// Address fields in the order of Address and of the mapping tokens
+enum class AddressField { CHANNEL, RANK, BANKGROUP, BANK, ROW, COLUMN, SIZE };
+
+// Address mapping where every field is taken from an arbitrary set of
+// address bits, lowest bit first, and can have any number of XOR terms,
+// other sets of as many address bits XORed into it (permutation based
+// interleaving, channel hashing ...). Decoding uses PEXT where the build
+// has BMI2, and otherwise one table lookup per address byte, which works
+// because all of it is linear in the address bits.
+class BitFieldMapping {
+   public:
+    BitFieldMapping();
+    // bits is the mask of the address bits of the field, each xor_terms
+    // entry a mask with as many bits. Done with all fields before Map
+    void SetField(AddressField field, uint64_t bits,
+                  const std::vector<uint64_t>& xor_terms);
+    // checks the fields don't overlap and builds the lookup tables
+    void Build();
+
+    Address Map(uint64_t hex_addr) const;
+    // the same for a batch of addresses, e.g. a whole trace
+    void Map(const uint64_t* hex_addrs, size_t count, Address* addrs) const;
+
+    // every address bit the field depends on, xor terms included
+    uint64_t FieldAddressBits(AddressField field) const;
+
+   private:
+    static const int kNumFields = static_cast<int>(AddressField::SIZE);
+    uint64_t bits_[kNumFields];
+    std::vector<uint64_t> xor_terms_[kNumFields];
+
+    // the fields packed into one word, field i at offsets_[i]
+    int offsets_[kNumFields];
+    int widths_[kNumFields];
+    // [byte][value]: the packed fields one byte of the address adds in
+    int num_bytes_;
+    std::vector<uint64_t> tables_;
+
+    uint64_t Field(uint64_t packed, int field) const {
+        return (packed >> offsets_[field]) & ((1ull << widths_[field]) - 1);
+    }
+};
+
+}  // namespace dramsim3
+#endif
@@ -3,34 +3,10 @@
 namespace dramsim3 {
 
 BankState::BankState()
-    : state_(State::CLOSED),
-      cmd_timing_(static_cast<int>(CommandType::SIZE)),
-      open_row_(-1),
-      row_hit_count_(0) {
-    cmd_timing_[static_cast<int>(CommandType::READ)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::READ_PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITE_PRECHARGE)] = 0;
+    : state_(State::CLOSED), open_row_(-1), row_hit_count_(0) {}
 
-    cmd_timing_[static_cast<int>(CommandType::READCOPY_FPM)] = 0;                   // ---- ROWCLONE ADDED
-    cmd_timing_[static_cast<int>(CommandType::READCOPY_PSM)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::READCOPY_PSM_PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITECOPY_FPM)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITECOPY_FPM_PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITECOPY_PSM)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::WRITECOPY_PSM_PRECHARGE)] = 0;        // ---- ROWCLONE ADDED
-
-    cmd_timing_[static_cast<int>(CommandType::ACTIVATE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::PRECHARGE)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::REFRESH)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::SREF_ENTER)] = 0;
-    cmd_timing_[static_cast<int>(CommandType::SREF_EXIT)] = 0;
-}
-
-
-Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
+Command BankState::RequiredCommand(const Command& cmd) const {
     CommandType required_type = CommandType::SIZE;
-    CommandType copy_type = CommandType::SIZE;
     switch (state_) {
         case State::CLOSED:
             //std::cout << "Bank State : CLOSED" << std::endl;
@@ -187,39 +163,12 @@ Command BankState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
     if (required_type != CommandType::SIZE) {
         if((required_type == CommandType::READCOPY) || (required_type == CommandType::WRITECOPY) ||
                 (required_type == CommandType::READCOPY_PRECHARGE) ||(required_type == CommandType::WRITECOPY_PRECHARGE)){
-
-            if((required_type == CommandType::READCOPY) && (cmd.isFPM)){copy_type = CommandType::READCOPY_FPM;}
-            else if((required_type == CommandType::READCOPY) && (!cmd.isFPM)){copy_type = CommandType::READCOPY_PSM;}
-            else if((required_type == CommandType::READCOPY_PRECHARGE) && (cmd.isFPM)){copy_type = CommandType::READCOPY_FPM;}
-            else if((required_type == CommandType::READCOPY_PRECHARGE) && (!cmd.isFPM)){copy_type = CommandType::READCOPY_PSM_PRECHARGE;}
-            else if((required_type == CommandType::WRITECOPY) && (cmd.isFPM)){copy_type = CommandType::WRITECOPY_FPM;}
-            else if((required_type == CommandType::WRITECOPY) && (!cmd.isFPM)){copy_type = CommandType::WRITECOPY_PSM;}
-            else if((required_type == CommandType::WRITECOPY_PRECHARGE) && (cmd.isFPM)){copy_type = CommandType::WRITECOPY_FPM_PRECHARGE;}
-            else {copy_type = CommandType::WRITECOPY_PSM_PRECHARGE;}
-
-            if (clk >= cmd_timing_[static_cast<int>(copy_type)]) {
-                return Command(required_type, cmd.addr, cmd.hex_addr);
-            }
-
-        }
-        else{
-            if (clk >= cmd_timing_[static_cast<int>(required_type)]) {
-                /*switch(cmd.cmd_type){
-                    case CommandType::READCOPY:
-                    case CommandType::READCOPY_PRECHARGE:
-                        std::cout<<"READCOPY ";
-                        break;
-                    case CommandType::WRITECOPY:
-                    case CommandType::WRITECOPY_PRECHARGE:
-                        std::cout<<"WRITECOPY ";
-                        break;
-                    default:
-                        std::cout<<"ELSE ";
-                        break;
-                }*/
-                return Command(required_type, cmd.addr, cmd.hex_addr);
-            }
+            Command ready_cmd(required_type, cmd.addr, cmd.hex_addr);
+            ready_cmd.isFPM = cmd.isFPM;
+            ready_cmd.dest_address = cmd.dest_address;
+            return ready_cmd;
         }
+        return Command(required_type, cmd.addr, cmd.hex_addr);
     }
     return Command();
 }
@@ -338,9 +287,15 @@ void BankState::UpdateState(const Command& cmd) {
     return;
 }
 
-void BankState::UpdateTiming(CommandType cmd_type, uint64_t time) {
-    cmd_timing_[static_cast<int>(cmd_type)] =
-        std::max(cmd_timing_[static_cast<int>(cmd_type)], time);
+void BankState::WarmUp(const Command& cmd) {
+    if (state_ == State::OPEN &&
+        (cmd.IsRefresh() || open_row_ != cmd.Row())) {
+        UpdateState(Command(CommandType::PRECHARGE, cmd.addr, cmd.hex_addr));
+    }
+    if (state_ == State::CLOSED && !cmd.IsRefresh()) {
+        UpdateState(Command(CommandType::ACTIVATE, cmd.addr, cmd.hex_addr));
+    }
+    UpdateState(cmd);
     return;
 }
 
@@ -366,4 +321,12 @@ bool BankState::CanStartWait(Address dest, uint64_t clk) const {
     return false;
 }
 
+void BankState::Serialize(Checkpoint& cp) {
+    cp.Field(state_);
+    cp.Field(open_row_);
+    cp.Field(row_hit_count_);
+    cp.Field(waiting_command_);
+    cp.Field(wait_prev_state_);
+}
+
 }  // namespace dramsim3
@@ -2,6 +2,7 @@
 #define __BANKSTATE_H
 
 #include <vector>
+#include "checkpoint.h"
 #include "common.h"
 
 namespace dramsim3 {
@@ -11,13 +12,19 @@ class BankState {
     BankState();
 
     enum class State { OPEN, CLOSED, SREF, PD, WAIT_WRITECOPY, SIZE };
-    Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
+    // The command the bank needs next on the way to cmd (cmd itself, or a
+    // precharge, activate ...) whenever its timing allows it, which is up to
+    // ChannelState, or an invalid command if cmd has to wait for the state
+    // to change
+    Command RequiredCommand(const Command& cmd) const;
 
     // Update the state of the bank resulting after the execution of the command
     void UpdateState(const Command& cmd);
 
-    // Update the existing timing constraints for the command
-    void UpdateTiming(const CommandType cmd_type, uint64_t time);
+    // Functional warm-up: the bank ends up in the state cmd leaves it in,
+    // through the precharge and activate it would need, without any timing
+    // being checked or updated
+    void WarmUp(const Command& cmd);
 
     bool IsRowOpen() const { return state_ == State::OPEN; }
     int OpenRow() const { return open_row_; }
@@ -29,14 +36,14 @@ class BankState {
     bool isRightCommand(const Command& cmd) const;
     bool CanStartWait(Address dest, uint64_t clk) const;
 
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
    private:
     // Current state of the Bank
     // Apriori or instantaneously transitions on a command.
     State state_;
 
-    // Earliest time when the particular Command can be executed in this bank
-    std::vector<uint64_t> cmd_timing_;
-
     // Currently open row
     int open_row_;
 
@@ -0,0 +1,267 @@
+#include "binary_trace.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace dramsim3 {
+
+namespace {
+const char kMagic[8] = {'D', 'S', '3', 'T', 'R', 'A', 'C', 'E'};
+const uint32_t kVersion = 1;
+// magic, version, index interval and four u64 fields
+const size_t kHeaderSize = 8 + 4 + 4 + 4 * 8;
+
+void PutFixed(std::string& out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+uint64_t GetFixed(const uint8_t* in, int bytes) {
+    uint64_t value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// small deltas either way get small codes
+uint64_t ZigZag(uint64_t delta) {
+    return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+uint64_t UnZigZag(uint64_t code) { return (code >> 1) ^ (0 - (code & 1)); }
+}  // namespace
+
+BinaryTraceWriter::BinaryTraceWriter(const std::string& file_name,
+                                     uint32_t index_interval)
+    : file_(file_name, std::ofstream::binary),
+      index_interval_(std::max(index_interval, 1u)),
+      num_records_(0),
+      offset_(0),
+      prev_cycle_(0),
+      prev_addr_(0),
+      closed_(false) {
+    if (file_.fail()) {
+        std::cerr << "Cannot open " << file_name << " for writing" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    // the header is filled in by Close
+    buffer_.assign(kHeaderSize, '\0');
+}
+
+BinaryTraceWriter::~BinaryTraceWriter() {
+    if (!closed_) {
+        Close();
+    }
+}
+
+void BinaryTraceWriter::Add(const Transaction& trans) {
+    if (num_records_ % index_interval_ == 0) {
+        index_.push_back(
+            {trans.added_cycle, offset_ + buffer_.size(), prev_cycle_,
+             prev_addr_});
+    }
+    uint8_t flags = 0;
+    if (trans.is_write) {
+        flags |= kTraceWrite;
+    }
+    if (trans.is_copy) {
+        flags |= kTraceCopy;
+    }
+    buffer_.push_back(static_cast<char>(flags));
+    PutVarint(buffer_, ZigZag(trans.added_cycle - prev_cycle_));
+    PutVarint(buffer_, ZigZag(trans.addr.src_addr - prev_addr_));
+    if (trans.is_copy) {
+        PutVarint(buffer_, ZigZag(trans.addr.dest_addr - trans.addr.src_addr));
+    }
+    prev_cycle_ = trans.added_cycle;
+    prev_addr_ = trans.addr.src_addr;
+    num_records_++;
+    if (buffer_.size() >= (1 << 20)) {
+        Flush();
+    }
+}
+
+void BinaryTraceWriter::Flush() {
+    file_.write(buffer_.data(), buffer_.size());
+    offset_ += buffer_.size();
+    buffer_.clear();
+}
+
+void BinaryTraceWriter::Close() {
+    // the index starts 8 byte aligned
+    while ((offset_ + buffer_.size()) % 8 != 0) {
+        buffer_.push_back('\0');
+    }
+    uint64_t index_offset = offset_ + buffer_.size();
+    for (const auto& entry : index_) {
+        PutFixed(buffer_, entry.cycle, 8);
+        PutFixed(buffer_, entry.offset, 8);
+        PutFixed(buffer_, entry.prev_cycle, 8);
+        PutFixed(buffer_, entry.prev_addr, 8);
+    }
+    Flush();
+
+    std::string header(kMagic, sizeof(kMagic));
+    PutFixed(header, kVersion, 4);
+    PutFixed(header, index_interval_, 4);
+    PutFixed(header, num_records_, 8);
+    PutFixed(header, kHeaderSize, 8);
+    PutFixed(header, index_offset, 8);
+    PutFixed(header, index_.size(), 8);
+    file_.seekp(0);
+    file_.write(header.data(), header.size());
+    file_.close();
+    closed_ = true;
+}
+
+BinaryTraceReader::BinaryTraceReader(const std::string& file_name)
+    : data_(nullptr), size_(0), record_(0), cycle_(0), addr_(0) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        std::cerr << "Trace file does not exist" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    size_ = st.st_size;
+    if (size_ >= kHeaderSize) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            data_ = static_cast<const uint8_t*>(data);
+            madvise(data, size_, MADV_SEQUENTIAL);
+        }
+    }
+    close(fd);
+    if (data_ == nullptr ||
+        std::memcmp(data_, kMagic, sizeof(kMagic)) != 0 ||
+        GetFixed(data_ + 8, 4) != kVersion) {
+        std::cerr << file_name << " is not a binary trace" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    index_interval_ = GetFixed(data_ + 12, 4);
+    num_records_ = GetFixed(data_ + 16, 8);
+    uint64_t records_offset = GetFixed(data_ + 24, 8);
+    uint64_t index_offset = GetFixed(data_ + 32, 8);
+    uint64_t num_entries = GetFixed(data_ + 40, 8);
+    if (index_interval_ == 0 || records_offset > index_offset ||
+        index_offset > size_ ||
+        num_entries > (size_ - index_offset) / 32) {
+        std::cerr << file_name << " is truncated" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    records_ = data_ + records_offset;
+    pos_ = records_;
+    end_ = data_ + index_offset;
+    const uint8_t* entry = end_;
+    for (uint64_t i = 0; i < num_entries; i++, entry += 32) {
+        index_.push_back({GetFixed(entry, 8), GetFixed(entry + 8, 8),
+                          GetFixed(entry + 16, 8), GetFixed(entry + 24, 8)});
+    }
+}
+
+BinaryTraceReader::~BinaryTraceReader() {
+    if (data_ != nullptr) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+    }
+}
+
+bool BinaryTraceReader::IsBinaryTrace(const std::string& file_name) {
+    std::ifstream file(file_name, std::ifstream::binary);
+    char magic[sizeof(kMagic)];
+    file.read(magic, sizeof(magic));
+    return file.gcount() == sizeof(magic) &&
+           std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+uint64_t BinaryTraceReader::ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; pos_ < end_ && shift < 64; shift += 7) {
+        uint8_t byte = *pos_++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+    std::cerr << "Corrupted binary trace" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+    return 0;
+}
+
+bool BinaryTraceReader::Next(Transaction& trans) {
+    if (record_ == num_records_) {
+        return false;
+    }
+    if (pos_ == end_) {
+        std::cerr << "Corrupted binary trace" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    uint8_t flags = *pos_++;
+    cycle_ += UnZigZag(ReadVarint());
+    addr_ += UnZigZag(ReadVarint());
+    trans.added_cycle = cycle_;
+    trans.is_write = flags & kTraceWrite;
+    trans.is_copy = flags & kTraceCopy;
+    if (trans.is_copy) {
+        trans.addr = AddressPair(addr_, addr_ + UnZigZag(ReadVarint()));
+    } else {
+        trans.addr = AddressPair(addr_);
+    }
+    trans.addr.is_copy = trans.is_copy;
+    record_++;
+    return true;
+}
+
+void BinaryTraceReader::Seek(uint64_t cycle) {
+    // last indexed record before cycle, anything at cycle may come before
+    // the next one
+    auto it = std::lower_bound(
+        index_.begin(), index_.end(), cycle,
+        [](const TraceIndexEntry& entry, uint64_t cycle) {
+            return entry.cycle < cycle;
+        });
+    if (it != index_.begin()) {
+        --it;
+        pos_ = data_ + it->offset;
+        record_ = static_cast<uint64_t>(it - index_.begin()) * index_interval_;
+        cycle_ = it->prev_cycle;
+        addr_ = it->prev_addr;
+    } else {
+        // nothing indexed before cycle, start over from the first record
+        pos_ = records_;
+        record_ = 0;
+        cycle_ = 0;
+        addr_ = 0;
+    }
+    Transaction trans;
+    while (true) {
+        const uint8_t* pos = pos_;
+        uint64_t prev_cycle = cycle_;
+        uint64_t prev_addr = addr_;
+        if (!Next(trans)) {
+            return;
+        }
+        if (trans.added_cycle >= cycle) {
+            pos_ = pos;
+            record_--;
+            cycle_ = prev_cycle;
+            addr_ = prev_addr;
+            return;
+        }
+    }
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,88 @@
+#ifndef __BINARY_TRACE_H
+#define __BINARY_TRACE_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include "common.h"
+
+namespace dramsim3 {
+
+// Binary transaction traces, made from text traces with traceconvert.
+// The file is a fixed size header, the records, and an index:
+//   header  magic "DS3TRACE", then little endian u32 version, u32 index
+//           interval, u64 number of records, u64 offset of the records,
+//           u64 offset of the index and u64 number of index entries
+//   record  a flag byte (kTraceWrite, kTraceCopy), the cycle and the source
+//           address as zigzag varint deltas from the previous record, and
+//           for copies the destination as a zigzag varint delta from the
+//           source
+//   index   for every index interval'th record, its cycle, its offset and
+//           the cycle and address of the record before it, each a u64
+const uint8_t kTraceWrite = 1;
+const uint8_t kTraceCopy = 2;
+
+struct TraceIndexEntry {
+    uint64_t cycle;
+    uint64_t offset;
+    uint64_t prev_cycle;
+    uint64_t prev_addr;
+};
+
+class BinaryTraceWriter {
+   public:
+    BinaryTraceWriter(const std::string& file_name, uint32_t index_interval);
+    ~BinaryTraceWriter();
+    void Add(const Transaction& trans);
+    // writes the index and the header, nothing can be added after this
+    void Close();
+    uint64_t NumRecords() const { return num_records_; }
+
+   private:
+    std::ofstream file_;
+    uint32_t index_interval_;
+    uint64_t num_records_;
+    uint64_t offset_;
+    uint64_t prev_cycle_;
+    uint64_t prev_addr_;
+    std::vector<TraceIndexEntry> index_;
+    std::string buffer_;
+    bool closed_;
+
+    void Flush();
+};
+
+// Reads a binary trace straight out of a read only mapping of the file
+class BinaryTraceReader {
+   public:
+    BinaryTraceReader(const std::string& file_name);
+    ~BinaryTraceReader();
+    // whether the file starts with the binary trace magic
+    static bool IsBinaryTrace(const std::string& file_name);
+    // false once the trace is exhausted
+    bool Next(Transaction& trans);
+    // moves to the first record added at or after cycle, going through the
+    // index, so records have to be in cycle order for this to be exact
+    void Seek(uint64_t cycle);
+    uint64_t NumRecords() const { return num_records_; }
+
+   private:
+    const uint8_t* data_;
+    size_t size_;
+    const uint8_t* records_;
+    const uint8_t* pos_;
+    const uint8_t* end_;
+    uint64_t num_records_;
+    uint32_t index_interval_;
+    // number of the record pos_ points to, and the cycle and address of the
+    // one before it
+    uint64_t record_;
+    uint64_t cycle_;
+    uint64_t addr_;
+    std::vector<TraceIndexEntry> index_;
+
+    uint64_t ReadVarint();
+};
+
+}  // namespace dramsim3
+#endif
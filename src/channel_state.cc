@@ -1,32 +1,63 @@
 #include "channel_state.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <limits>
 
 namespace dramsim3 {
+
+namespace {
+// no constraint in a timing row, low enough that clk plus it stays negative
+const int64_t kNoTiming = std::numeric_limits<int64_t>::min() / 2;
+}  // namespace
+
 ChannelState::ChannelState(const Config& config, const Timing& timing)
     : rank_idle_cycles(config.ranks, 0),
       config_(config),
       timing_(timing),
       rank_is_sref_(config.ranks, false),
-      four_aw_(config_.ranks, std::vector<uint64_t>()),
-      thirty_two_aw_(config_.ranks, std::vector<uint64_t>()) {
-    bank_states_.reserve(config_.ranks);
-    for (auto i = 0; i < config_.ranks; i++) {
-        auto rank_states = std::vector<std::vector<BankState>>();
-        rank_states.reserve(config_.bankgroups);
-        for (auto j = 0; j < config_.bankgroups; j++) {
-            auto bg_states =
-                std::vector<BankState>(config_.banks_per_group, BankState());
-            rank_states.push_back(bg_states);
+      four_aw_(config_.ranks, ActivationWindow(4, config_.tFAW)),
+      thirty_two_aw_(config_.IsGDDR() ? config_.ranks : 0,
+                     ActivationWindow(32, config_.t32AW)),
+      timing_table_on_(config.timing_engine != "LAZY"),
+      lazy_timing_on_(config.timing_engine != "EAGER"),
+      lazy_timing_(config, timing) {
+    bank_states_.resize(config_.ranks * config_.banks);
+    if (!timing_table_on_) {
+        return;
+    }
+    // a new bank can take any command right away
+    cmd_timing_.resize(bank_states_.size() * kTimingStride, 0);
+
+    int num_scopes = static_cast<int>(TimingScope::SIZE);
+    int num_types = static_cast<int>(CommandType::SIZE);
+    timing_rows_.resize(num_types * num_scopes * kTimingStride, kNoTiming);
+    scope_has_timing_.resize(num_types * num_scopes, false);
+    for (int s = 0; s < num_scopes; s++) {
+        BuildTimingRows(static_cast<TimingScope>(s));
+    }
+}
+
+void ChannelState::BuildTimingRows(TimingScope scope) {
+    const auto& lists = timing_.Lists(scope);
+    int num_scopes = static_cast<int>(TimingScope::SIZE);
+    for (size_t i = 0; i < lists.size(); i++) {
+        int row = i * num_scopes + static_cast<int>(scope);
+        int64_t* delays = &timing_rows_[row * kTimingStride];
+        for (auto cmd_timing : lists[i]) {
+            int j = static_cast<int>(cmd_timing.first);
+            delays[j] =
+                std::max(delays[j], static_cast<int64_t>(cmd_timing.second));
+            scope_has_timing_[row] = true;
         }
-        bank_states_.push_back(rank_states);
     }
 }
 
 bool ChannelState::IsAllBankIdleInRank(int rank) const {
-    for (int j = 0; j < config_.bankgroups; j++) {
-        for (int k = 0; k < config_.banks_per_group; k++) {
-            if (bank_states_[rank][j][k].IsRowOpen()) {
-                return false;
-            }
+    for (int i = rank * config_.banks; i < (rank + 1) * config_.banks; i++) {
+        if (bank_states_[i].IsRowOpen()) {
+            return false;
         }
     }
     return true;
@@ -38,7 +69,7 @@ bool ChannelState::IsRWPendingOnRef(const Command& cmd) const {
     int bank = cmd.Bank();
     return (IsRowOpen(rank, bankgroup, bank) &&
             RowHitCount(rank, bankgroup, bank) == 0 &&
-            bank_states_[rank][bankgroup][bank].OpenRow() == cmd.Row());
+            OpenRow(rank, bankgroup, bank) == cmd.Row());
 }
 
 void ChannelState::BankNeedRefresh(int rank, int bankgroup, int bank,
@@ -73,11 +104,22 @@ void ChannelState::RankNeedRefresh(int rank, bool need) {
     return;
 }
 
+bool ChannelState::IsRefreshQueued(int rank, int bankgroup, int bank) const {
+    for (const auto& ref : refresh_q_) {
+        if (ref.Rank() == rank && ref.Bankgroup() == bankgroup &&
+            ref.Bank() == bank) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // Rowclone added
 bool ChannelState::CanStartWait(const Command& cmd, uint64_t clk) const{
     // only called when read copy ( cmd -> write copy )
-    auto dest = config_.AddressMapping(cmd.hex_addr.dest_addr);
-    return bank_states_[dest.rank][dest.bankgroup][dest.bank].CanStartWait(dest, clk);
+    const auto& dest = cmd.dest_address;
+    return bank_states_[BankIndex(dest.rank, dest.bankgroup, dest.bank)]
+        .CanStartWait(dest, clk);
 }
 
 
@@ -88,9 +130,11 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
         for (auto j = 0; j < config_.bankgroups; j++) {
             for (auto k = 0; k < config_.banks_per_group; k++) {
                 ready_cmd =
-                    bank_states_[cmd.Rank()][j][k].GetReadyCommand(cmd, clk);
-                if (!ready_cmd.IsValid()) {  // Not ready
-                    continue;
+                    bank_states_[BankIndex(cmd.Rank(), j, k)].RequiredCommand(
+                        cmd);
+                if (!ready_cmd.IsValid() ||
+                    clk < BankReadyCycle(cmd.Rank(), j, k, ready_cmd)) {
+                    continue;  // Not ready
                 }
                 if (ready_cmd.cmd_type != cmd.cmd_type) {  // likely PRECHARGE
                     Address new_addr = Address(-1, cmd.Rank(), j, k, -1, -1);
@@ -109,9 +153,12 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
         }
     } else {
         //std::cout<<"channelstategetreadycommand"<<std::endl;
-        ready_cmd = bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()]
-                        .GetReadyCommand(cmd, clk);
-        if (!ready_cmd.IsValid()) {
+        ready_cmd =
+            bank_states_[BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank())]
+                .RequiredCommand(cmd);
+        if (!ready_cmd.IsValid() ||
+            clk < BankReadyCycle(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(),
+                                 ready_cmd)) {
             return Command();
         }
         if (ready_cmd.cmd_type == CommandType::ACTIVATE) {
@@ -123,13 +170,73 @@ Command ChannelState::GetReadyCommand(const Command& cmd, uint64_t clk) const {
     }
 }
 
-void ChannelState::UpdateState(const Command& cmd) {
+uint64_t ChannelState::EarliestReadyCycle(const Command& cmd) const {
+    // this is a lower bound, GetReadyCommand may still turn the command
+    // down later, e.g. because another bank in the rank activated first
     if (cmd.IsRankCMD()) {
+        uint64_t earliest = std::numeric_limits<uint64_t>::max();
         for (auto j = 0; j < config_.bankgroups; j++) {
             for (auto k = 0; k < config_.banks_per_group; k++) {
-                bank_states_[cmd.Rank()][j][k].UpdateState(cmd);
+                earliest = std::min(earliest,
+                                    BankEarliestReadyCycle(cmd.Rank(), j, k, cmd));
             }
         }
+        return earliest;
+    } else {
+        return BankEarliestReadyCycle(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(),
+                                      cmd);
+    }
+}
+
+uint64_t ChannelState::BankEarliestReadyCycle(int rank, int bankgroup,
+                                              int bank,
+                                              const Command& cmd) const {
+    // the command (or its prerequisite) that will eventually be ready
+    auto ready_cmd =
+        bank_states_[BankIndex(rank, bankgroup, bank)].RequiredCommand(cmd);
+    if (!ready_cmd.IsValid()) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    uint64_t ready = BankReadyCycle(rank, bankgroup, bank, ready_cmd);
+    if (ready_cmd.cmd_type == CommandType::ACTIVATE) {
+        ready = std::max(ready, EarliestActivateCycle(rank));
+    }
+    return ready;
+}
+
+uint64_t ChannelState::BankReadyCycle(int rank, int bankgroup, int bank,
+                                      const Command& ready_cmd) const {
+    CommandType timing_type = ready_cmd.cmd_type;
+    if (ready_cmd.IsReadCopy() || ready_cmd.IsWriteCopy()) {
+        timing_type = CopyTimingType(timing_type, ready_cmd.isFPM);
+    }
+    if (!lazy_timing_on_) {
+        return cmd_timing_[BankIndex(rank, bankgroup, bank) * kTimingStride +
+                           static_cast<int>(timing_type)];
+    }
+    uint64_t ready =
+        lazy_timing_.ReadyCycle(rank, bankgroup, bank, timing_type);
+    if (timing_table_on_) {
+        uint64_t table_ready =
+            cmd_timing_[BankIndex(rank, bankgroup, bank) * kTimingStride +
+                        static_cast<int>(timing_type)];
+        if (ready != table_ready) {
+            std::cerr << "Lazy timing gives cycle " << ready << " for "
+                      << ready_cmd << " to rank " << rank << " bankgroup "
+                      << bankgroup << " bank " << bank
+                      << ", the timing table " << table_ready << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+    }
+    return ready;
+}
+
+void ChannelState::UpdateState(const Command& cmd) {
+    if (cmd.IsRankCMD()) {
+        int first = cmd.Rank() * config_.banks;
+        for (int i = first; i < first + config_.banks; i++) {
+            bank_states_[i].UpdateState(cmd);
+        }
         if (cmd.IsRefresh()) {
             RankNeedRefresh(cmd.Rank(), false);
         } else if (cmd.cmd_type == CommandType::SREF_ENTER) {
@@ -138,7 +245,8 @@ void ChannelState::UpdateState(const Command& cmd) {
             rank_is_sref_[cmd.Rank()] = false;
         }
     } else {
-        bank_states_[cmd.Rank()][cmd.Bankgroup()][cmd.Bank()].UpdateState(cmd);
+        bank_states_[BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank())]
+            .UpdateState(cmd);
         if (cmd.IsRefresh()) {
             BankNeedRefresh(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), false);
         } else if (cmd.IsReadCopy()){
@@ -146,22 +254,45 @@ void ChannelState::UpdateState(const Command& cmd) {
             //std::cout<<"making wait"<<std::endl;
             if(!cmd.isFPM){
                 //std::cout<<"have to make wait"<<std::endl;
-                auto dest_address = config_.AddressMapping(cmd.hex_addr.dest_addr);
-                bank_states_[dest_address.rank][dest_address.bankgroup][dest_address.bank].StartWaitWriteCopy(cmd);
+                const auto& dest_address = cmd.dest_address;
+                bank_states_[BankIndex(dest_address.rank, dest_address.bankgroup,
+                                       dest_address.bank)]
+                    .StartWaitWriteCopy(cmd);
                 //std::cout<<dest_address.rank<<" start wait"<<std::endl;
             }
             // if not FPM? (same bank copy!?)
             else{
-                auto dest_address = config_.AddressMapping(cmd.hex_addr.dest_addr);
-                bank_states_[dest_address.rank][dest_address.bankgroup][dest_address.bank].FPMWaitWritecopy(cmd);
+                const auto& dest_address = cmd.dest_address;
+                bank_states_[BankIndex(dest_address.rank, dest_address.bankgroup,
+                                       dest_address.bank)]
+                    .FPMWaitWritecopy(cmd);
             }
         }
     }
     return;
 }
 
+void ChannelState::WarmUp(const Command& cmd) {
+    if (cmd.IsRankCMD()) {
+        int first = cmd.Rank() * config_.banks;
+        for (int i = first; i < first + config_.banks; i++) {
+            bank_states_[i].WarmUp(cmd);
+        }
+        if (cmd.IsRefresh()) {
+            RankNeedRefresh(cmd.Rank(), false);
+        }
+    } else {
+        bank_states_[BankIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank())]
+            .WarmUp(cmd);
+        if (cmd.IsRefresh()) {
+            BankNeedRefresh(cmd.Rank(), cmd.Bankgroup(), cmd.Bank(), false);
+        }
+    }
+    return;
+}
+
 void ChannelState::UpdateTiming(const Command& cmd, uint64_t clk) {
-    CommandType copy_type;
+    CommandType cmd_type = cmd.cmd_type;
     switch (cmd.cmd_type) {
         case CommandType::ACTIVATE:
             UpdateActivationTimes(cmd.Rank(), clk);
@@ -171,137 +302,127 @@ void ChannelState::UpdateTiming(const Command& cmd, uint64_t clk) {
         case CommandType::WRITE_PRECHARGE:
         case CommandType::PRECHARGE:
         case CommandType::REFRESH_BANK:
-            // TODO - simulator speed? - Speciazlize which of the below
-            // functions to call depending on the command type  Same Bank
-            UpdateSameBankTiming(
-                cmd.addr, timing_.same_bank[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Same Bankgroup other banks
-            UpdateOtherBanksSameBankgroupTiming(
-                cmd.addr,
-                timing_
-                    .other_banks_same_bankgroup[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Other bankgroups
-            UpdateOtherBankgroupsSameRankTiming(
-                cmd.addr,
-                timing_
-                    .other_bankgroups_same_rank[static_cast<int>(cmd.cmd_type)],
-                clk);
-
-            // Other ranks
-            UpdateOtherRanksTiming(
-                cmd.addr, timing_.other_ranks[static_cast<int>(cmd.cmd_type)],
-                clk);
             break;
         case CommandType::REFRESH:
         case CommandType::SREF_ENTER:
         case CommandType::SREF_EXIT:
-            UpdateSameRankTiming(
-                cmd.addr, timing_.same_rank[static_cast<int>(cmd.cmd_type)],
-                clk);
-            break;
+            if (lazy_timing_on_) {
+                lazy_timing_.Issue(cmd, cmd_type, clk);
+            }
+            UpdateScopeTiming(cmd.addr, cmd_type, TimingScope::SAME_RANK, clk);
+            return;
         case CommandType::READCOPY:
         case CommandType::READCOPY_PRECHARGE:
         case CommandType::WRITECOPY:
         case CommandType::WRITECOPY_PRECHARGE:
-            if((cmd.cmd_type == CommandType::READCOPY) && (cmd.isFPM)){copy_type = CommandType::READCOPY_FPM;}
-            else if((cmd.cmd_type == CommandType::READCOPY) && (!cmd.isFPM)){copy_type = CommandType::READCOPY_PSM;}
-            else if((cmd.cmd_type == CommandType::READCOPY_PRECHARGE) && (cmd.isFPM)){copy_type = CommandType::READCOPY_FPM;}
-            else if((cmd.cmd_type == CommandType::READCOPY_PRECHARGE) && (!cmd.isFPM)){copy_type = CommandType::READCOPY_PSM_PRECHARGE;}
-            else if((cmd.cmd_type == CommandType::WRITECOPY) && (cmd.isFPM)){copy_type = CommandType::WRITECOPY_FPM;}
-            else if((cmd.cmd_type == CommandType::WRITECOPY) && (!cmd.isFPM)){copy_type = CommandType::WRITECOPY_PSM;}
-            else if((cmd.cmd_type == CommandType::WRITECOPY_PRECHARGE) && (cmd.isFPM)){copy_type = CommandType::WRITECOPY_FPM_PRECHARGE;}
-            else {copy_type = CommandType::WRITECOPY_PSM_PRECHARGE;}
-            // Same Bank
-            UpdateSameBankTiming(cmd.addr, timing_.same_bank[static_cast<int>(copy_type)],clk);
-            // Same Bankgroup other banks
-            UpdateOtherBanksSameBankgroupTiming(cmd.addr,timing_.other_banks_same_bankgroup[static_cast<int>(copy_type)],clk);
-            // Other bankgroups
-            UpdateOtherBankgroupsSameRankTiming(cmd.addr,timing_.other_bankgroups_same_rank[static_cast<int>(copy_type)],clk);
-            // Other ranks
-            UpdateOtherRanksTiming(cmd.addr, timing_.other_ranks[static_cast<int>(copy_type)],clk);
+            cmd_type = CopyTimingType(cmd.cmd_type, cmd.isFPM);
             break;
         default:
             AbruptExit(__FILE__, __LINE__);
     }
-    return;
-}
-
-void ChannelState::UpdateSameBankTiming(
-    const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
-    uint64_t clk) {
-    for (auto cmd_timing : cmd_timing_list) {
-        bank_states_[addr.rank][addr.bankgroup][addr.bank].UpdateTiming(
-            cmd_timing.first, clk + cmd_timing.second);
+    if (lazy_timing_on_) {
+        lazy_timing_.Issue(cmd, cmd_type, clk);
     }
+    UpdateScopeTiming(cmd.addr, cmd_type, TimingScope::SAME_BANK, clk);
+    UpdateScopeTiming(cmd.addr, cmd_type,
+                      TimingScope::OTHER_BANKS_SAME_BANKGROUP, clk);
+    UpdateScopeTiming(cmd.addr, cmd_type,
+                      TimingScope::OTHER_BANKGROUPS_SAME_RANK, clk);
+    UpdateScopeTiming(cmd.addr, cmd_type, TimingScope::OTHER_RANKS, clk);
     return;
 }
 
-void ChannelState::UpdateOtherBanksSameBankgroupTiming(
-    const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
-    uint64_t clk) {
-    for (auto k = 0; k < config_.banks_per_group; k++) {
-        if (k != addr.bank) {
-            for (auto cmd_timing : cmd_timing_list) {
-                bank_states_[addr.rank][addr.bankgroup][k].UpdateTiming(
-                    cmd_timing.first, clk + cmd_timing.second);
-            }
+void ChannelState::UpdateScopeTiming(const Address& addr, CommandType cmd_type,
+                                     TimingScope scope, uint64_t clk) {
+    int row = static_cast<int>(cmd_type) * static_cast<int>(TimingScope::SIZE) +
+              static_cast<int>(scope);
+    if (!timing_table_on_ || !scope_has_timing_[row]) {
+        return;
+    }
+    const int64_t* delays = &timing_rows_[row * kTimingStride];
+    // the banks of a bankgroup, of a rank and of the channel are each one
+    // range of the table, so every scope is one or two ranges
+    int rank_first = addr.rank * config_.banks;
+    int rank_last = rank_first + config_.banks;
+    switch (scope) {
+        case TimingScope::SAME_BANK: {
+            int index = BankIndex(addr.rank, addr.bankgroup, addr.bank);
+            UpdateBanksTiming(index, index + 1, delays, clk);
+            break;
+        }
+        case TimingScope::OTHER_BANKS_SAME_BANKGROUP: {
+            int index = BankIndex(addr.rank, addr.bankgroup, addr.bank);
+            int bg_first = BankIndex(addr.rank, addr.bankgroup, 0);
+            UpdateBanksTiming(bg_first, index, delays, clk);
+            UpdateBanksTiming(index + 1, bg_first + config_.banks_per_group,
+                              delays, clk);
+            break;
+        }
+        case TimingScope::OTHER_BANKGROUPS_SAME_RANK: {
+            int bg_first = BankIndex(addr.rank, addr.bankgroup, 0);
+            UpdateBanksTiming(rank_first, bg_first, delays, clk);
+            UpdateBanksTiming(bg_first + config_.banks_per_group, rank_last,
+                              delays, clk);
+            break;
         }
+        case TimingScope::OTHER_RANKS:
+            UpdateBanksTiming(0, rank_first, delays, clk);
+            UpdateBanksTiming(rank_last, static_cast<int>(bank_states_.size()),
+                              delays, clk);
+            break;
+        case TimingScope::SAME_RANK:
+            UpdateBanksTiming(rank_first, rank_last, delays, clk);
+            break;
+        default:
+            AbruptExit(__FILE__, __LINE__);
     }
     return;
 }
 
-void ChannelState::UpdateOtherBankgroupsSameRankTiming(
-    const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
-    uint64_t clk) {
-    for (auto j = 0; j < config_.bankgroups; j++) {
-        if (j != addr.bankgroup) {
-            for (auto k = 0; k < config_.banks_per_group; k++) {
-                for (auto cmd_timing : cmd_timing_list) {
-                    bank_states_[addr.rank][j][k].UpdateTiming(
-                        cmd_timing.first, clk + cmd_timing.second);
-                }
-            }
-        }
-    }
+void ChannelState::UpdateBanksTiming(int first, int last,
+                                     const int64_t* delays, uint64_t clk) {
+    // cycles are far below 2^63, so the table can be compared as signed, and
+    // kNoTiming makes clk + delay negative, i.e. never the max
+    int64_t* timing = reinterpret_cast<int64_t*>(&cmd_timing_[0]);
+    MaxTimingRows(timing + first * kTimingStride, last - first, delays, clk);
     return;
 }
 
-void ChannelState::UpdateOtherRanksTiming(
-    const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
-    uint64_t clk) {
-    for (auto i = 0; i < config_.ranks; i++) {
-        if (i != addr.rank) {
-            for (auto j = 0; j < config_.bankgroups; j++) {
-                for (auto k = 0; k < config_.banks_per_group; k++) {
-                    for (auto cmd_timing : cmd_timing_list) {
-                        bank_states_[i][j][k].UpdateTiming(
-                            cmd_timing.first, clk + cmd_timing.second);
-                    }
-                }
-            }
+void MaxTimingRows(int64_t* rows, int num_rows, const int64_t* delays,
+                   uint64_t clk) {
+#ifdef __AVX2__
+    __m256i vclk = _mm256_set1_epi64x(static_cast<int64_t>(clk));
+    __m256i times[kTimingStride / 4];
+    for (int j = 0; j < kTimingStride / 4; j++) {
+        times[j] = _mm256_add_epi64(
+            vclk, _mm256_loadu_si256(
+                      reinterpret_cast<const __m256i*>(delays + j * 4)));
+    }
+    for (int i = 0; i < num_rows; i++) {
+        __m256i* row = reinterpret_cast<__m256i*>(rows + i * kTimingStride);
+        for (int j = 0; j < kTimingStride / 4; j++) {
+            __m256i old_times = _mm256_loadu_si256(row + j);
+            __m256i later = _mm256_cmpgt_epi64(times[j], old_times);
+            _mm256_storeu_si256(row + j,
+                                _mm256_blendv_epi8(old_times, times[j], later));
         }
     }
+#else
+    MaxTimingRowsScalar(rows, num_rows, delays, clk);
+#endif
     return;
 }
 
-void ChannelState::UpdateSameRankTiming(
-    const Address& addr,
-    const std::vector<std::pair<CommandType, int>>& cmd_timing_list,
-    uint64_t clk) {
-    for (auto j = 0; j < config_.bankgroups; j++) {
-        for (auto k = 0; k < config_.banks_per_group; k++) {
-            for (auto cmd_timing : cmd_timing_list) {
-                bank_states_[addr.rank][j][k].UpdateTiming(
-                    cmd_timing.first, clk + cmd_timing.second);
-            }
+void MaxTimingRowsScalar(int64_t* rows, int num_rows, const int64_t* delays,
+                         uint64_t clk) {
+    int64_t times[kTimingStride];
+    for (int j = 0; j < kTimingStride; j++) {
+        times[j] = static_cast<int64_t>(clk) + delays[j];
+    }
+    for (int i = 0; i < num_rows; i++) {
+        int64_t* row = rows + i * kTimingStride;
+        for (int j = 0; j < kTimingStride; j++) {
+            row[j] = std::max(row[j], times[j]);
         }
     }
     return;
@@ -313,49 +434,34 @@ void ChannelState::UpdateTimingAndStates(const Command& cmd, uint64_t clk) {
     return;
 }
 
-bool ChannelState::ActivationWindowOk(int rank, uint64_t curr_time) const {
-    bool tfaw_ok = IsFAWReady(rank, curr_time);
+uint64_t ChannelState::EarliestActivateCycle(int rank) const {
+    uint64_t earliest = four_aw_[rank].EarliestActivate();
     if (config_.IsGDDR()) {
-        if (!tfaw_ok)
-            return false;
-        else
-            return Is32AWReady(rank, curr_time);
+        earliest =
+            std::max(earliest, thirty_two_aw_[rank].EarliestActivate());
     }
-    return tfaw_ok;
+    return earliest;
 }
 
 void ChannelState::UpdateActivationTimes(int rank, uint64_t curr_time) {
-    if (!four_aw_[rank].empty() && curr_time >= four_aw_[rank][0]) {
-        four_aw_[rank].erase(four_aw_[rank].begin());
-    }
-    four_aw_[rank].push_back(curr_time + config_.tFAW);
+    four_aw_[rank].Activate(curr_time);
     if (config_.IsGDDR()) {
-        if (!thirty_two_aw_[rank].empty() &&
-            curr_time >= thirty_two_aw_[rank][0]) {
-            thirty_two_aw_[rank].erase(thirty_two_aw_[rank].begin());
-        }
-        thirty_two_aw_[rank].push_back(curr_time + config_.t32AW);
+        thirty_two_aw_[rank].Activate(curr_time);
     }
     return;
 }
 
-bool ChannelState::IsFAWReady(int rank, uint64_t curr_time) const {
-    if (!four_aw_[rank].empty()) {
-        if (curr_time < four_aw_[rank][0] && four_aw_[rank].size() >= 4) {
-            return false;
-        }
-    }
-    return true;
-}
-
-bool ChannelState::Is32AWReady(int rank, uint64_t curr_time) const {
-    if (!thirty_two_aw_[rank].empty()) {
-        if (curr_time < thirty_two_aw_[rank][0] &&
-            thirty_two_aw_[rank].size() >= 32) {
-            return false;
-        }
-    }
-    return true;
+void ChannelState::Serialize(Checkpoint& cp) {
+    cp.Field(rank_idle_cycles);
+    cp.Field(rank_is_sref_);
+    cp.Expect(cmd_timing_.size(), "timing table size");
+    cp.Expect(lazy_timing_on_, "lazy timing");
+    cp.Field(bank_states_);
+    cp.Field(cmd_timing_);
+    cp.Field(lazy_timing_);
+    cp.Field(refresh_q_);
+    cp.Field(four_aw_);
+    cp.Field(thirty_two_aw_);
 }
 
 }  // namespace dramsim3
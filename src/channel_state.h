@@ -3,23 +3,71 @@
 
 #include <vector>
 #include "bankstate.h"
+#include "checkpoint.h"
 #include "common.h"
 #include "configuration.h"
+#include "lazy_timing.h"
 #include "timing.h"
 
 namespace dramsim3 {
 
+// commands in a row of the timing table, CommandType::SIZE rounded up to
+// whole 256 bit vectors
+const int kTimingStride = (static_cast<int>(CommandType::SIZE) + 3) / 4 * 4;
+
+// Raise num_rows timing table rows to at least clk plus the delays of a
+// timing row, elementwise. Vectorized with AVX2 when built with it, the
+// scalar version is what it has to match
+void MaxTimingRows(int64_t* rows, int num_rows, const int64_t* delays,
+                   uint64_t clk);
+void MaxTimingRowsScalar(int64_t* rows, int num_rows, const int64_t* delays,
+                         uint64_t clk);
+
+// The last few activations of a rank (4 for tFAW, 32 for t32AW) as the
+// cycles they leave the window, in a fixed ring with the oldest at head_.
+// Another activation is allowed once the oldest one has left
+class ActivationWindow {
+   public:
+    ActivationWindow() : window_(0), head_(0) {}
+    ActivationWindow(int activations, int window)
+        : window_(window), head_(0), leave_(activations, 0) {}
+    void Activate(uint64_t clk) {
+        leave_[head_] = clk + window_;
+        head_ = head_ + 1 == static_cast<int>(leave_.size()) ? 0 : head_ + 1;
+    }
+    uint64_t EarliestActivate() const { return leave_[head_]; }
+
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp) {
+        cp.Field(head_);
+        cp.Field(leave_);
+    }
+
+   private:
+    int window_;
+    int head_;
+    std::vector<uint64_t> leave_;
+};
+
 class ChannelState {
    public:
     ChannelState(const Config& config, const Timing& timing);
     Command GetReadyCommand(const Command& cmd, uint64_t clk) const;
+    uint64_t EarliestReadyCycle(const Command& cmd) const;
     void UpdateState(const Command& cmd);
     void UpdateTiming(const Command& cmd, uint64_t clk);
     void UpdateTimingAndStates(const Command& cmd, uint64_t clk);
-    bool ActivationWindowOk(int rank, uint64_t curr_time) const;
+    // functional warm-up, see BankState::WarmUp. A refresh is taken off the
+    // refresh queue as done
+    void WarmUp(const Command& cmd);
+    bool ActivationWindowOk(int rank, uint64_t curr_time) const {
+        return curr_time >= EarliestActivateCycle(rank);
+    }
+    // first cycle tFAW (and t32AW) allow another activation in the rank
+    uint64_t EarliestActivateCycle(int rank) const;
     void UpdateActivationTimes(int rank, uint64_t curr_time);
     bool IsRowOpen(int rank, int bankgroup, int bank) const {
-        return bank_states_[rank][bankgroup][bank].IsRowOpen();
+        return bank_states_[BankIndex(rank, bankgroup, bank)].IsRowOpen();
     }
     bool IsAllBankIdleInRank(int rank) const;
     bool IsRankSelfRefreshing(int rank) const { return rank_is_sref_[rank]; }
@@ -28,16 +76,22 @@ class ChannelState {
     const Command& PendingRefCommand() const {return refresh_q_.front(); }
     void BankNeedRefresh(int rank, int bankgroup, int bank, bool need);
     void RankNeedRefresh(int rank, bool need);
+    // whether a refresh of the bank, or of the rank with bankgroup and bank
+    // -1, is waiting
+    bool IsRefreshQueued(int rank, int bankgroup, int bank) const;
     int OpenRow(int rank, int bankgroup, int bank) const {
-        return bank_states_[rank][bankgroup][bank].OpenRow();
+        return bank_states_[BankIndex(rank, bankgroup, bank)].OpenRow();
     }
     int RowHitCount(int rank, int bankgroup, int bank) const {
-        return bank_states_[rank][bankgroup][bank].RowHitCount();
+        return bank_states_[BankIndex(rank, bankgroup, bank)].RowHitCount();
     };
 
     // Rowclone added
     bool CanStartWait(const Command& cmd, uint64_t clk) const;
 
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
     std::vector<int> rank_idle_cycles;
 
    private:
@@ -45,43 +99,52 @@ class ChannelState {
     const Timing& timing_;
 
     std::vector<bool> rank_is_sref_;
-    std::vector<std::vector<std::vector<BankState> > > bank_states_;
+    // all banks of the channel, rank major, bank (bankgroup * banks_per_group
+    // + bank) within the rank
+    std::vector<BankState> bank_states_;
+    // the timing table, [rank][bank][command] in the same bank order: the
+    // earliest cycle each command can be issued to each bank. A bank's row is
+    // kTimingStride long so rows stay whole vectors
+    std::vector<uint64_t> cmd_timing_;
     std::vector<Command> refresh_q_;
 
-    std::vector<std::vector<uint64_t> > four_aw_;
-    std::vector<std::vector<uint64_t> > thirty_two_aw_;
-    bool IsFAWReady(int rank, uint64_t curr_time) const;
-    bool Is32AWReady(int rank, uint64_t curr_time) const;
-    // Update timing of the bank the command corresponds to
-    void UpdateSameBankTiming(
-        const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
-        uint64_t clk);
-
-    // Update timing of the other banks in the same bankgroup as the command
-    void UpdateOtherBanksSameBankgroupTiming(
-        const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
-        uint64_t clk);
-
-    // Update timing of banks in the same rank but different bankgroup as the
-    // command
-    void UpdateOtherBankgroupsSameRankTiming(
-        const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
-        uint64_t clk);
-
-    // Update timing of banks in a different rank as the command
-    void UpdateOtherRanksTiming(
-        const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
-        uint64_t clk);
-
-    // Update timing of the entire rank (for rank level commands)
-    void UpdateSameRankTiming(
-        const Address& addr,
-        const std::vector<std::pair<CommandType, int> >& cmd_timing_list,
-        uint64_t clk);
+    std::vector<ActivationWindow> four_aw_;
+    std::vector<ActivationWindow> thirty_two_aw_;
+
+    // The Timing lists as dense rows, [command][scope][command], of the delay
+    // after the first command before the second one can be issued, and
+    // kNoTiming where there is no such constraint
+    std::vector<int64_t> timing_rows_;
+    // whether the scope of a command constrains anything at all
+    std::vector<bool> scope_has_timing_;
+
+    // the timing engines kept up to date, see Config::timing_engine: the
+    // table above, LazyTiming or both, cross checked
+    bool timing_table_on_;
+    bool lazy_timing_on_;
+    LazyTiming lazy_timing_;
+
+    // earliest cycle ready_cmd, a command RequiredCommand gave for the bank,
+    // can be issued to it
+    uint64_t BankReadyCycle(int rank, int bankgroup, int bank,
+                            const Command& ready_cmd) const;
+    uint64_t BankEarliestReadyCycle(int rank, int bankgroup, int bank,
+                                    const Command& cmd) const;
+
+    int BankIndex(int rank, int bankgroup, int bank) const {
+        return (rank * config_.bankgroups + bankgroup) *
+                   config_.banks_per_group +
+               bank;
+    }
+    void BuildTimingRows(TimingScope scope);
+    // Update the timing of the banks the scope covers for a command of
+    // timing type cmd_type (see CopyTimingType) issued to addr at clk
+    void UpdateScopeTiming(const Address& addr, CommandType cmd_type,
+                           TimingScope scope, uint64_t clk);
+    // Raise the timing of banks [first, last) to at least clk plus the delays
+    // of a timing row
+    void UpdateBanksTiming(int first, int last, const int64_t* delays,
+                           uint64_t clk);
 };
 
 }  // namespace dramsim3
@@ -0,0 +1,177 @@
+#include "channel_workers.h"
+#include <algorithm>
+
+namespace dramsim3 {
+
+ChannelWorkers::ChannelWorkers(const Config& config,
+                               const std::vector<Controller*>& ctrls)
+    : config_(config),
+      ctrls_(ctrls),
+      channels_(ctrls.size()),
+      num_threads_(std::min(config.channel_threads,
+                            static_cast<int>(ctrls.size()))),
+      generation_(0),
+      busy_workers_(0),
+      target_clk_(0),
+      stop_(false) {
+    for (auto& work : channels_) {
+        work.clk = 0;
+        work.next_arrival = 0;
+    }
+    for (int i = 1; i < num_threads_; i++) {
+        workers_.emplace_back(&ChannelWorkers::WorkerLoop, this, i);
+    }
+}
+
+ChannelWorkers::~ChannelWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+bool ChannelWorkers::WillAcceptTransaction(int channel, AddressPair hex_addr,
+                                           bool is_write, uint64_t clk) {
+    auto& work = channels_[channel];
+    auto ctrl = ctrls_[channel];
+    // transaction queues only drain between arrivals, so if there's room
+    // for everything still to arrive there's room at clk as well
+    size_t in_flight = work.arrivals.size() - work.next_arrival;
+    if (ctrl->WillAcceptTransaction(hex_addr, is_write, in_flight)) {
+        return true;
+    }
+    Advance(channel, clk);
+    return ctrl->WillAcceptTransaction(hex_addr, is_write);
+}
+
+void ChannelWorkers::AddTransaction(int channel, const Transaction& trans,
+                                    uint64_t clk) {
+    auto& work = channels_[channel];
+    if (work.clk == clk) {
+        ctrls_[channel]->AddTransaction(trans);
+    } else {
+        work.arrivals.emplace_back(clk, trans);
+    }
+}
+
+const std::vector<Transaction>& ChannelWorkers::Sync(uint64_t clk) {
+    if (num_threads_ > 1) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            target_clk_ = clk;
+            busy_workers_ = num_threads_ - 1;
+            generation_++;
+        }
+        start_cv_.notify_all();
+        AdvanceShare(0, clk);
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return busy_workers_ == 0; });
+    } else {
+        AdvanceShare(0, clk);
+    }
+
+    // channel by channel and then a stable sort on the cycle is exactly the
+    // order the serial ClockTick returns them in
+    merged_.clear();
+    for (auto& work : channels_) {
+        merged_.insert(merged_.end(), work.done.begin(), work.done.end());
+        work.done.clear();
+    }
+    std::stable_sort(merged_.begin(), merged_.end(),
+                     [](const std::pair<uint64_t, Transaction>& a,
+                        const std::pair<uint64_t, Transaction>& b) {
+                         return a.first < b.first;
+                     });
+    done_.clear();
+    for (const auto& clk_trans : merged_) {
+        done_.push_back(clk_trans.second);
+    }
+    return done_;
+}
+
+void ChannelWorkers::Restart(uint64_t clk) {
+    for (auto& work : channels_) {
+        work.clk = clk;
+        work.arrivals.clear();
+        work.next_arrival = 0;
+        work.done.clear();
+    }
+    return;
+}
+
+void ChannelWorkers::Advance(int channel, uint64_t clk) {
+    auto& work = channels_[channel];
+    auto ctrl = ctrls_[channel];
+    auto& arrivals = work.arrivals;
+    while (true) {
+        // arrivals go in before the cycle is simulated, same as the
+        // front end adding them in between two ClockTicks
+        while (work.next_arrival < arrivals.size() &&
+               arrivals[work.next_arrival].first == work.clk) {
+            ctrl->AddTransaction(arrivals[work.next_arrival].second);
+            work.next_arrival++;
+        }
+        if (work.clk >= clk) {
+            break;
+        }
+        if (config_.enable_skip_ahead) {
+            uint64_t next_clk = std::min(ctrl->NextEventCycle(), clk);
+            if (work.next_arrival < arrivals.size()) {
+                next_clk =
+                    std::min(next_clk, arrivals[work.next_arrival].first);
+            }
+            if (next_clk > work.clk) {
+                ctrl->SkipCycles(next_clk - work.clk);
+                work.clk = next_clk;
+                continue;
+            }
+        }
+        for (const auto& trans : ctrl->ReturnDoneTrans(work.clk)) {
+            work.done.emplace_back(work.clk, trans);
+        }
+        ctrl->ClockTick();
+        work.clk++;
+    }
+    if (work.next_arrival == arrivals.size()) {
+        arrivals.clear();
+        work.next_arrival = 0;
+    }
+    return;
+}
+
+void ChannelWorkers::AdvanceShare(int thread_id, uint64_t clk) {
+    for (size_t i = thread_id; i < channels_.size(); i += num_threads_) {
+        Advance(i, clk);
+    }
+    return;
+}
+
+void ChannelWorkers::WorkerLoop(int thread_id) {
+    uint64_t generation = 0;
+    while (true) {
+        uint64_t clk;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [this, generation] {
+                return stop_ || generation_ != generation;
+            });
+            if (stop_) {
+                return;
+            }
+            generation = generation_;
+            clk = target_clk_;
+        }
+        AdvanceShare(thread_id, clk);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            busy_workers_--;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,77 @@
+#ifndef __CHANNEL_WORKERS_H
+#define __CHANNEL_WORKERS_H
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "common.h"
+#include "configuration.h"
+#include "controller.h"
+
+namespace dramsim3 {
+
+// Runs the controllers of a memory system on channel_threads threads.
+// Channels don't interact once a transaction is routed to them, so each
+// channel only has to be brought up to the system clock every sync_quantum
+// cycles, or sooner when the front end needs an exact answer from it.
+// Transactions added in between are replayed in the cycle they arrived in,
+// which keeps every channel cycle for cycle the same as in a serial run.
+// Completions only come back at the syncs though, so a front end that
+// waits on them sends its next requests later than in a serial run and
+// takes a different path, unless it syncs every cycle, see
+// BaseDRAMSystem::SetClosedLoop.
+class ChannelWorkers {
+   public:
+    ChannelWorkers(const Config& config, const std::vector<Controller*>& ctrls);
+    ~ChannelWorkers();
+    // exact answer for the channel at clk, only brings the channel up to
+    // clk when its lagging queues are too full to tell
+    bool WillAcceptTransaction(int channel, AddressPair hex_addr,
+                               bool is_write, uint64_t clk);
+    // transaction arriving at the channel at clk
+    void AddTransaction(int channel, const Transaction& trans, uint64_t clk);
+    // brings every channel up to clk, and returns what they completed since
+    // the last sync in the (cycle, channel) order a serial run returns
+    // them, valid until the next call
+    const std::vector<Transaction>& Sync(uint64_t clk);
+    // the controllers were restored to clk from a checkpoint
+    void Restart(uint64_t clk);
+
+   private:
+    struct ChannelWork {
+        // every cycle before this has been simulated
+        uint64_t clk;
+        // transactions and the cycle they arrive in, oldest first
+        std::vector<std::pair<uint64_t, Transaction>> arrivals;
+        size_t next_arrival;
+        // completed transactions and the cycle they are returned in
+        std::vector<std::pair<uint64_t, Transaction>> done;
+    };
+
+    const Config& config_;
+    const std::vector<Controller*>& ctrls_;
+    std::vector<ChannelWork> channels_;
+    std::vector<std::pair<uint64_t, Transaction>> merged_;
+    std::vector<Transaction> done_;
+
+    // the calling thread takes the first share of channels, workers the rest
+    int num_threads_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    uint64_t generation_;
+    int busy_workers_;
+    uint64_t target_clk_;
+    bool stop_;
+
+    void Advance(int channel, uint64_t clk);
+    void AdvanceShare(int thread_id, uint64_t clk);
+    void WorkerLoop(int thread_id);
+};
+
+}  // namespace dramsim3
+
+#endif
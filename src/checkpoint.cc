@@ -0,0 +1,204 @@
+#include "checkpoint.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace dramsim3 {
+
+namespace {
+const char kMagic[7] = {'D', 'S', '3', 'C', 'K', 'P', 'T'};
+const uint8_t kVersion = 5;
+}  // namespace
+
+Checkpoint::Checkpoint(const std::string& file_name, bool save)
+    : file_name_(file_name), save_(save), closed_(false), pos_(0) {
+    if (save_) {
+        buffer_.assign(kMagic, sizeof(kMagic));
+        buffer_.push_back(static_cast<char>(kVersion));
+        return;
+    }
+    std::ifstream file(file_name, std::ifstream::binary);
+    if (file.fail()) {
+        std::cerr << "Checkpoint file " << file_name << " does not exist"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+    if (buffer_.size() < sizeof(kMagic) + 1 ||
+        buffer_.compare(0, sizeof(kMagic), kMagic, sizeof(kMagic)) != 0 ||
+        static_cast<uint8_t>(buffer_[sizeof(kMagic)]) != kVersion) {
+        std::cerr << file_name << " is not a checkpoint" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    pos_ = sizeof(kMagic) + 1;
+}
+
+Checkpoint::~Checkpoint() {
+    if (!closed_) {
+        Close();
+    }
+}
+
+void Checkpoint::Close() {
+    closed_ = true;
+    if (!save_) {
+        if (pos_ != buffer_.size()) {
+            std::cerr << file_name_ << " has more in it than was restored"
+                      << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        return;
+    }
+    std::ofstream file(file_name_, std::ofstream::binary);
+    file.write(buffer_.data(), buffer_.size());
+    if (file.fail()) {
+        std::cerr << "Cannot write checkpoint " << file_name_ << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+}
+
+void Checkpoint::Expect(uint64_t value, const std::string& what) {
+    uint64_t saved = value;
+    Field(saved);
+    if (saved != value) {
+        std::cerr << file_name_ << " was saved with " << what << " " << saved
+                  << ", not " << value << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+}
+
+void Checkpoint::Field(bool& value) {
+    uint8_t code = value;
+    Field(code);
+    value = code != 0;
+}
+
+void Checkpoint::Field(double& value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    if (save_) {
+        for (int i = 0; i < 8; i++) {
+            buffer_.push_back(static_cast<char>(bits >> (8 * i)));
+        }
+    } else {
+        if (buffer_.size() - pos_ < 8) {
+            Truncated();
+        }
+        bits = 0;
+        for (int i = 0; i < 8; i++) {
+            bits |= static_cast<uint64_t>(static_cast<uint8_t>(buffer_[pos_++]))
+                    << (8 * i);
+        }
+        std::memcpy(&value, &bits, sizeof(bits));
+    }
+}
+
+void Checkpoint::Field(std::string& value) {
+    uint64_t size = value.size();
+    Field(size);
+    if (save_) {
+        buffer_.append(value);
+    } else {
+        if (size > buffer_.size() - pos_) {
+            Truncated();
+        }
+        value.assign(buffer_, pos_, size);
+        pos_ += size;
+    }
+}
+
+void Checkpoint::Field(std::vector<bool>& value) {
+    uint64_t size = value.size();
+    Field(size);
+    if (!save_) {
+        if (size > (buffer_.size() - pos_) * 8) {
+            Truncated();
+        }
+        value.assign(size, false);
+    }
+    // eight to a byte
+    for (uint64_t i = 0; i < size; i += 8) {
+        uint8_t bits = 0;
+        for (uint64_t j = i; j < std::min(i + 8, size); j++) {
+            bits |= static_cast<uint8_t>(value[j]) << (j - i);
+        }
+        Field(bits);
+        for (uint64_t j = i; j < std::min(i + 8, size); j++) {
+            value[j] = (bits >> (j - i)) & 1;
+        }
+    }
+}
+
+void Checkpoint::Field(AddressPair& addr) {
+    Field(addr.src_addr);
+    Field(addr.dest_addr);
+    Field(addr.is_copy);
+}
+
+void Checkpoint::Field(Address& addr) {
+    Field(addr.channel);
+    Field(addr.rank);
+    Field(addr.bankgroup);
+    Field(addr.bank);
+    Field(addr.row);
+    Field(addr.column);
+}
+
+void Checkpoint::Field(Command& cmd) {
+    Field(cmd.cmd_type);
+    Field(cmd.addr);
+    Field(cmd.hex_addr);
+    Field(cmd.isFPM);
+    Field(cmd.dest_address);
+    Field(cmd.source_id);
+    Field(cmd.added_cycle);
+    Field(cmd.marked);
+}
+
+void Checkpoint::Field(Transaction& trans) {
+    Field(trans.addr);
+    Field(trans.added_cycle);
+    Field(trans.complete_cycle);
+    Field(trans.is_write);
+    Field(trans.is_copy);
+    Field(trans.src_address);
+    Field(trans.dest_address);
+    Field(trans.source_id);
+    Field(trans.req_id);
+}
+
+void Checkpoint::Field(Completion& completion) {
+    Field(completion.req_id);
+    Field(completion.hex_addr);
+    Field(completion.is_write);
+}
+
+void Checkpoint::PutVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer_.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer_.push_back(static_cast<char>(value));
+}
+
+uint64_t Checkpoint::GetVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; pos_ < buffer_.size() && shift < 64; shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(buffer_[pos_++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return value;
+        }
+    }
+    Truncated();
+    return 0;
+}
+
+void Checkpoint::Truncated() {
+    std::cerr << file_name_ << " is truncated or corrupted" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,162 @@
+#ifndef __CHECKPOINT_H
+#define __CHECKPOINT_H
+
+#include <cstring>
+#include <deque>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "common.h"
+
+namespace dramsim3 {
+
+// Binary checkpoint of the simulator state. Every class with state has a
+// Serialize(Checkpoint&) that hands its members to Field one by one, the
+// same code writes them out when saving and reads them back in the same
+// order when restoring. The file is the magic "DS3CKPT", a u8 version and
+// then the fields: integers and enums as (zigzag) varints, doubles as their
+// 8 bytes, containers as their size followed by the elements
+class Checkpoint {
+   public:
+    Checkpoint(const std::string& file_name, bool save);
+    ~Checkpoint();
+    bool IsSaving() const { return save_; }
+    // writes the file when saving, and makes sure everything was read when
+    // restoring
+    void Close();
+
+    // for what has to be the same in the simulator restoring the checkpoint
+    // as in the one that saved it, e.g. the number of banks
+    void Expect(uint64_t value, const std::string& what);
+
+    template <class T>
+    typename std::enable_if<std::is_integral<T>::value>::type Field(T& value) {
+        typedef typename std::make_unsigned<T>::type U;
+        if (save_) {
+            U code = static_cast<U>(value);
+            if (std::is_signed<T>::value) {
+                code = (code << 1) ^ (0 - (code >> (sizeof(U) * 8 - 1)));
+            }
+            PutVarint(code);
+        } else {
+            U code = static_cast<U>(GetVarint());
+            if (std::is_signed<T>::value) {
+                code = (code >> 1) ^ (0 - (code & 1));
+            }
+            value = static_cast<T>(code);
+        }
+    }
+
+    template <class T>
+    typename std::enable_if<std::is_enum<T>::value>::type Field(T& value) {
+        int code = static_cast<int>(value);
+        Field(code);
+        value = static_cast<T>(code);
+    }
+
+    void Field(bool& value);
+    void Field(double& value);
+
+    // anything with a Serialize of its own
+    template <class T>
+    auto Field(T& value) -> decltype(value.Serialize(*this), void()) {
+        value.Serialize(*this);
+    }
+
+    void Field(std::string& value);
+    void Field(std::vector<bool>& value);
+    void Field(AddressPair& addr);
+    void Field(Address& addr);
+    void Field(Command& cmd);
+    void Field(Transaction& trans);
+    void Field(Completion& completion);
+
+    template <class A, class B>
+    void Field(std::pair<A, B>& value) {
+        Field(value.first);
+        Field(value.second);
+    }
+
+    template <class T>
+    void Field(std::vector<T>& values) {
+        FieldSequence(values);
+    }
+
+    template <class T>
+    void Field(std::deque<T>& values) {
+        FieldSequence(values);
+    }
+
+    template <class K, class V>
+    void Field(std::unordered_map<K, V>& values) {
+        uint64_t size = values.size();
+        Field(size);
+        if (save_) {
+            for (auto& it : values) {
+                K key = it.first;
+                Field(key);
+                Field(it.second);
+            }
+        } else {
+            values.clear();
+            for (uint64_t i = 0; i < size; i++) {
+                K key{};
+                V value{};
+                Field(key);
+                Field(value);
+                values.emplace(key, value);
+            }
+        }
+    }
+
+    template <class K>
+    void Field(std::unordered_set<K>& values) {
+        uint64_t size = values.size();
+        Field(size);
+        if (save_) {
+            for (K key : values) {
+                Field(key);
+            }
+        } else {
+            values.clear();
+            for (uint64_t i = 0; i < size; i++) {
+                K key{};
+                Field(key);
+                values.insert(key);
+            }
+        }
+    }
+
+   private:
+    std::string file_name_;
+    bool save_;
+    bool closed_;
+    std::string buffer_;
+    size_t pos_;
+
+    void PutVarint(uint64_t value);
+    uint64_t GetVarint();
+    void Truncated();
+
+    template <class Seq>
+    void FieldSequence(Seq& values) {
+        uint64_t size = values.size();
+        Field(size);
+        if (!save_) {
+            // every element takes at least a byte
+            if (size > buffer_.size() - pos_) {
+                Truncated();
+            }
+            values.resize(size);
+        }
+        for (auto& value : values) {
+            Field(value);
+        }
+    }
+};
+
+}  // namespace dramsim3
+#endif
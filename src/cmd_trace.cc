@@ -0,0 +1,117 @@
+#include "cmd_trace.h"
+#include <chrono>
+#include <iostream>
+
+namespace dramsim3 {
+
+namespace {
+// parses a comma separated list of integers in [0, size) into a filter
+std::vector<bool> ParseFilter(const std::string& list, int size) {
+    std::vector<bool> filter;
+    for (const auto& item : StringSplit(list, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        int index = std::stoi(item);
+        if (index < 0 || index >= size) {
+            std::cerr << "cmd_trace filter value " << index
+                      << " out of range" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        filter.resize(size, false);
+        filter[index] = true;
+    }
+    return filter;
+}
+}  // namespace
+
+CommandTracer::CommandTracer(const Config& config)
+    : config_(config), stop_(false), dropped_(0) {
+    for (int i = 0; i < config_.channels; i++) {
+        rings_.emplace_back(new CommandRing(config_.cmd_trace_buffer));
+    }
+
+    // command types are given by the names they are printed with
+    for (const auto& name : StringSplit(config_.cmd_trace_types, ',')) {
+        if (name.empty()) {
+            continue;
+        }
+        int num_types = static_cast<int>(CommandType::SIZE);
+        cmd_types_.resize(num_types, false);
+        int i = 0;
+        while (i < num_types &&
+               CommandTypeName(static_cast<CommandType>(i)) != name) {
+            i++;
+        }
+        if (i == num_types) {
+            std::cerr << "Unknown command type " << name << " in cmd_trace_types"
+                      << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        cmd_types_[i] = true;
+    }
+    ranks_ = ParseFilter(config_.cmd_trace_ranks, config_.ranks);
+    banks_ = ParseFilter(config_.cmd_trace_banks, config_.banks);
+
+    std::string trace_file_name = config_.output_prefix + "cmd.trace";
+    std::cout << "Command Trace write to " << trace_file_name << std::endl;
+    trace_out_.open(trace_file_name, std::ofstream::out | std::ofstream::binary);
+    const char magic[8] = {'D', 'S', '3', 'C', 'M', 'D', 'T', 'R'};
+    uint32_t header[2] = {1, static_cast<uint32_t>(sizeof(CommandRecord))};
+    trace_out_.write(magic, sizeof(magic));
+    trace_out_.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    writer_ = std::thread(&CommandTracer::WriterLoop, this);
+}
+
+CommandTracer::~CommandTracer() {
+    stop_.store(true, std::memory_order_release);
+    writer_.join();
+    trace_out_.close();
+    if (dropped_ > 0) {
+        std::cerr << "WARNING: " << dropped_
+                  << " commands dropped from the command trace, consider a "
+                     "larger cmd_trace_buffer"
+                  << std::endl;
+    }
+}
+
+bool CommandTracer::IsTraced(const Command& cmd) const {
+    if (!cmd_types_.empty() && !cmd_types_[static_cast<int>(cmd.cmd_type)]) {
+        return false;
+    }
+    // commands that don't go to a particular rank or bank aren't filtered
+    if (!ranks_.empty() && cmd.Rank() >= 0 && !ranks_[cmd.Rank()]) {
+        return false;
+    }
+    if (!banks_.empty() && cmd.Bankgroup() >= 0 && cmd.Bank() >= 0) {
+        int bank = cmd.Bankgroup() * config_.banks_per_group + cmd.Bank();
+        if (!banks_[bank]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CommandTracer::WriterLoop() {
+    std::vector<CommandRecord> records(4096);
+    while (true) {
+        // anything pushed before stop_ is set is drained after seeing it
+        bool stopping = stop_.load(std::memory_order_acquire);
+        size_t num_records = 0;
+        for (auto& ring : rings_) {
+            size_t n = ring->Pop(records.data(), records.size());
+            trace_out_.write(reinterpret_cast<const char*>(records.data()),
+                             n * sizeof(CommandRecord));
+            num_records += n;
+        }
+        if (num_records == 0) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+}  // namespace dramsim3
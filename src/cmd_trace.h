@@ -0,0 +1,86 @@
+#ifndef __CMD_TRACE_H
+#define __CMD_TRACE_H
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "common.h"
+#include "configuration.h"
+#include "spsc_ring.h"
+
+namespace dramsim3 {
+
+// One fixed size record per traced command, written out as is.
+// scripts/decode_cmd_trace.py turns the file back into text
+struct CommandRecord {
+    uint64_t clk;
+    uint64_t src_addr;
+    uint64_t dest_addr;
+    int32_t row;
+    int32_t column;
+    // channel the command is issued on, refresh commands don't carry one
+    uint16_t channel;
+    uint8_t cmd_type;
+    // -1 for commands that don't go to a particular rank, bank group or bank
+    int8_t rank;
+    int8_t bankgroup;
+    int8_t bank;
+    uint8_t is_fpm;
+    uint8_t reserved;
+};
+
+// the simulation thread pushes and the writer thread pops
+typedef SPSCRing<CommandRecord> CommandRing;
+
+// Binary command trace, enabled with cmd_trace in the [other] section.
+// Every channel logs into its own ring and a background thread drains
+// all of them into one file, so tracing never blocks the simulation. When
+// a ring is full the record is dropped and counted instead.
+class CommandTracer {
+   public:
+    CommandTracer(const Config& config);
+    ~CommandTracer();
+    void Record(int channel, uint64_t clk, const Command& cmd) {
+        if (!IsTraced(cmd)) {
+            return;
+        }
+        CommandRecord record;
+        record.clk = clk;
+        record.src_addr = cmd.hex_addr.src_addr;
+        record.dest_addr = cmd.hex_addr.dest_addr;
+        record.row = cmd.Row();
+        record.column = cmd.Column();
+        record.channel = static_cast<uint16_t>(channel);
+        record.cmd_type = static_cast<uint8_t>(cmd.cmd_type);
+        record.rank = static_cast<int8_t>(cmd.Rank());
+        record.bankgroup = static_cast<int8_t>(cmd.Bankgroup());
+        record.bank = static_cast<int8_t>(cmd.Bank());
+        record.is_fpm = (cmd.IsReadCopy() || cmd.IsWriteCopy()) && cmd.isFPM;
+        record.reserved = 0;
+        if (!rings_[channel]->Push(record)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+   private:
+    const Config& config_;
+    std::vector<std::unique_ptr<CommandRing>> rings_;
+    std::ofstream trace_out_;
+    std::thread writer_;
+    std::atomic<bool> stop_;
+    // channels may be simulated on different threads
+    std::atomic<uint64_t> dropped_;
+
+    // filters, empty means everything passes
+    std::vector<bool> cmd_types_;
+    std::vector<bool> ranks_;
+    std::vector<bool> banks_;
+
+    bool IsTraced(const Command& cmd) const;
+    void WriterLoop();
+};
+
+}  // namespace dramsim3
+#endif
@@ -1,4 +1,5 @@
 #include "command_queue.h"
+#include <limits>
 
 namespace dramsim3 {
 
@@ -9,6 +10,11 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
       config_(config),
       channel_state_(channel_state),
       simple_stats_(simple_stats),
+      scheduler_(GetSchedulerType(config.scheduler)),
+      frfcfs_(config),
+      parbs_(config),
+      atlas_(config),
+      bliss_(config),
       is_in_ref_(false),
       queue_size_(static_cast<size_t>(config_.cmd_queue_size)),
       queue_idx_(0),
@@ -33,60 +39,132 @@ CommandQueue::CommandQueue(int channel_id, const Config& config,
         cmd_queue.reserve(config_.cmd_queue_size);
         queues_.push_back(cmd_queue);
     }
+    ready_mask_.resize((num_queues_ + 63) / 64, 0);
+    queue_ready_clk_.resize(num_queues_, std::numeric_limits<uint64_t>::max());
     // init rank_state_ : size (# of ranks) : value (false)
     rank_state_.assign(config_.ranks, false);
     rank_address_pair_.assign(config_.ranks, AddressPair());
 }
 
 Command CommandQueue::GetCommandToIssue() {
-    for (int i = 0; i < num_queues_; i++) {
+    // one switch per pick, the policy calls inline from here on
+    switch (scheduler_) {
+        case SchedulerType::PARBS:
+            return GetCommandToIssue(parbs_);
+        case SchedulerType::ATLAS:
+            return GetCommandToIssue(atlas_);
+        case SchedulerType::BLISS:
+            return GetCommandToIssue(bliss_);
+        default:
+            return GetCommandToIssue(frfcfs_);
+    }
+}
 
-        auto& queue = GetNextQueue();
-        //std::cout<< queue_idx_ <<"th queue ";
+template <class Policy>
+Command CommandQueue::GetCommandToIssue(Policy& policy) {
+    policy.Prepare(queues_, clk_);
+
+    // round robin from the queue after the last one issued from, skipping
+    // the queues that can't have anything ready. First ready policies take
+    // the first command found, the others look at every queue and keep the
+    // highest priority, ties going to the earliest in round robin order
+    int start_idx = queue_idx_ + 1 < num_queues_ ? queue_idx_ + 1 : 0;
+    int q_idx = NextReadyQueue(start_idx);
+    bool wrapped = false;
+    Command best_cmd;
+    CommandType best_queued_type = CommandType::SIZE;
+    uint64_t best_priority = 0;
+    int best_idx = -1;
+    while (true) {
+        if (q_idx == num_queues_) {
+            if (wrapped) {
+                break;
+            }
+            wrapped = true;
+            q_idx = NextReadyQueue(0);
+            continue;
+        }
+        if (wrapped && q_idx >= start_idx) {
+            break;
+        }
+        int next_idx = NextReadyQueue(q_idx + 1);
+        int cur_idx = q_idx;
+        auto& queue = queues_[q_idx];
+        q_idx = next_idx;
 
         // if we're refresing, skip the command queues that are involved
         if (is_in_ref_) {
-            if (ref_q_indices_.find(queue_idx_) != ref_q_indices_.end()) {
+            if (ref_q_indices_.find(cur_idx) != ref_q_indices_.end()) {
                 continue;
             }
         }
-        
-        auto cmd = GetFirstReadyInQueue(queue);
-        //std::cout<<"get command"<<std::endl;
-
-        // --------------------------------------------------------------------------
-        // RowClone added
-        // If READCOPY is going to be issued, force to find pair WRITECOPY in next for loop
-
-        if(cmd.cmd_type == CommandType::READCOPY){
-            is_in_copy_ = true;
-            copy_address_pair_ = cmd.hex_addr;
-            auto addr = config_.AddressMapping(cmd.hex_addr.dest_addr);
-            queue_idx_ = GetQueueIndex(addr.rank, addr.bankgroup, addr.bank) - 1;
-            // make write bank wait
+
+        CommandType queued_type;
+        uint64_t priority;
+        auto cmd = GetFirstReadyInQueue(queue, policy, queued_type, priority);
+        if (!cmd.IsValid()) {
+            UpdateQueueReadyClk(cur_idx);
+            continue;
         }
+        if (best_idx < 0 || priority > best_priority) {
+            best_cmd = cmd;
+            best_queued_type = queued_type;
+            best_priority = priority;
+            best_idx = cur_idx;
+            if (Policy::kFirstReady) {
+                break;
+            }
+        }
+    }
+    if (best_idx < 0) {
+        // nothing issued, the scan went all the way round
+        queue_idx_ = start_idx == 0 ? num_queues_ - 1 : start_idx - 1;
+        return Command();
+    }
 
-        // ---------------------------------------------------------------------------
+    auto& cmd = best_cmd;
+    queue_idx_ = best_idx;
+    CommandPicked(cmd, best_queued_type);
 
-        //std::cout << std::hex << "Issued : " << cmd.hex_addr.src_addr << " " << cmd.hex_addr.dest_addr << std::dec;
-        //if(cmd.cmd_type == CommandType::READCOPY){std::cout << " " << "READCOPY";}
-        //if(cmd.cmd_type == CommandType::WRITECOPY){std::cout << " " << "WRITECOPY";}
-        //std::cout << std::endl;
+    // --------------------------------------------------------------------------
+    // RowClone added
+    // If READCOPY is going to be issued, force to find pair WRITECOPY in next for loop
+
+    if(cmd.cmd_type == CommandType::READCOPY){
+        is_in_copy_ = true;
+        copy_address_pair_ = cmd.hex_addr;
+        const auto& addr = cmd.dest_address;
+        queue_idx_ = GetQueueIndex(addr.rank, addr.bankgroup, addr.bank) - 1;
+        // make write bank wait
+    }
 
-        if (cmd.IsValid()) {
-            if (cmd.IsReadWrite()) {
-                EraseRWCommand(cmd);
-            }
-            else if(cmd.IsReadCopy() || cmd.IsWriteCopy()){
-                EraseCOPYCommand(cmd);
-            }
-            //std::cout<<clk_<<" getcommand"<<std::endl;
-            //std::cout<<"read: "<<cmd.IsRead()<<" write: "<<cmd.IsWrite()<<" readcopy: "<<cmd.IsReadCopy()<< \
-            " writecopy: "<<cmd.IsWriteCopy()<<" refresh: "<<cmd.IsRefresh()<<std::endl;
-            return cmd;
-        }
+    // ---------------------------------------------------------------------------
+
+    if (cmd.IsReadWrite()) {
+        EraseRWCommand(cmd);
     }
-    return Command();
+    else if(cmd.IsReadCopy() || cmd.IsWriteCopy()){
+        EraseCOPYCommand(cmd);
+    }
+    policy.CommandIssued(cmd, clk_);
+    return cmd;
+}
+
+void CommandQueue::CommandPicked(const Command& cmd, CommandType queued_type) {
+    if (cmd.cmd_type == CommandType::PRECHARGE) {
+        simple_stats_.Increment(CounterStat::NUM_ONDEMAND_PRES);
+    } else if (cmd.IsWriteCopy()) {
+        rank_state_[cmd.addr.rank] = false;
+        SetRankQueuesReady(cmd.addr.rank);
+    }
+    if (queued_type == CommandType::READCOPY ||
+        queued_type == CommandType::READCOPY_PRECHARGE) {
+        rank_state_[cmd.addr.rank] = true;
+        rank_address_pair_[cmd.addr.rank] =
+            AddressPair(cmd.hex_addr.src_addr, cmd.hex_addr.dest_addr);
+        SetRankQueuesReady(cmd.addr.rank);
+    }
+    return;
 }
 
 // RowClone Added
@@ -141,14 +219,109 @@ bool CommandQueue::ArbitratePrecharge(const CMDIterator& cmd_it,
         }
     }
 
+    // a row_hit_cap of 0 lets row hits go on for as long as there are any
     bool rowhit_limit_reached =
+        config_.row_hit_cap > 0 &&
         channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()) >=
-        4;
-    if (!pending_row_hits_exist || rowhit_limit_reached) {
-        simple_stats_.Increment("num_ondemand_pres");
-        return true;
+            config_.row_hit_cap;
+    return !pending_row_hits_exist || rowhit_limit_reached;
+}
+
+uint64_t CommandQueue::EarliestReadyCycle() const {
+    // no command in the queues can be issued before this cycle
+    uint64_t earliest = std::numeric_limits<uint64_t>::max();
+    for (int i = 0; i < num_queues_; i++) {
+        if (ready_mask_[i >> 6] & (1ull << (i & 63))) {
+            earliest = std::min(earliest, QueueEarliestReadyCycle(queues_[i]));
+        } else {
+            earliest = std::min(earliest, queue_ready_clk_[i]);
+        }
+        if (earliest <= clk_) {
+            return earliest;
+        }
     }
-    return false;
+    return earliest;
+}
+
+uint64_t CommandQueue::QueueEarliestReadyCycle(const CMDQueue& queue) const {
+    uint64_t earliest = std::numeric_limits<uint64_t>::max();
+    for (const auto& cmd : queue) {
+        earliest = std::min(earliest, channel_state_.EarliestReadyCycle(cmd));
+        if (earliest <= clk_) {
+            return earliest;
+        }
+    }
+    return earliest;
+}
+
+void CommandQueue::UpdateReadyQueues(const Command& cmd) {
+    if (cmd.IsRankCMD()) {
+        SetRankQueuesReady(cmd.Rank());
+    } else if (cmd.IsReadCopy() || cmd.IsWriteCopy()) {
+        // copies change the state of the destination bank as well
+        SetRankQueuesReady(cmd.Rank());
+        SetRankQueuesReady(cmd.dest_address.rank);
+    } else {
+        SetQueueReady(GetQueueIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
+    }
+    return;
+}
+
+void CommandQueue::SetRankQueuesReady(int rank) {
+    if (queue_structure_ == QueueStructure::PER_RANK) {
+        SetQueueReady(rank);
+    } else {
+        for (int i = rank * config_.banks; i < (rank + 1) * config_.banks;
+             i++) {
+            SetQueueReady(i);
+        }
+    }
+    return;
+}
+
+bool CommandQueue::IsQueueReady(int rank, int bankgroup, int bank) const {
+    int q_idx = GetQueueIndex(rank, bankgroup, bank);
+    return ready_mask_[q_idx >> 6] & (1ull << (q_idx & 63));
+}
+
+int CommandQueue::NextReadyQueue(int q_idx) const {
+    int word_idx = q_idx >> 6;
+    if (word_idx >= static_cast<int>(ready_mask_.size())) {
+        return num_queues_;
+    }
+    uint64_t word = ready_mask_[word_idx] & (~0ull << (q_idx & 63));
+    while (word == 0) {
+        word_idx++;
+        if (word_idx == static_cast<int>(ready_mask_.size())) {
+            return num_queues_;
+        }
+        word = ready_mask_[word_idx];
+    }
+    return (word_idx << 6) + __builtin_ctzll(word);
+}
+
+void CommandQueue::UpdateQueueReadyClk(int q_idx) {
+    // nothing was ready in the queue, keep it out of the scans until
+    // something in it can be
+    uint64_t ready_clk = QueueEarliestReadyCycle(queues_[q_idx]);
+    if (ready_clk <= clk_) {
+        // held back by something other than timing, look again next time
+        return;
+    }
+    ready_mask_[q_idx >> 6] &= ~(1ull << (q_idx & 63));
+    queue_ready_clk_[q_idx] = ready_clk;
+    if (ready_clk != std::numeric_limits<uint64_t>::max()) {
+        queue_wakeups_.emplace(ready_clk, q_idx);
+    }
+    return;
+}
+
+void CommandQueue::WakeUpQueues() {
+    while (!queue_wakeups_.empty() && queue_wakeups_.top().first <= clk_) {
+        SetQueueReady(queue_wakeups_.top().second);
+        queue_wakeups_.pop();
+    }
+    return;
 }
 
 bool CommandQueue::WillAcceptCommand(int rank, int bankgroup, int bank, bool additional) const {
@@ -168,11 +341,40 @@ bool CommandQueue::QueueEmpty() const {
     return true;
 }
 
+bool CommandQueue::RankQueueEmpty(int rank) const {
+    int first = GetQueueIndex(rank, 0, 0);
+    int last = queue_structure_ == QueueStructure::PER_RANK
+                   ? first + 1
+                   : first + config_.banks;
+    for (int i = first; i < last; i++) {
+        if (!queues_[i].empty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int CommandQueue::RankReads(int rank) const {
+    int first = GetQueueIndex(rank, 0, 0);
+    int last = queue_structure_ == QueueStructure::PER_RANK
+                   ? first + 1
+                   : first + config_.banks;
+    int reads = 0;
+    for (int i = first; i < last; i++) {
+        for (const auto& cmd : queues_[i]) {
+            if (cmd.IsRead()) {
+                reads++;
+            }
+        }
+    }
+    return reads;
+}
 
 bool CommandQueue::AddCommand(Command cmd) {
     auto& queue = GetQueue(cmd.Rank(), cmd.Bankgroup(), cmd.Bank());
     if (queue.size() < queue_size_) {
         queue.push_back(cmd);
+        SetQueueReady(GetQueueIndex(cmd.Rank(), cmd.Bankgroup(), cmd.Bank()));
         rank_q_empty[cmd.Rank()] = false;
         return true;
     } else {
@@ -180,14 +382,6 @@ bool CommandQueue::AddCommand(Command cmd) {
     }
 }
 
-CMDQueue& CommandQueue::GetNextQueue() {
-    queue_idx_++;
-    if (queue_idx_ == num_queues_) {
-        queue_idx_ = 0;
-    }
-    return queues_[queue_idx_];
-}
-
 void CommandQueue::GetRefQIndices(const Command& ref) {
     if (ref.cmd_type == CommandType::REFRESH) {
         if (queue_structure_ == QueueStructure::PER_BANK) {
@@ -220,7 +414,11 @@ CMDQueue& CommandQueue::GetQueue(int rank, int bankgroup, int bank) {
     return queues_[index];
 }
 
-Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) {
+template <class Policy>
+Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue,
+                                           const Policy& policy,
+                                           CommandType& queued_type,
+                                           uint64_t& priority) const {
     //std::cout<<clk_<<" getfirtstreadyinqueue"<<std::endl;
 
     // ---------------------------------------------------------------
@@ -274,6 +472,7 @@ Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) {
     // -------------------------------------------------------------------
     //std::cout<<"original"<<std::endl;
 
+    Command best_cmd;
     for (auto cmd_it = queue.begin(); cmd_it != queue.end(); cmd_it++) {
         if (rank_state_[cmd_it->addr.rank]){
             // only readwrite copy on that rank
@@ -300,38 +499,42 @@ Command CommandQueue::GetFirstReadyInQueue(CMDQueue& queue) {
             if (HasRWDependency(cmd_it, queue)) {
                 continue;
             }
-        } else if (cmd.IsWriteCopy()){
-            rank_state_[cmd.addr.rank] = false;
         } else if (cmd.IsReadCopy()){
             // check bank same or not
-            //std::cout<<clk_<<" isreadcopy"<<std::endl;
             auto src_address = cmd.addr;
-            auto dest_address = config_.AddressMapping(cmd.hex_addr.dest_addr);
+            const auto& dest_address = cmd.dest_address;
 
             if(src_address.bankgroup != dest_address.bankgroup || \
                 src_address.bank != dest_address.bank){
                 // different bank
                 cmd.isFPM = false;
                 // check whether dest bank can start waiting for WRITE_COPY
-                if(!channel_state_.CanStartWait(Command(CommandType::WRITECOPY, \
-                    dest_address, cmd.hex_addr), clk_)){
+                if(!channel_state_.CanStartWait(cmd, clk_)){
                     // dest bank can not start waiting for WRITE_COPY
-                    //std::cout<<"no writecopy"<<std::endl;
                     continue;
                 }
             }
             else{
                 cmd.isFPM = true;
             }
-            //std::cout<<clk_<<" readcopy issue"<<std::endl;
         }
-        if(cmd_it->cmd_type == CommandType::READCOPY || cmd_it->cmd_type == CommandType::READCOPY_PRECHARGE){
-            rank_state_[cmd_it->addr.rank] = true;
-            rank_address_pair_[cmd_it->addr.rank] = AddressPair(cmd_it->hex_addr.src_addr, cmd_it->hex_addr.dest_addr);
+        cmd.source_id = cmd_it->source_id;
+        cmd.added_cycle = cmd_it->added_cycle;
+        cmd.marked = cmd_it->marked;
+        if (Policy::kFirstReady) {
+            queued_type = cmd_it->cmd_type;
+            priority = 0;
+            return cmd;
+        }
+        uint64_t cmd_priority =
+            policy.Priority(cmd, cmd.cmd_type == cmd_it->cmd_type, clk_);
+        if (!best_cmd.IsValid() || cmd_priority > priority) {
+            best_cmd = cmd;
+            queued_type = cmd_it->cmd_type;
+            priority = cmd_priority;
         }
-        return cmd;
     }
-    return Command();
+    return best_cmd;
 }
 
 void CommandQueue::EraseRWCommand(const Command& cmd) {
@@ -389,4 +592,39 @@ void CommandQueue::printFlag(){
     std::cout<<std::endl;
 }
 
+void CommandQueue::Serialize(Checkpoint& cp) {
+    cp.Expect(num_queues_, "command queues per channel");
+    cp.Field(rank_q_empty);
+    cp.Field(parbs_);
+    cp.Field(atlas_);
+    cp.Field(bliss_);
+    cp.Field(queues_);
+    cp.Field(ready_mask_);
+    cp.Field(queue_ready_clk_);
+    // the wakeups go in and out of the checkpoint in cycle order
+    std::vector<std::pair<uint64_t, int>> wakeups;
+    if (cp.IsSaving()) {
+        auto queue_wakeups = queue_wakeups_;
+        while (!queue_wakeups.empty()) {
+            wakeups.push_back(queue_wakeups.top());
+            queue_wakeups.pop();
+        }
+    }
+    cp.Field(wakeups);
+    if (!cp.IsSaving()) {
+        queue_wakeups_ = decltype(queue_wakeups_)();
+        for (const auto& wakeup : wakeups) {
+            queue_wakeups_.push(wakeup);
+        }
+    }
+    cp.Field(ref_q_indices_);
+    cp.Field(is_in_ref_);
+    cp.Field(is_in_copy_);
+    cp.Field(copy_address_pair_);
+    cp.Field(rank_state_);
+    cp.Field(rank_address_pair_);
+    cp.Field(queue_idx_);
+    cp.Field(clk_);
+}
+
 }  // namespace dramsim3
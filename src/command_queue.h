@@ -1,11 +1,16 @@
 #ifndef __COMMAND_QUEUE_H
 #define __COMMAND_QUEUE_H
 
+#include <functional>
+#include <queue>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 #include "channel_state.h"
+#include "checkpoint.h"
 #include "common.h"
 #include "configuration.h"
+#include "scheduler.h"
 #include "simple_stats.h"
 
 namespace dramsim3 {
@@ -20,11 +25,26 @@ class CommandQueue {
                  const ChannelState& channel_state, SimpleStats& simple_stats);
     Command GetCommandToIssue();
     Command FinishRefresh();
-    void ClockTick() { clk_ += 1; };
+    void ClockTick() {
+        clk_ += 1;
+        WakeUpQueues();
+    };
+    void SkipCycles(uint64_t cycles) {
+        clk_ += cycles;
+        WakeUpQueues();
+    }
+    uint64_t EarliestReadyCycle() const;
+    // banks whose state the issued command changed have to be looked at again
+    void UpdateReadyQueues(const Command& cmd);
     bool WillAcceptCommand(int rank, int bankgroup, int bank, bool additional=0) const;
     bool AddCommand(Command cmd);
     bool QueueEmpty() const;
     int QueueUsage() const;
+    bool RankQueueEmpty(int rank) const;
+    // whether the next scan looks at the queue, see ready_mask_
+    bool IsQueueReady(int rank, int bankgroup, int bank) const;
+    // reads queued for the rank
+    int RankReads(int rank) const;
     std::vector<bool> rank_q_empty;
 
     // Rowclone added
@@ -33,15 +53,25 @@ class CommandQueue {
     void EraseCOPYCommand(const Command& cmd);
     void printFlag();
 
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
    private:
     bool ArbitratePrecharge(const CMDIterator& cmd_it,
                             const CMDQueue& queue) const;
     bool HasRWDependency(const CMDIterator& cmd_it,
                          const CMDQueue& queue) const;
-    Command GetFirstReadyInQueue(CMDQueue& queue);
+    template <class Policy>
+    Command GetCommandToIssue(Policy& policy);
+    // the ready command the policy likes best in the queue, along with the
+    // type of the queued command it's for and its priority
+    template <class Policy>
+    Command GetFirstReadyInQueue(CMDQueue& queue, const Policy& policy,
+                                 CommandType& queued_type,
+                                 uint64_t& priority) const;
+    void CommandPicked(const Command& cmd, CommandType queued_type);
     int GetQueueIndex(int rank, int bankgroup, int bank) const;
     CMDQueue& GetQueue(int rank, int bankgroup, int bank);
-    CMDQueue& GetNextQueue();
     void GetRefQIndices(const Command& ref);
     void EraseRWCommand(const Command& cmd);
     Command PrepRefCmd(const CMDIterator& it, const Command& ref) const;
@@ -51,8 +81,35 @@ class CommandQueue {
     const ChannelState& channel_state_;
     SimpleStats& simple_stats_;
 
+    SchedulerType scheduler_;
+    FRFCFSScheduler frfcfs_;
+    PARBSScheduler parbs_;
+    ATLASScheduler atlas_;
+    BLISSScheduler bliss_;
+
     std::vector<CMDQueue> queues_;
 
+    // Queues that may have a ready command, one bit each. Every other queue
+    // is either empty or has nothing ready before its queue_ready_clk_, as
+    // timing constraints only ever move later until the state of one of
+    // its banks changes
+    std::vector<uint64_t> ready_mask_;
+    std::vector<uint64_t> queue_ready_clk_;
+    // (cycle, queue) for queues to be marked ready again
+    std::priority_queue<std::pair<uint64_t, int>,
+                        std::vector<std::pair<uint64_t, int>>,
+                        std::greater<std::pair<uint64_t, int>>>
+        queue_wakeups_;
+    void SetQueueReady(int q_idx) {
+        ready_mask_[q_idx >> 6] |= 1ull << (q_idx & 63);
+    }
+    void SetRankQueuesReady(int rank);
+    // first queue from q_idx on that may be ready, num_queues_ if none
+    int NextReadyQueue(int q_idx) const;
+    void UpdateQueueReadyClk(int q_idx);
+    void WakeUpQueues();
+    uint64_t QueueEarliestReadyCycle(const CMDQueue& queue) const;
+
     // Refresh related data structures
     std::unordered_set<int> ref_q_indices_;
     bool is_in_ref_;
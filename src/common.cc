@@ -1,13 +1,14 @@
 #include "common.h"
 #include "fmt/format.h"
+#include <cctype>
 #include <sstream>
 #include <unordered_set>
 #include <sys/stat.h>
 
 namespace dramsim3 {
 
-std::ostream& operator<<(std::ostream& os, const Command& cmd) {
-    std::vector<std::string> command_string = {
+const std::string& CommandTypeName(CommandType cmd_type) {
+    static const std::vector<std::string> command_string = {
         "read",
         "read_p",
         "read_copy",
@@ -30,8 +31,12 @@ std::ostream& operator<<(std::ostream& os, const Command& cmd) {
         "writecopy_FPM_PRECHARGE_timing",
         "writecopy_PSM_PRECHARGE_timing",
         "WRONG"};
+    return command_string[static_cast<int>(cmd_type)];
+}
+
+std::ostream& operator<<(std::ostream& os, const Command& cmd) {
     os << fmt::format("{:<20} {:>3} {:>3} {:>3} {:>3} {:>#8x} {:>#8x}",
-                      command_string[static_cast<int>(cmd.cmd_type)],
+                      CommandTypeName(cmd.cmd_type),
                       cmd.Channel(), cmd.Rank(), cmd.Bankgroup(), cmd.Bank(),
                       cmd.Row(), cmd.Column());
     return os;
@@ -44,21 +49,48 @@ std::ostream& operator<<(std::ostream& os, const Transaction& trans) {
 }
 
 std::istream& operator>>(std::istream& is, Transaction& trans) {
-    std::unordered_set<std::string> write_types = {"WRITE", "write", "P_MEM_WR",
-                                                   "BOFF"};
+    static const std::unordered_set<std::string> write_types = {
+        "WRITE", "write", "P_MEM_WR", "BOFF"};
     std::string mem_op;
-    is >> mem_op;
-    if (mem_op != "COPY") {
-        is >> std::hex >> trans.addr >> std::dec >> trans.added_cycle;
-        trans.is_write = write_types.count(mem_op) == 1;
+    if (!(is >> mem_op)) {
+        return is;
+    }
+    uint64_t src_addr = 0, dest_addr = 0;
+    if (std::isdigit(static_cast<unsigned char>(mem_op[0]))) {
+        // "ADDR OP CYCLE", as scripts/trace_gen.py writes them
+        src_addr = std::stoull(mem_op, nullptr, 16);
+        is >> mem_op;
     } else {
-        is >> std::hex >> trans.addr.src_addr >> std::hex >> trans.addr.dest_addr >> std::dec >> trans.added_cycle;
-        trans.is_copy = true;
-        trans.addr.is_copy = true;
+        // "OP ADDR CYCLE" or "COPY SRC DEST CYCLE"
+        is >> std::hex >> src_addr;
+        if (mem_op == "COPY") {
+            is >> dest_addr;
+        }
+    }
+    is >> std::dec >> trans.added_cycle;
+    trans.is_copy = mem_op == "COPY";
+    trans.is_write = !trans.is_copy && write_types.count(mem_op) == 1;
+    if (trans.is_copy) {
+        trans.addr = AddressPair(src_addr, dest_addr);
+    } else {
+        trans.addr = AddressPair(src_addr);
     }
+    // assignment keeps the flag of the old address
+    trans.addr.is_copy = trans.is_copy;
     return is;
 }
 
+CommandType CopyTimingType(CommandType cmd_type, bool is_fpm) {
+    if((cmd_type == CommandType::READCOPY) && (is_fpm)){return CommandType::READCOPY_FPM;}
+    else if((cmd_type == CommandType::READCOPY) && (!is_fpm)){return CommandType::READCOPY_PSM;}
+    else if((cmd_type == CommandType::READCOPY_PRECHARGE) && (is_fpm)){return CommandType::READCOPY_FPM;}
+    else if((cmd_type == CommandType::READCOPY_PRECHARGE) && (!is_fpm)){return CommandType::READCOPY_PSM_PRECHARGE;}
+    else if((cmd_type == CommandType::WRITECOPY) && (is_fpm)){return CommandType::WRITECOPY_FPM;}
+    else if((cmd_type == CommandType::WRITECOPY) && (!is_fpm)){return CommandType::WRITECOPY_PSM;}
+    else if((cmd_type == CommandType::WRITECOPY_PRECHARGE) && (is_fpm)){return CommandType::WRITECOPY_FPM_PRECHARGE;}
+    else {return CommandType::WRITECOPY_PSM_PRECHARGE;}
+}
+
 int GetBitInPos(uint64_t bits, int pos) {
     // given a uint64_t value get the binary value of pos-th bit
     // from MSB to LSB indexed as 63 - 0
@@ -60,7 +60,7 @@ namespace dramsim3 {
             return *this;
         }
         AddressPair& operator>>= (const uint64_t a) {
-            src_addr = src_addr << a;
+            src_addr = src_addr >> a;
             return *this;
         }
     };
@@ -134,10 +134,29 @@ enum class CommandType {
     SIZE
 };
 
+// RowClone added
+// copy commands are timed differently depending on whether they are FPM or PSM
+CommandType CopyTimingType(CommandType cmd_type, bool is_fpm);
+
+// name a command is printed and traced with
+const std::string& CommandTypeName(CommandType cmd_type);
+
 struct Command {
-    Command() : cmd_type(CommandType::SIZE), hex_addr(0) {}
+    Command()
+        : cmd_type(CommandType::SIZE),
+          hex_addr(0),
+          isFPM(false),
+          source_id(0),
+          added_cycle(0),
+          marked(false) {}
     Command(CommandType cmd_type, const Address& addr, AddressPair hex_addr)
-        : cmd_type(cmd_type), addr(addr), hex_addr(hex_addr) {}
+        : cmd_type(cmd_type),
+          addr(addr),
+          hex_addr(hex_addr),
+          isFPM(false),
+          source_id(0),
+          added_cycle(0),
+          marked(false) {}
     // Command(const Command& cmd) {}
 
     bool IsValid() const { return cmd_type != CommandType::SIZE; }
@@ -176,6 +195,13 @@ struct Command {
 
     // Rowclone added
     bool isFPM;
+    // where a copy goes, decoded with the transaction
+    Address dest_address;
+
+    // what the scheduling policies know about the request behind it
+    int source_id;
+    uint64_t added_cycle;
+    bool marked;  // part of the current PAR-BS batch
 
     int Channel() const { return addr.channel; }
     int Rank() const { return addr.rank; }
@@ -188,19 +214,26 @@ struct Command {
 };
 
 struct Transaction {
-    Transaction() {}
-    Transaction(AddressPair addr, bool is_write)
+    Transaction() : source_id(0), req_id(0) {}
+    Transaction(AddressPair addr, bool is_write, int source_id = 0,
+                uint64_t req_id = 0)
         : addr(addr),
           added_cycle(0),
           complete_cycle(0),
           is_write(is_write),
-          is_copy(addr.is_copy) {}
+          is_copy(addr.is_copy),
+          source_id(source_id),
+          req_id(req_id) {}
     Transaction(const Transaction& tran)
         : addr(tran.addr),
           added_cycle(tran.added_cycle),
           complete_cycle(tran.complete_cycle),
           is_write(tran.is_write),
-          is_copy(tran.is_copy) {}
+          is_copy(tran.is_copy),
+          src_address(tran.src_address),
+          dest_address(tran.dest_address),
+          source_id(tran.source_id),
+          req_id(tran.req_id) {}
     AddressPair addr;
     uint64_t added_cycle;
     uint64_t complete_cycle;
@@ -209,9 +242,33 @@ struct Transaction {
     // Row Clone added
     bool is_copy;
 
+    // addr decoded once the transaction reaches its controller, see
+    // Config::DecodeAddresses, dest_address only for copies
+    Address src_address;
+    Address dest_address;
+
+    // core or thread the request comes from, for the scheduling policies
+    int source_id;
+    // given by the front end and handed back when the request completes
+    uint64_t req_id;
+
     friend std::ostream& operator<<(std::ostream& os, const Transaction& trans);
     friend std::istream& operator>>(std::istream& is, Transaction& trans);
 };
 
+// front end side view of a request for the batched interface
+struct Request {
+    uint64_t req_id;
+    AddressPair hex_addr;
+    bool is_write;
+    int source_id;
+};
+
+struct Completion {
+    uint64_t req_id;
+    AddressPair hex_addr;
+    bool is_write;
+};
+
 }  // namespace dramsim3
 #endif
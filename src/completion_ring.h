@@ -0,0 +1,59 @@
+#ifndef __COMPLETION_RING_H
+#define __COMPLETION_RING_H
+
+#include <algorithm>
+#include <vector>
+#include "checkpoint.h"
+#include "common.h"
+
+namespace dramsim3 {
+
+// Completed requests waiting for the front end to poll them, for front ends
+// that don't register callbacks. It grows instead of dropping completions
+// when the front end falls behind.
+class CompletionRing {
+   public:
+    CompletionRing() : slots_(64), head_(0), size_(0) {}
+    void Push(const Completion& completion) {
+        if (size_ == slots_.size()) {
+            Grow();
+        }
+        slots_[(head_ + size_) & (slots_.size() - 1)] = completion;
+        size_++;
+    }
+    // moves up to max_completions of the oldest completions to completions
+    size_t Pop(Completion* completions, size_t max_completions) {
+        size_t num = std::min(max_completions, size_);
+        for (size_t i = 0; i < num; i++) {
+            completions[i] = slots_[head_];
+            head_ = (head_ + 1) & (slots_.size() - 1);
+        }
+        size_ -= num;
+        return num;
+    }
+    size_t Size() const { return size_; }
+    void Serialize(Checkpoint& cp) {
+        cp.Field(slots_);
+        cp.Field(head_);
+        cp.Field(size_);
+    }
+
+   private:
+    // power of 2 so the index wraps with a mask
+    std::vector<Completion> slots_;
+    size_t head_;
+    size_t size_;
+
+    void Grow() {
+        std::vector<Completion> slots(slots_.size() * 2);
+        for (size_t i = 0; i < size_; i++) {
+            slots[i] = slots_[(head_ + i) & (slots_.size() - 1)];
+        }
+        slots_.swap(slots);
+        head_ = 0;
+    }
+};
+
+}  // namespace dramsim3
+
+#endif
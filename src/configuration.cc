@@ -1,5 +1,6 @@
 #include "configuration.h"
 
+#include <algorithm>
 #include <vector>
 
 #ifdef THERMAL
@@ -8,8 +9,28 @@
 
 namespace dramsim3 {
 
+namespace {
+// INIReader with some of the [system] values replaced
+class OverriddenINIReader : public INIReader {
+   public:
+    OverriddenINIReader(const std::string& file_name,
+                        const std::map<std::string, std::string>& overrides)
+        : INIReader(file_name) {
+        for (const auto& key_value : overrides) {
+            _values[MakeKey("system", key_value.first)] = key_value.second;
+        }
+    }
+};
+}  // namespace
+
 Config::Config(std::string config_file, std::string out_dir)
-    : output_dir(out_dir), reader_(new INIReader(config_file)) {
+    : Config(config_file, out_dir, std::map<std::string, std::string>()) {}
+
+Config::Config(std::string config_file, std::string out_dir,
+               const std::map<std::string, std::string>& system_overrides)
+    : output_dir(out_dir), has_bit_field_mapping_(false) {
+    OverriddenINIReader reader(config_file, system_overrides);
+    reader_ = &reader;
     if (reader_->ParseError() < 0) {
         std::cerr << "Can't load config file - " << config_file << std::endl;
         AbruptExit(__FILE__, __LINE__);
@@ -27,11 +48,13 @@ Config::Config(std::string config_file, std::string out_dir)
 #ifdef THERMAL
     InitThermalParams();
 #endif  // THERMAL
-    delete (reader_);
+    reader_ = nullptr;
 }
 
 Address Config::AddressMapping(AddressPair hex_addr) const {
-
+    if (has_bit_field_mapping_) {
+        return bit_field_mapping_.Map(hex_addr.src_addr);
+    }
     hex_addr >>= shift_bits;
     int channel = (hex_addr >> ch_pos) & ch_mask;
     int rank = (hex_addr >> ra_pos) & ra_mask;
@@ -43,6 +66,9 @@ Address Config::AddressMapping(AddressPair hex_addr) const {
 }
 
 Address Config::AddressMapping(uint64_t hex_addr) const {
+    if (has_bit_field_mapping_) {
+        return bit_field_mapping_.Map(hex_addr);
+    }
     //std::cout << std::bitset<64>(hex_addr) << " ";
     hex_addr >>= shift_bits;
     //std::cout << std::bitset<64>(hex_addr) << std::endl;
@@ -55,6 +81,39 @@ Address Config::AddressMapping(uint64_t hex_addr) const {
     return Address(channel, rank, bg, ba, ro, co);
 }
 
+void Config::AddressMapping(const uint64_t* hex_addrs, size_t count,
+                            Address* addrs) const {
+    if (has_bit_field_mapping_) {
+        bit_field_mapping_.Map(hex_addrs, count, addrs);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        addrs[i] = AddressMapping(hex_addrs[i]);
+    }
+    return;
+}
+
+uint64_t Config::FieldAddressBits(AddressField field) const {
+    if (has_bit_field_mapping_) {
+        return bit_field_mapping_.FieldAddressBits(field);
+    }
+    int pos[] = {ch_pos, ra_pos, bg_pos, ba_pos, ro_pos, co_pos};
+    uint64_t mask[] = {ch_mask, ra_mask, bg_mask, ba_mask, ro_mask, co_mask};
+    int i = static_cast<int>(field);
+    return mask[i] << pos[i] << shift_bits;
+}
+
+void Config::DecodeAddresses(Transaction& trans) const {
+    // copies are mapped address by address, everything else through the
+    // AddressPair overload, both decode an address the same way
+    if (trans.is_copy) {
+        trans.src_address = AddressMapping(trans.addr.src_addr);
+        trans.dest_address = AddressMapping(trans.addr.dest_addr);
+    } else {
+        trans.src_address = AddressMapping(trans.addr);
+    }
+    return;
+}
 
 void Config::CalculateSize() {
     // calculate rank and re-calculate channel_size
@@ -192,6 +251,13 @@ void Config::InitOtherParams() {
     json_stats_name = output_prefix + ".json";
     json_epoch_name = output_prefix + "epoch.json";
     txt_stats_name = output_prefix + ".txt";
+
+    cmd_trace = reader.GetBoolean("other", "cmd_trace", false);
+    cmd_trace_types = reader.Get("other", "cmd_trace_types", "");
+    cmd_trace_ranks = reader.Get("other", "cmd_trace_ranks", "");
+    cmd_trace_banks = reader.Get("other", "cmd_trace_banks", "");
+    cmd_trace_buffer = GetInteger("other", "cmd_trace_buffer", 65536);
+    addr_trace = reader.GetBoolean("other", "addr_trace", false);
     return;
 }
 
@@ -258,6 +324,90 @@ void Config::InitSystemParams() {
     sref_threshold = GetInteger("system", "sref_threshold", 1000);
     aggressive_precharging_enabled =
         reader.GetBoolean("system", "aggressive_precharging_enabled", false);
+    enable_skip_ahead = reader.GetBoolean("system", "enable_skip_ahead", false);
+    timing_engine = reader.Get("system", "timing_engine", "EAGER");
+    if (timing_engine != "EAGER" && timing_engine != "LAZY" &&
+        timing_engine != "VALIDATE") {
+        std::cerr << "Unsupported timing_engine " << timing_engine
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    channel_threads = GetInteger("system", "channel_threads", 1);
+    sync_quantum = GetInteger("system", "sync_quantum", 1000);
+    if (channel_threads < 1 || sync_quantum < 1) {
+        std::cerr << "channel_threads and sync_quantum must be positive"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    scheduler = reader.Get("system", "scheduler", "FRFCFS");
+    row_hit_cap = GetInteger("system", "row_hit_cap", 4);
+    parbs_marking_cap = GetInteger("system", "parbs_marking_cap", 5);
+    atlas_quantum = GetInteger("system", "atlas_quantum", 10000000);
+    atlas_alpha = reader.GetReal("system", "atlas_alpha", 0.875);
+    atlas_threshold = GetInteger("system", "atlas_threshold", 100000);
+    bliss_threshold = GetInteger("system", "bliss_threshold", 4);
+    bliss_clearing_interval =
+        GetInteger("system", "bliss_clearing_interval", 10000);
+    if (parbs_marking_cap < 1 || atlas_quantum < 1 ||
+        bliss_clearing_interval < 1) {
+        std::cerr << "parbs_marking_cap, atlas_quantum and "
+                     "bliss_clearing_interval must be positive"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    trans_scheduler = reader.Get("system", "trans_scheduler", "FCFS");
+    trans_per_cycle = GetInteger("system", "trans_per_cycle", 1);
+    if (trans_scheduler != "FCFS" && trans_scheduler != "ROW_HIT_FIRST") {
+        std::cerr << "Unsupported trans_scheduler " << trans_scheduler
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    if (trans_per_cycle < 1) {
+        std::cerr << "trans_per_cycle must be positive" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    // the buffer holds one less than trans_queue_size, see
+    // Controller::WillAcceptTransaction. A queue of one has no room for a
+    // high watermark below it, so by default its write drains as soon as it
+    // is buffered. Only watermarks given in the config are checked
+    bool watermarks_set =
+        !reader.Get("system", "write_high_watermark", "").empty() ||
+        !reader.Get("system", "write_low_watermark", "").empty();
+    write_high_watermark = GetInteger("system", "write_high_watermark",
+                                      std::max(trans_queue_size - 1, 1));
+    write_low_watermark = GetInteger("system", "write_low_watermark", 0);
+    write_drain_idle = GetInteger("system", "write_drain_idle", 8);
+    write_drain_adaptive =
+        reader.GetBoolean("system", "write_drain_adaptive", false);
+    if (watermarks_set && (write_low_watermark < 0 ||
+                           write_low_watermark >= write_high_watermark ||
+                           write_high_watermark >= trans_queue_size)) {
+        std::cerr << "Write watermarks must satisfy 0 <= write_low_watermark "
+                     "< write_high_watermark < trans_queue_size"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+
+    // JEDEC allows up to 8 refreshes to be postponed and 8 pulled in
+    refresh_scheduling = reader.Get("system", "refresh_scheduling", "STRICT");
+    refresh_max_postpone = GetInteger("system", "refresh_max_postpone", 8);
+    refresh_max_pull_in = GetInteger("system", "refresh_max_pull_in", 8);
+    refresh_postpone_reads = GetInteger("system", "refresh_postpone_reads", 1);
+    if (refresh_scheduling != "STRICT" && refresh_scheduling != "ELASTIC") {
+        std::cerr << "Unsupported refresh_scheduling " << refresh_scheduling
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    if (refresh_max_postpone < 0 || refresh_max_pull_in < 0 ||
+        refresh_postpone_reads < 1) {
+        std::cerr << "refresh_max_postpone and refresh_max_pull_in must not "
+                     "be negative, refresh_postpone_reads must be positive"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
 
     return;
 }
@@ -351,6 +501,9 @@ void Config::InitTimingParams() {
 
     ideal_memory_latency = GetInteger("timing", "ideal_memory_latency", 10);
 
+    // a [system] key, but an idle gap as long as a refresh is the default
+    refresh_pull_in_idle = GetInteger("system", "refresh_pull_in_idle", tRFC);
+
     // calculated timing
     RL = AL + CL;
     WL = AL + CWL;
@@ -416,6 +569,74 @@ void Config::SetAddressMapping() {
     ba_mask = (1 << field_widths.at("ba")) - 1;
     ro_mask = (1 << field_widths.at("ro")) - 1;
     co_mask = (1 << field_widths.at("co")) - 1;
+
+    SetBitFieldMapping(field_pos, field_widths);
+}
+
+void Config::SetBitFieldMapping(const std::map<std::string, int>& field_pos,
+                                const std::map<std::string, int>& field_widths) {
+    // in the order of AddressField
+    const std::vector<std::string> tokens = {"ch", "ra", "bg",
+                                             "ba", "ro", "co"};
+    const auto& reader = *reader_;
+    for (const auto& token : tokens) {
+        if (!reader.Get("system", "address_bits_" + token, "").empty() ||
+            !reader.Get("system", "address_xor_" + token, "").empty()) {
+            has_bit_field_mapping_ = true;
+        }
+    }
+    if (!has_bit_field_mapping_) {
+        return;
+    }
+
+    // fields without address_bits_ keep their bits from address_mapping
+    for (size_t i = 0; i < tokens.size(); i++) {
+        const auto& token = tokens[i];
+        int width = field_widths.at(token);
+        uint64_t bits = ((1ull << width) - 1) << field_pos.at(token)
+                                              << shift_bits;
+        std::string bits_str = reader.Get("system", "address_bits_" + token, "");
+        if (!bits_str.empty()) {
+            bits = ParseAddressBits(bits_str);
+        }
+        if (__builtin_popcountll(bits) != width) {
+            std::cerr << "address_bits_" << token << " needs " << width
+                      << " bits" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        std::vector<uint64_t> xor_terms;
+        for (const auto& term : StringSplit(
+                 reader.Get("system", "address_xor_" + token, ""), ',')) {
+            xor_terms.push_back(ParseAddressBits(term));
+        }
+        bit_field_mapping_.SetField(static_cast<AddressField>(i), bits,
+                                    xor_terms);
+    }
+    bit_field_mapping_.Build();
+}
+
+uint64_t Config::ParseAddressBits(const std::string& bits) const {
+    // bit numbers and ranges like "6 7 13-15"
+    uint64_t mask = 0;
+    for (const auto& item : StringSplit(bits, ' ')) {
+        auto range = StringSplit(item, '-');
+        int low = -1, high = -1;
+        try {
+            low = std::stoi(range.at(0));
+            high = range.size() == 2 ? std::stoi(range[1]) : low;
+        } catch (const std::exception&) {
+            range.clear();
+        }
+        if (range.empty() || range.size() > 2 || low < 0 || high > 63 ||
+            low > high) {
+            std::cerr << "Cannot parse address bits: " << bits << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+        for (int b = low; b <= high; b++) {
+            mask |= 1ull << b;
+        }
+    }
+    return mask;
 }
 
 }  // namespace dramsim3
@@ -2,7 +2,9 @@
 #define __CONFIG_H
 
 #include <fstream>
+#include <map>
 #include <string>
+#include "address_mapping.h"
 #include "common.h"
 
 #include "INIReader.h"
@@ -34,8 +36,22 @@ enum class RefreshPolicy {
 class Config {
    public:
     Config(std::string config_file, std::string out_dir);
+    // with some [system] keys taken from system_overrides instead of the
+    // file, e.g. to try out address mappings
+    Config(std::string config_file, std::string out_dir,
+           const std::map<std::string, std::string>& system_overrides);
     Address AddressMapping(AddressPair hex_addr) const;
     Address AddressMapping(uint64_t hex_addr) const;
+    // a batch of addresses at once, e.g. for a whole trace
+    void AddressMapping(const uint64_t* hex_addrs, size_t count,
+                        Address* addrs) const;
+    // every address bit the field is decoded from
+    uint64_t FieldAddressBits(AddressField field) const;
+    bool HasBitFieldMapping() const { return has_bit_field_mapping_; }
+    // fills in the decoded addresses of a transaction, so the controller
+    // doesn't have to map it again for every queue and command it goes
+    // through
+    void DecodeAddresses(Transaction& trans) const;
 
     // DRAM physical structure
     DRAMProtocol protocol;
@@ -135,6 +151,41 @@ class Config {
     int sref_threshold;
     bool aggressive_precharging_enabled;
     bool enable_hbm_dual_cmd;
+    // jump over cycles in which no controller has anything to do
+    bool enable_skip_ahead;
+    // how bank timing constraints are tracked: EAGER updates every bank's
+    // timing when a command is issued, LAZY works them out from the last
+    // issue times when asked, and VALIDATE runs both and checks they agree
+    std::string timing_engine;
+    // threads the channels are simulated on, and how many cycles they may
+    // run apart from the front end
+    int channel_threads;
+    int sync_quantum;
+    // command scheduling policy and its knobs
+    std::string scheduler;
+    int row_hit_cap;
+    int parbs_marking_cap;
+    int atlas_quantum;
+    double atlas_alpha;
+    int atlas_threshold;
+    int bliss_threshold;
+    int bliss_clearing_interval;
+    // how transactions move from the transaction queues to the command
+    // queue, FCFS or ROW_HIT_FIRST, and at most how many of them per cycle
+    std::string trans_scheduler;
+    int trans_per_cycle;
+    // write buffer drain thresholds, see WriteDrain
+    int write_high_watermark;
+    int write_low_watermark;
+    int write_drain_idle;
+    bool write_drain_adaptive;
+    // STRICT queues every refresh when it is due, ELASTIC postpones them
+    // under read demand and pulls them into idle time, see Refresh
+    std::string refresh_scheduling;
+    int refresh_max_postpone;
+    int refresh_max_pull_in;
+    int refresh_postpone_reads;
+    int refresh_pull_in_idle;
 
 
     int epoch_period;
@@ -144,6 +195,14 @@ class Config {
     std::string json_stats_name;
     std::string json_epoch_name;
     std::string txt_stats_name;
+    // binary command trace, filtered by command type names and by rank and
+    // bank (counted across bank groups) given as comma separated lists
+    bool cmd_trace;
+    std::string cmd_trace_types;
+    std::string cmd_trace_ranks;
+    std::string cmd_trace_banks;
+    int cmd_trace_buffer;  // records buffered per channel
+    bool addr_trace;
 
     // Computed parameters
     int request_size_bytes;
@@ -185,7 +244,11 @@ class Config {
 #endif  // THERMAL
 
    private:
+    // only set while the constructor reads the config
     INIReader* reader_;
+    // address_bits_* or address_xor_* were given, see SetAddressMapping
+    bool has_bit_field_mapping_;
+    BitFieldMapping bit_field_mapping_;
     void CalculateSize();
     DRAMProtocol GetDRAMProtocol(std::string protocol_str);
     int GetInteger(const std::string& sec, const std::string& opt,
@@ -199,6 +262,9 @@ class Config {
 #endif  // THERMAL
     void InitTimingParams();
     void SetAddressMapping();
+    void SetBitFieldMapping(const std::map<std::string, int>& field_pos,
+                            const std::map<std::string, int>& field_widths);
+    uint64_t ParseAddressBits(const std::string& bits) const;
 };
 
 }  // namespace dramsim3
@@ -1,5 +1,4 @@
 #include "controller.h"
-#include <iomanip>
 #include <iostream>
 #include <limits>
 
@@ -17,16 +16,26 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
       simple_stats_(config_, channel_id_),
       channel_state_(config, timing),
       cmd_queue_(channel_id_, config, channel_state_, simple_stats_),
-      refresh_(config, channel_state_),
+      refresh_(config, channel_state_, cmd_queue_, simple_stats_),
 #ifdef THERMAL
       thermal_calc_(thermal_calc),
 #endif  // THERMAL
       is_unified_queue_(config.unified_queue),
+      unified_queue_(config),
+      read_queue_(config),
+      write_buffer_(config),
+      copy_queue_(config),
+      pending_cp_q_(config.trans_queue_size),
+      pending_rd_q_(config.trans_queue_size),
+      pending_wr_q_(config.trans_queue_size),
+      return_queue_(config),
       row_buf_policy_(config.row_buf_policy == "CLOSE_PAGE"
                           ? RowBufPolicy::CLOSE_PAGE
                           : RowBufPolicy::OPEN_PAGE),
+      cmd_tracer_(nullptr),
       last_trans_clk_(0),
-      write_draining_(0) {
+      write_drain_(config, simple_stats_),
+      trans_row_hit_first_(config.trans_scheduler == "ROW_HIT_FIRST") {
     if (is_unified_queue_) {
         unified_queue_.reserve(config_.trans_queue_size);
     } else {
@@ -34,36 +43,24 @@ Controller::Controller(int channel, const Config &config, const Timing &timing)
         write_buffer_.reserve(config_.trans_queue_size);
     }
     copy_queue_.reserve(config_.trans_queue_size);
-
-#ifdef CMD_TRACE
-    std::string trace_file_name = config_.output_prefix + "ch_" +
-                                  std::to_string(channel_id_) + "cmd.trace";
-    std::cout << "Command Trace write to " << trace_file_name << std::endl;
-    cmd_trace_.open(trace_file_name, std::ofstream::out);
-#endif  // CMD_TRACE
 }
 
-std::pair<AddressPair, int> Controller::ReturnDoneTrans(uint64_t clk) {
-    auto it = return_queue_.begin();
-    while (it != return_queue_.end()) {
-        if (clk >= it->complete_cycle) {
-            if (it->is_write) {
-                simple_stats_.Increment("num_writes_done");
-            } else if (it->is_copy){
-                simple_stats_.Increment("num_copies_done");
-            }
-            else {
-                simple_stats_.Increment("num_reads_done");
-                simple_stats_.AddValue("read_latency", clk_ - it->added_cycle);
-            }
-            auto pair = std::make_pair(it->addr, it->is_write);
-            it = return_queue_.erase(it);
-            return pair;
-        } else {
-            ++it;
+const std::vector<Transaction>& Controller::ReturnDoneTrans(uint64_t clk) {
+    const auto& done_trans = return_queue_.PopDone(clk);
+    for (const auto& trans : done_trans) {
+        if (trans.is_write) {
+            simple_stats_.Increment(CounterStat::NUM_WRITES_DONE);
+        } else if (trans.is_copy){
+            simple_stats_.Increment(CounterStat::NUM_COPIES_DONE);
+        }
+        else {
+            simple_stats_.Increment(CounterStat::NUM_READS_DONE);
+            simple_stats_.AddValue(HistoStat::READ_LATENCY,
+                                   clk_ - trans.added_cycle);
+            write_drain_.ReadDone(clk_ - trans.added_cycle);
         }
     }
-    return std::make_pair(-1, -1);
+    return done_trans;
 }
 
 void Controller::ClockTick() {
@@ -92,7 +89,7 @@ void Controller::ClockTick() {
             if (second_cmd.IsValid()) {
                 if (second_cmd.IsReadWrite() != cmd.IsReadWrite()) {
                     IssueCommand(second_cmd);
-                    simple_stats_.Increment("hbm_dual_cmds");
+                    simple_stats_.Increment(CounterStat::HBM_DUAL_CMDS);
                 }
             }
         }
@@ -101,14 +98,16 @@ void Controller::ClockTick() {
     // power updates pt 1
     for (int i = 0; i < config_.ranks; i++) {
         if (channel_state_.IsRankSelfRefreshing(i)) {
-            simple_stats_.IncrementVec("sref_cycles", i);
+            simple_stats_.IncrementVec(VecCounterStat::SREF_CYCLES, i);
         } else {
             bool all_idle = channel_state_.IsAllBankIdleInRank(i);
             if (all_idle) {
-                simple_stats_.IncrementVec("all_bank_idle_cycles", i);
+                simple_stats_.IncrementVec(VecCounterStat::ALL_BANK_IDLE_CYCLES,
+                                           i);
                 channel_state_.rank_idle_cycles[i] += 1;
             } else {
-                simple_stats_.IncrementVec("rank_active_cycles", i);
+                simple_stats_.IncrementVec(VecCounterStat::RANK_ACTIVE_CYCLES,
+                                           i);
                 // reset
                 channel_state_.rank_idle_cycles[i] = 0;
             }
@@ -150,24 +149,116 @@ void Controller::ClockTick() {
     ScheduleTransaction();
     clk_++;
     cmd_queue_.ClockTick();
-    simple_stats_.Increment("num_cycles");
+    simple_stats_.Increment(CounterStat::NUM_CYCLES);
     //cmd_queue_.printFlag();
     //std::cout<<clk_<<" end"<<std::endl;
     return;
 }
 
-bool Controller::WillAcceptTransaction(AddressPair hex_addr, bool is_write) const {
+uint64_t Controller::NextEventCycle() const {
+    // cheap checks first, the moment anything can happen in the coming cycle
+    // there's no point looking further
+    uint64_t next_event = refresh_.NextRefreshCycle();
+
+    // completed transactions to be returned
+    next_event = std::min(next_event, return_queue_.NextDueCycle());
+
+    // self refresh entry and exit
+    if (config_.enable_self_refresh) {
+        for (int i = 0; i < config_.ranks; i++) {
+            if (channel_state_.IsRankSelfRefreshing(i)) {
+                if (!cmd_queue_.rank_q_empty[i]) {
+                    return clk_;
+                }
+            } else if (cmd_queue_.rank_q_empty[i] &&
+                       channel_state_.IsAllBankIdleInRank(i)) {
+                // idle cycles are counted before the threshold is checked
+                int idle = channel_state_.rank_idle_cycles[i] + 1;
+                uint64_t sref_clk =
+                    idle >= config_.sref_threshold
+                        ? clk_
+                        : clk_ + config_.sref_threshold - idle;
+                next_event = std::min(next_event, sref_clk);
+            }
+        }
+    }
+    if (next_event <= clk_) {
+        return clk_;
+    }
+
+    // pending refresh, or any command that becomes ready
+    if (channel_state_.IsRefreshWaiting()) {
+        next_event = std::min(next_event, channel_state_.EarliestReadyCycle(
+                                              channel_state_.PendingRefCommand()));
+    }
+    next_event = std::min(next_event, cmd_queue_.EarliestReadyCycle());
+    if (next_event <= clk_ || WillScheduleTransaction()) {
+        return clk_;
+    }
+    return next_event;
+}
+
+void Controller::SkipCycles(uint64_t cycles) {
+    // same as ClockTick when no command is issued or scheduled
+    refresh_.SkipCycles(cycles);
+    for (int i = 0; i < config_.ranks; i++) {
+        if (channel_state_.IsRankSelfRefreshing(i)) {
+            simple_stats_.IncrementVecBy(VecCounterStat::SREF_CYCLES, i, cycles);
+        } else {
+            bool all_idle = channel_state_.IsAllBankIdleInRank(i);
+            if (all_idle) {
+                simple_stats_.IncrementVecBy(
+                    VecCounterStat::ALL_BANK_IDLE_CYCLES, i, cycles);
+                channel_state_.rank_idle_cycles[i] += cycles;
+            } else {
+                simple_stats_.IncrementVecBy(VecCounterStat::RANK_ACTIVE_CYCLES,
+                                             i, cycles);
+                channel_state_.rank_idle_cycles[i] = 0;
+            }
+        }
+    }
+    clk_ += cycles;
+    cmd_queue_.SkipCycles(cycles);
+    simple_stats_.IncrementBy(CounterStat::NUM_CYCLES, cycles);
+    return;
+}
+
+void Controller::WarmUp(Transaction trans) {
+    config_.DecodeAddresses(trans);
+    // the copy is done as a read of the source row and a write of the
+    // destination row
+    if (trans.is_copy) {
+        auto cmds = CopyTransToCommand(trans);
+        channel_state_.WarmUp(cmds.first);
+        channel_state_.WarmUp(cmds.second);
+    } else {
+        channel_state_.WarmUp(TransToCommand(trans));
+    }
+    return;
+}
+
+void Controller::WarmUpTo(uint64_t clk) {
+    if (clk > clk_) {
+        refresh_.WarmUpCycles(clk - clk_);
+        cmd_queue_.SkipCycles(clk - clk_);
+        clk_ = clk;
+    }
+    return;
+}
+
+bool Controller::WillAcceptTransaction(AddressPair hex_addr, bool is_write,
+                                       size_t in_flight) const {
     // Row Clone added
     if(hex_addr.is_copy){
-        return copy_queue_.size() < copy_queue_.capacity();
+        return copy_queue_.size() + in_flight < copy_queue_.capacity();
     }
 
     if (is_unified_queue_) {
-        return unified_queue_.size() < unified_queue_.capacity();
+        return unified_queue_.size() + in_flight < unified_queue_.capacity();
     } else if (!is_write) {
-        return read_queue_.size() < read_queue_.capacity();
+        return read_queue_.size() + in_flight < read_queue_.capacity();
     } else {
-        return write_buffer_.size() < write_buffer_.capacity();
+        return write_buffer_.size() + in_flight < write_buffer_.capacity();
     }
 }
 
@@ -182,29 +273,45 @@ void Controller::InCopyFlagDown(){
 
 bool Controller::AddTransaction(Transaction trans) {
     //std::cout<<clk_<<" addtransaction"<<std::endl;
+    if (trans.source_id < 0) {
+        // the scheduling policies index their per source state with it
+        std::cerr << "Negative source id " << trans.source_id << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     trans.added_cycle = clk_;
-    simple_stats_.AddValue("interarrival_latency", clk_ - last_trans_clk_);
+    config_.DecodeAddresses(trans);
+    simple_stats_.AddValue(HistoStat::INTERARRIVAL_LATENCY,
+                           clk_ - last_trans_clk_);
     last_trans_clk_ = clk_;
     
     // RowClone added
     if(trans.is_copy){ // if the transaction is copy operation
-		if(pending_wr_q_.count(trans.addr) > 0){ // if src_addr write is in pending queue
+		if(pending_wr_q_.Count(trans.addr) > 0){ // if src_addr write is in pending queue
             // write that value to dest_addr - change to write(dest_addr)
-            Transaction new_trans = Transaction(trans.addr.dest_addr, true);
-            if(is_unified_queue_){
-                unified_queue_.push_back(new_trans);
-            }
-            else{
-                write_buffer_.push_back(new_trans);
+            Transaction new_trans = Transaction(trans.addr.dest_addr, true,
+                                                trans.source_id, trans.req_id);
+            new_trans.added_cycle = clk_;
+            config_.DecodeAddresses(new_trans);
+            // like any other write, merged with one already buffered
+            if (pending_wr_q_.Count(new_trans.addr) == 0) {
+                pending_wr_q_.Insert(new_trans);
+                if (is_unified_queue_) {
+                    unified_queue_.push_back(new_trans);
+                } else {
+                    write_buffer_.push_back(new_trans);
+                }
             }
+            // and the copy is done once the write is buffered
+            trans.complete_cycle = clk_ + 1;
+            return_queue_.Add(trans);
             return true;
         }
         //std::cout<<"end check"<<std::endl;
         // new trans added to copy_queue_
-        pending_cp_q_.insert(std::make_pair(trans.addr, trans));
+        pending_cp_q_.Insert(trans);
         //std::cout<<pending_cp_q_.size()<<std::endl;
         
-        if(pending_cp_q_.count(trans.addr) == 1){
+        if(pending_cp_q_.Count(trans.addr) == 1){
             //std::cout<<"one"<<std::endl;
             copy_queue_.push_back(trans);
         }
@@ -212,8 +319,8 @@ bool Controller::AddTransaction(Transaction trans) {
         return true;
     }
     else if (trans.is_write) {
-        if (pending_wr_q_.count(trans.addr) == 0) {  // can not merge writes
-            pending_wr_q_.insert(std::make_pair(trans.addr, trans));
+        if (pending_wr_q_.Count(trans.addr) == 0) {  // can not merge writes
+            pending_wr_q_.Insert(trans);
             if (is_unified_queue_) {
                 unified_queue_.push_back(trans);
             } else {
@@ -221,17 +328,17 @@ bool Controller::AddTransaction(Transaction trans) {
             }
         }
         trans.complete_cycle = clk_ + 1;
-        return_queue_.push_back(trans);
+        return_queue_.Add(trans);
         return true;
     } else {  // read
         // if in write buffer, use the write buffer value
-        if (pending_wr_q_.count(trans.addr) > 0) {
+        if (pending_wr_q_.Count(trans.addr) > 0) {
             trans.complete_cycle = clk_ + 1;
-            return_queue_.push_back(trans);
+            return_queue_.Add(trans);
             return true;
         }
-        pending_rd_q_.insert(std::make_pair(trans.addr, trans));
-        if (pending_rd_q_.count(trans.addr) == 1) {
+        pending_rd_q_.Insert(trans);
+        if (pending_rd_q_.Count(trans.addr) == 1) {
             if (is_unified_queue_) {
                 unified_queue_.push_back(trans);
             } else {
@@ -243,172 +350,189 @@ bool Controller::AddTransaction(Transaction trans) {
 }
 
 void Controller::ScheduleTransaction() {
-    // determine whether to schedule read or write
-    if (write_draining_ == 0 && !is_unified_queue_) {
-        // we basically have a upper and lower threshold for write buffer
-        if ((write_buffer_.size() >= write_buffer_.capacity()) ||
-            (write_buffer_.size() > 8 && cmd_queue_.QueueEmpty())) {
-            write_draining_ = write_buffer_.size();
+    for (int i = 0; i < config_.trans_per_cycle; i++) {
+        if (!MoveTransaction()) {
+            break;
         }
     }
+    return;
+}
+
+bool Controller::MoveTransaction() {
+    // determine whether to schedule read or write
+    if (!write_drain_.IsDraining() && !is_unified_queue_ &&
+        write_drain_.ShouldStart(write_buffer_.size(),
+                                 cmd_queue_.QueueEmpty())) {
+        write_drain_.Start(write_buffer_.size());
+    }
 
 	
     // row clone added (about copy_queue_)
-    std::vector<Transaction> &queue =
+    TransactionQueue &queue =
         is_unified_queue_ ? unified_queue_
                           : copy_queue_.size() > 0 ? copy_queue_
-                          : write_draining_ > 0 ? write_buffer_: read_queue_;
-    for (auto it = queue.begin(); it != queue.end(); it++) {
-        // Row clone added
-        if(it->is_copy){
-            auto cmds = CopyTransToCommand(*it);
-            auto cmd_read = cmds.first;
-            auto cmd_write = cmds.second;
-            //cmd_write.addr.rank = cmd_read.addr.rank;
-            if(cmd_queue_.WillAcceptCommand(cmd_read.Rank(), cmd_read.Bankgroup(), cmd_read.Bank()) \
-                && cmd_queue_.WillAcceptCommand(cmd_write.Rank(), cmd_write.Bankgroup(), cmd_write.Bank(), 1)){
-                // TODO: write_draining_ 수정하기
-                if (pending_rd_q_.count(it->addr.dest_addr) > 0) {
-                    write_draining_ = 0;
-                    break;
-                }
+                          : write_drain_.IsDraining() ? write_buffer_: read_queue_;
 
-                //std::cout<<cmd_read.addr.rank<<" "<<cmd_write.addr.rank<<std::endl;
-                if(cmd_read.addr.bankgroup == cmd_write.addr.bankgroup && cmd_read.addr.bank == cmd_write.addr.bank){
-                    cmd_read.isFPM = true;
-                    cmd_write.isFPM = true;
+    // the oldest transaction to an open row first, then the oldest one
+    // that fits in the command queue. Copies take two banks and always go
+    // in order. Writes to an address with a read pending have to wait
+    // for the read, the ones after them can go ahead
+    auto it = queue.end();
+    if (trans_row_hit_first_ && &queue != &copy_queue_) {
+        int index = queue.OldestRowHit(
+            channel_state_, [this](int rank, int bankgroup, int bank) {
+                return cmd_queue_.WillAcceptCommand(rank, bankgroup, bank);
+            });
+        if (index >= 0 && !WaitsForRead(queue[index])) {
+            it = queue.begin() + index;
+        }
+    }
+    if (it == queue.end()) {
+        bool waiting = false;
+        for (it = queue.begin(); it != queue.end(); it++) {
+            if (it->is_copy) {
+                const auto &addr_read = it->src_address;
+                const auto &addr_write = it->dest_address;
+                if (cmd_queue_.WillAcceptCommand(addr_read.rank,
+                                                 addr_read.bankgroup,
+                                                 addr_read.bank) &&
+                    cmd_queue_.WillAcceptCommand(addr_write.rank,
+                                                 addr_write.bankgroup,
+                                                 addr_write.bank, 1)) {
+                    break;
                 }
-                else{
-                    cmd_read.isFPM = false;
-                    cmd_write.isFPM = false;
+            } else {
+                const auto &addr = it->src_address;
+                if (cmd_queue_.WillAcceptCommand(addr.rank, addr.bankgroup,
+                                                 addr.bank)) {
+                    if (!WaitsForRead(*it)) {
+                        break;
+                    }
+                    waiting = true;
                 }
-                cmd_queue_.AddCommand(cmd_read);
-                cmd_queue_.AddCommand(cmd_write);
-                //std::cout<<clk_<<" "<<cmd_read.hex_addr.src_addr<<" added "<<cmd_write.hex_addr.dest_addr<<std::endl;
-                queue.erase(it);
-                break;
             }
         }
+        if (it == queue.end()) {
+            if (waiting && write_drain_.IsDraining()) {
+                // the reads they wait for are stuck behind the drain
+                write_drain_.Stop();
+            }
+            return false;
+        }
+    }
+
+    // Row clone added
+    if(it->is_copy){
+        auto cmds = CopyTransToCommand(*it);
+        auto cmd_read = cmds.first;
+        auto cmd_write = cmds.second;
+        if (pending_rd_q_.Count(it->addr.dest_addr) > 0) {
+            write_drain_.Stop();
+            return false;
+        }
+
+        if(cmd_read.addr.bankgroup == cmd_write.addr.bankgroup && cmd_read.addr.bank == cmd_write.addr.bank){
+            cmd_read.isFPM = true;
+            cmd_write.isFPM = true;
+        }
         else{
-            auto cmd = TransToCommand(*it);
-            if (cmd_queue_.WillAcceptCommand(cmd.Rank(), cmd.Bankgroup(),
-                                            cmd.Bank())) {
-                if (!is_unified_queue_ && cmd.IsWrite()) {
-                    // Enforce R->W dependency
-                    if (pending_rd_q_.count(it->addr) > 0) {
-                        write_draining_ = 0;
-                        break;
-                    }
-                    write_draining_ -= 1;
-                }
-                cmd_queue_.AddCommand(cmd);
-                queue.erase(it);
-                break;
+            cmd_read.isFPM = false;
+            cmd_write.isFPM = false;
+        }
+        cmd_queue_.AddCommand(cmd_read);
+        cmd_queue_.AddCommand(cmd_write);
+    }
+    else{
+        auto cmd = TransToCommand(*it);
+        if (!is_unified_queue_ && cmd.IsWrite()) {
+            write_drain_.WriteMoved();
+        }
+        cmd_queue_.AddCommand(cmd);
+    }
+    queue.erase(it);
+    return true;
+}
+
+bool Controller::WillScheduleTransaction() const {
+    // whether ScheduleTransaction would change anything at all, mirrors the
+    // queue selection there
+    if (!write_drain_.IsDraining() && !is_unified_queue_ &&
+        write_drain_.ShouldStart(write_buffer_.size(),
+                                 cmd_queue_.QueueEmpty())) {
+        return true;
+    }
+    const TransactionQueue &queue =
+        is_unified_queue_ ? unified_queue_
+                          : copy_queue_.size() > 0 ? copy_queue_
+                          : write_drain_.IsDraining() ? write_buffer_: read_queue_;
+    for (const auto &trans : queue) {
+        if (trans.is_copy) {
+            const auto &addr_read = trans.src_address;
+            const auto &addr_write = trans.dest_address;
+            if (cmd_queue_.WillAcceptCommand(addr_read.rank,
+                                             addr_read.bankgroup,
+                                             addr_read.bank) &&
+                cmd_queue_.WillAcceptCommand(addr_write.rank,
+                                             addr_write.bankgroup,
+                                             addr_write.bank, 1)) {
+                return true;
+            }
+        } else {
+            const auto &addr = trans.src_address;
+            if (cmd_queue_.WillAcceptCommand(addr.rank, addr.bankgroup,
+                                             addr.bank)) {
+                return true;
             }
         }
     }
+    return false;
 }
 
 void Controller::IssueCommand(const Command &cmd) {
-#ifdef CMD_TRACE
-    cmd_trace_ << std::left << std::setw(18) << clk_ << " " << cmd << std::endl;
-#endif  // CMD_TRACE
+    if (cmd_tracer_) {
+        cmd_tracer_->Record(channel_id_, clk_, cmd);
+    }
 #ifdef THERMAL
     // add channel in, only needed by thermal module
     thermal_calc_.UpdateCMDPower(channel_id_, cmd, clk_);
 #endif  // THERMAL
 
-    // to get to know command's type
-    auto source = config_.AddressMapping(cmd.hex_addr.src_addr);
-    auto dest = config_.AddressMapping(cmd.hex_addr.dest_addr);
-    std::cout<<clk_<<" ";
-    switch(cmd.cmd_type){
-        case CommandType::READ:
-            std::cout<<"read"<<std::endl;
-            break;
-        case CommandType::READ_PRECHARGE:
-            std::cout<<"read_precharge"<<std::endl;
-            break;
-        case CommandType::READCOPY:
-            std::cout<<cmd.Rank()<<" "<<cmd.Bankgroup()<<" "<<cmd.Bank()<<" readcopy "<<dest.rank<<" "<<dest.bankgroup<<" "<<dest.bank<<std::endl;
-            break;
-        case CommandType::READCOPY_PRECHARGE:
-            std::cout<<"readcopy_precharge"<<std::endl;
-            break;
-        case CommandType::WRITE:
-            std::cout<<"write"<<std::endl;
-            break;
-        case CommandType::WRITE_PRECHARGE:
-            std::cout<<"write_precharge"<<std::endl;
-            break;
-        case CommandType::WRITECOPY:
-            std::cout<<source.rank<<" "<<source.bankgroup<<" "<<source.bank<<" writecopy "<<cmd.Rank()<<" "<<cmd.Bankgroup()<<" "<<cmd.Bank()<<std::endl;
-            break;
-        case CommandType::WRITECOPY_PRECHARGE:
-            std::cout<<"writecopy_precharge"<<std::endl;
-            break;
-        case CommandType::ACTIVATE:
-            std::cout<<"activate "<<cmd.Rank()<<" "<<cmd.Bankgroup()<<" "<<cmd.Bank()<<std::endl;
-            break;
-        case CommandType::PRECHARGE:
-            std::cout<<"precharge "<<cmd.Rank()<<" "<<cmd.Bankgroup()<<" "<<cmd.Bank()<<std::endl;
-            break;
-        case CommandType::REFRESH:
-            std::cout<<"refresh"<<std::endl;
-            break;
-        case CommandType::REFRESH_BANK:
-            std::cout<<"refresh_bank"<<std::endl;
-            break;
-        case CommandType::SREF_ENTER:
-            std::cout<<"sref_enter"<<std::endl;
-            break;
-        case CommandType::SREF_EXIT:
-            std::cout<<"sref_exit"<<std::endl;
-            break;
-        case CommandType::SIZE:
-            std::cout<<"error"<<std::endl;
-    }
     // if read/write, update pending queue and return queue
     if (cmd.IsRead()) {
-        auto num_reads = pending_rd_q_.count(cmd.hex_addr);
-        if (num_reads == 0) {
+        if (pending_rd_q_.Count(cmd.hex_addr) == 0) {
             std::cerr << cmd.hex_addr << " not in read queue! " << std::endl;
             exit(1);
         }
         // if there are multiple reads pending return them all
-        while (num_reads > 0) {
-            auto it = pending_rd_q_.find(cmd.hex_addr);
-            it->second.complete_cycle = clk_ + config_.read_delay;
-            return_queue_.push_back(it->second);
-            pending_rd_q_.erase(it);
-            num_reads -= 1;
+        Transaction trans;
+        while (pending_rd_q_.PopFront(cmd.hex_addr, trans)) {
+            trans.complete_cycle = clk_ + config_.read_delay;
+            return_queue_.Add(trans);
         }
+        write_drain_.ColumnIssued(false);
     } else if (cmd.IsWrite()) {
+        write_drain_.ColumnIssued(true);
         // there should be only 1 write to the same location at a time
-        auto it = pending_wr_q_.find(cmd.hex_addr);
-        if (it == pending_wr_q_.end()) {
+        Transaction trans;
+        if (!pending_wr_q_.PopFront(cmd.hex_addr, trans)) {
             std::cerr << cmd.hex_addr << " not in write queue!" << std::endl;
             exit(1);
         }
-        auto wr_lat = clk_ - it->second.added_cycle + config_.write_delay;
-        simple_stats_.AddValue("write_latency", wr_lat);
-        pending_wr_q_.erase(it);
+        auto wr_lat = clk_ - trans.added_cycle + config_.write_delay;
+        simple_stats_.AddValue(HistoStat::WRITE_LATENCY, wr_lat);
     } else if (cmd.IsReadCopy()) { // rowclone added
         // find exactly same copy from pending_copy_queue
         // if there is, return it
         //std::cout<<clk_<<" isreadcopy "<<pending_cp_q_.size()<<std::endl;
-        auto num_copys = pending_cp_q_.count(cmd.hex_addr);
-        if (num_copys == 0) {
+        if (pending_cp_q_.Count(cmd.hex_addr) == 0) {
             std::cerr << cmd.hex_addr << " not in copy queue! " << std::endl;
             exit(1);
         }
         // if there are multiple reads pending return them all
-        while (num_copys > 0) {
-            auto it = pending_cp_q_.find(cmd.hex_addr);
-            it->second.complete_cycle = clk_; // timing calculation
-            return_queue_.push_back(it->second);
-            pending_cp_q_.erase(it);
-            num_copys -= 1;
+        Transaction trans;
+        while (pending_cp_q_.PopFront(cmd.hex_addr, trans)) {
+            trans.complete_cycle = clk_; // timing calculation
+            return_queue_.Add(trans);
         }
         //std::cout<<"issue command read copy"<<std::endl;
     }
@@ -421,11 +545,11 @@ void Controller::IssueCommand(const Command &cmd) {
     // must update stats before states (for row hits)
     UpdateCommandStats(cmd);
     channel_state_.UpdateTimingAndStates(cmd, clk_);
+    cmd_queue_.UpdateReadyQueues(cmd);
     // TODO : update timing (calculation...OTL)
 }
 
 Command Controller::TransToCommand(const Transaction &trans) {
-    auto addr = config_.AddressMapping(trans.addr);
     CommandType cmd_type;
     if (row_buf_policy_ == RowBufPolicy::OPEN_PAGE) {
         cmd_type = trans.is_write ? CommandType::WRITE : CommandType::READ;
@@ -433,15 +557,17 @@ Command Controller::TransToCommand(const Transaction &trans) {
         cmd_type = trans.is_write ? CommandType::WRITE_PRECHARGE
                                   : CommandType::READ_PRECHARGE;
     }
-    return Command(cmd_type, addr, trans.addr);
+    Command cmd(cmd_type, trans.src_address, trans.addr);
+    cmd.source_id = trans.source_id;
+    cmd.added_cycle = trans.added_cycle;
+    return cmd;
 }
 
 // rowclone added
 std::pair<Command, Command> Controller::CopyTransToCommand(const Transaction &trans){
-    auto addr1 = config_.AddressMapping(trans.addr.src_addr); // for readcopy
-    auto addr2 = config_.AddressMapping(trans.addr.dest_addr); // for writecopy
+    const auto &addr1 = trans.src_address; // for readcopy
+    const auto &addr2 = trans.dest_address; // for writecopy
 
-    //std::cout << "CopyTransToCommand : " << addr1.rank * config_.banks + addr1.bankgroup * config_.banks_per_group + addr1.bank << " " << addr2.rank * config_.banks + addr2.bankgroup * config_.banks_per_group + addr2.bank << std::endl;
     CommandType cmd_type1, cmd_type2;
     if (row_buf_policy_ == RowBufPolicy::OPEN_PAGE){
         cmd_type1 = CommandType::READCOPY;
@@ -452,14 +578,21 @@ std::pair<Command, Command> Controller::CopyTransToCommand(const Transaction &tr
         cmd_type2 = CommandType::WRITECOPY_PRECHARGE;
         //std::cout<<clk_<<" readpre writepre"<<std::endl;
     }
-    return std::make_pair(Command(cmd_type1, addr1, trans.addr), Command(cmd_type2, addr2, trans.addr));
+    Command cmd1(cmd_type1, addr1, trans.addr), cmd2(cmd_type2, addr2, trans.addr);
+    for (auto cmd : {&cmd1, &cmd2}) {
+        cmd->source_id = trans.source_id;
+        cmd->added_cycle = trans.added_cycle;
+        cmd->dest_address = trans.dest_address;
+    }
+    return std::make_pair(cmd1, cmd2);
 }
 
 int Controller::QueueUsage() const { return cmd_queue_.QueueUsage(); }
 
 void Controller::PrintEpochStats() {
-    simple_stats_.Increment("epoch_num");
+    simple_stats_.Increment(CounterStat::EPOCH_NUM);
     simple_stats_.PrintEpochStats();
+    write_drain_.EpochUpdate();
 #ifdef THERMAL
     for (int r = 0; r < config_.ranks; r++) {
         double bg_energy = simple_stats_.RankBackgroundEnergy(r);
@@ -481,49 +614,67 @@ void Controller::PrintFinalStats() {
     return;
 }
 
+void Controller::Serialize(Checkpoint &cp) {
+    cp.Field(clk_);
+    cp.Field(simple_stats_);
+    cp.Field(channel_state_);
+    cp.Field(cmd_queue_);
+    cp.Field(refresh_);
+    cp.Field(unified_queue_);
+    cp.Field(read_queue_);
+    cp.Field(write_buffer_);
+    cp.Field(copy_queue_);
+    cp.Field(pending_cp_q_);
+    cp.Field(pending_rd_q_);
+    cp.Field(pending_wr_q_);
+    cp.Field(return_queue_);
+    cp.Field(last_trans_clk_);
+    cp.Field(write_drain_);
+}
+
 void Controller::UpdateCommandStats(const Command &cmd) {
     switch (cmd.cmd_type) {
         case CommandType::READ:
         case CommandType::READ_PRECHARGE:
-            simple_stats_.Increment("num_read_cmds");
+            simple_stats_.Increment(CounterStat::NUM_READ_CMDS);
             if (channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(),
                                            cmd.Bank()) != 0) {
-                simple_stats_.Increment("num_read_row_hits");
+                simple_stats_.Increment(CounterStat::NUM_READ_ROW_HITS);
             }
             break;
         case CommandType::WRITE:
         case CommandType::WRITE_PRECHARGE:
-            simple_stats_.Increment("num_write_cmds");
+            simple_stats_.Increment(CounterStat::NUM_WRITE_CMDS);
             if (channel_state_.RowHitCount(cmd.Rank(), cmd.Bankgroup(),
                                            cmd.Bank()) != 0) {
-                simple_stats_.Increment("num_write_row_hits");
+                simple_stats_.Increment(CounterStat::NUM_WRITE_ROW_HITS);
             }
             break;
         case CommandType::READCOPY:
         case CommandType::READCOPY_PRECHARGE:
-            simple_stats_.Increment("num_read_copy_cmds");
+            simple_stats_.Increment(CounterStat::NUM_READ_COPY_CMDS);
             break;
         case CommandType::WRITECOPY:
         case CommandType::WRITECOPY_PRECHARGE:
-            simple_stats_.Increment("num_write_copy_cmds");
+            simple_stats_.Increment(CounterStat::NUM_WRITE_COPY_CMDS);
             break;
         case CommandType::ACTIVATE:
-            simple_stats_.Increment("num_act_cmds");
+            simple_stats_.Increment(CounterStat::NUM_ACT_CMDS);
             break;
         case CommandType::PRECHARGE:
-            simple_stats_.Increment("num_pre_cmds");
+            simple_stats_.Increment(CounterStat::NUM_PRE_CMDS);
             break;
         case CommandType::REFRESH:
-            simple_stats_.Increment("num_ref_cmds");
+            simple_stats_.Increment(CounterStat::NUM_REF_CMDS);
             break;
         case CommandType::REFRESH_BANK:
-            simple_stats_.Increment("num_refb_cmds");
+            simple_stats_.Increment(CounterStat::NUM_REFB_CMDS);
             break;
         case CommandType::SREF_ENTER:
-            simple_stats_.Increment("num_srefe_cmds");
+            simple_stats_.Increment(CounterStat::NUM_SREFE_CMDS);
             break;
         case CommandType::SREF_EXIT:
-            simple_stats_.Increment("num_srefx_cmds");
+            simple_stats_.Increment(CounterStat::NUM_SREFX_CMDS);
             break;
         default:
             AbruptExit(__FILE__, __LINE__);
@@ -1,16 +1,20 @@
 #ifndef __CONTROLLER_H
 #define __CONTROLLER_H
 
-#include <fstream>
-#include <map>
 #include <unordered_set>
 #include <vector>
 #include <utility>
 #include "channel_state.h"
+#include "checkpoint.h"
+#include "cmd_trace.h"
 #include "command_queue.h"
 #include "common.h"
+#include "pending_table.h"
 #include "refresh.h"
+#include "return_queue.h"
 #include "simple_stats.h"
+#include "transaction_queue.h"
+#include "write_drain.h"
 
 #ifdef THERMAL
 #include "thermal.h"
@@ -29,19 +33,41 @@ class Controller {
     Controller(int channel, const Config &config, const Timing &timing);
 #endif  // THERMAL
     void ClockTick();
-    bool WillAcceptTransaction(AddressPair hex_addr, bool is_write) const;
+    // in_flight transactions still to be added ahead of this one are
+    // counted as if they all go to the same queue
+    bool WillAcceptTransaction(AddressPair hex_addr, bool is_write,
+                               size_t in_flight = 0) const;
     bool AddTransaction(Transaction trans);
     int QueueUsage() const;
     // Stats output
     void PrintEpochStats();
     void PrintFinalStats();
     void ResetStats() { simple_stats_.Reset(); }
-    std::pair<AddressPair, int> ReturnDoneTrans(uint64_t clock);
+    // all transactions completed by clock, valid until the next call
+    const std::vector<Transaction>& ReturnDoneTrans(uint64_t clock);
+
+    // skip-ahead clocking: nothing but the cycle counters changes in
+    // ClockTick before NextEventCycle(), so these cycles can be fast forwarded
+    uint64_t NextEventCycle() const;
+    void SkipCycles(uint64_t cycles);
+
+    // functional warm-up, only before any transaction is added. WarmUpTo
+    // lets the cycles up to clk go by with just the refreshes due in them,
+    // WarmUp leaves the banks trans goes to the way its commands would.
+    // Nothing is timed, queued or counted in the stats
+    void WarmUpTo(uint64_t clk);
+    void WarmUp(Transaction trans);
+
+    // issued commands are logged here if not null
+    void SetCommandTracer(CommandTracer *cmd_tracer) { cmd_tracer_ = cmd_tracer; }
 
     // RowClone added
     const Config* getConfig();
     void InCopyFlagDown();
 
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint &cp);
+
     int channel_id_;
 
    private:
@@ -58,34 +84,41 @@ class Controller {
 
     // queue that takes transactions from CPU side
     bool is_unified_queue_;
-    std::vector<Transaction> unified_queue_;
-    std::vector<Transaction> read_queue_;
-    std::vector<Transaction> write_buffer_;
+    TransactionQueue unified_queue_;
+    TransactionQueue read_queue_;
+    TransactionQueue write_buffer_;
 
     // Rowclone added
-    std::vector<Transaction> copy_queue_;
-    std::multimap<AddressPair, Transaction> pending_cp_q_;
+    TransactionQueue copy_queue_;
+    PendingTable pending_cp_q_;
 
-    // transactions that are not completed, use map for convenience
-    std::multimap<AddressPair, Transaction> pending_rd_q_;
-    std::multimap<AddressPair, Transaction> pending_wr_q_;
+    // transactions that are not completed, indexed by address
+    PendingTable pending_rd_q_;
+    PendingTable pending_wr_q_;
 
     // completed transactions
-    std::vector<Transaction> return_queue_;
+    ReturnQueue return_queue_;
 
     // row buffer policy
     RowBufPolicy row_buf_policy_;
 
-#ifdef CMD_TRACE
-    std::ofstream cmd_trace_;
-#endif  // CMD_TRACE
+    CommandTracer *cmd_tracer_;
 
     // used to calculate inter-arrival latency
     uint64_t last_trans_clk_;
 
     // transaction queueing
-    int write_draining_;
+    WriteDrain write_drain_;
+    bool trans_row_hit_first_;
     void ScheduleTransaction();
+    // moves a transaction into the command queue, false if none could go
+    bool MoveTransaction();
+    // write that has to wait for a read to the same address to go first
+    bool WaitsForRead(const Transaction &trans) const {
+        return !is_unified_queue_ && trans.is_write &&
+               pending_rd_q_.Count(trans.addr) > 0;
+    }
+    bool WillScheduleTransaction() const;
     void IssueCommand(const Command &tmp_cmd);
     Command TransToCommand(const Transaction &trans);
     void UpdateCommandStats(const Command &cmd);
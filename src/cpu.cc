@@ -1,8 +1,45 @@
 #include "cpu.h"
 #include <ctime>
+#include <sstream>
 
 namespace dramsim3 {
 
+namespace {
+// the generator state goes through its text form
+void SerializeGenerator(Checkpoint& cp, std::mt19937_64& gen) {
+    std::ostringstream os;
+    os << gen;
+    std::string state = os.str();
+    cp.Field(state);
+    if (!cp.IsSaving()) {
+        std::istringstream is(state);
+        is >> gen;
+    }
+}
+}  // namespace
+
+void CPU::WarmUp(uint64_t num_trans) {
+    std::cerr << "Warm-up needs a trace" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
+void CPU::SaveCheckpoint(const std::string& file_name) {
+    Checkpoint cp(file_name, true);
+    Serialize(cp);
+    cp.Close();
+}
+
+void CPU::RestoreCheckpoint(const std::string& file_name) {
+    Checkpoint cp(file_name, false);
+    Serialize(cp);
+    cp.Close();
+}
+
+void CPU::Serialize(Checkpoint& cp) {
+    cp.Field(clk_);
+    memory_system_.Serialize(cp);
+}
+
 void RandomCPU::ClockTick() {
     // Create random CPU requests at full speed
     // this is useful to exploit the parallelism of a DRAM protocol
@@ -72,17 +109,24 @@ void RandomCPU::ClockTick() {
     return;
 }
 
+void RandomCPU::Serialize(Checkpoint& cp) {
+    CPU::Serialize(cp);
+    cp.Field(last_addr_);
+    cp.Field(last_write_);
+    SerializeGenerator(cp, gen);
+    cp.Field(get_next_);
+    cp.Field(dest);
+    cp.Field(counter_);
+    cp.Field(dest1);
+    cp.Field(is_copy_);
+}
+
 AddressPair RandomCPU::getRandomAddress(){
    // uint64_t hex_addr = gen();
 	uint64_t hex_addr = dest;
 	
-    uint64_t channel_mask = conf_->ch_mask;
-    channel_mask = channel_mask << conf_->ch_pos;
-    channel_mask = channel_mask << conf_->shift_bits;
-
-    uint64_t rank_mask = conf_->ra_mask;
-    rank_mask = rank_mask << conf_->ra_pos;
-    rank_mask = rank_mask << conf_->shift_bits;
+    uint64_t channel_mask = conf_->FieldAddressBits(AddressField::CHANNEL);
+    uint64_t rank_mask = conf_->FieldAddressBits(AddressField::RANK);
 
     uint64_t uppermask = channel_mask | rank_mask;
     uint64_t mask = ~uppermask;
@@ -171,34 +215,296 @@ void StreamCPU::ClockTick() {
     return;
 }
 
+void StreamCPU::Serialize(Checkpoint& cp) {
+    CPU::Serialize(cp);
+    cp.Field(addr_a_);
+    cp.Field(addr_b_);
+    cp.Field(addr_c_);
+    cp.Field(offset_);
+    SerializeGenerator(cp, gen);
+    cp.Field(inserted_a_);
+    cp.Field(inserted_b_);
+    cp.Field(inserted_c_);
+    cp.Field(counter);
+    cp.Field(b_offset);
+    cp.Field(c_offset);
+}
+
 TraceBasedCPU::TraceBasedCPU(const std::string& config_file,
                              const std::string& output_dir,
-                             const std::string& trace_file)
-    : CPU(config_file, output_dir) {
-    trace_file_.open(trace_file);
-    if (trace_file_.fail()) {
-        std::cerr << "Trace file does not exist" << std::endl;
-        AbruptExit(__FILE__, __LINE__);
-    }
+                             const std::string& trace_file,
+                             uint64_t start_cycle)
+    : CPU(config_file, output_dir), trace_(trace_file, start_cycle) {
+    clk_ = start_cycle;
 }
 
 void TraceBasedCPU::ClockTick() {
     memory_system_.ClockTick();
-    if (!trace_file_.eof()) {
+    if (get_next_ && !trace_done_) {
+        get_next_ = false;
+        trace_done_ = !trace_.Next(trans_);
+    }
+    if (!trace_done_ && trans_.added_cycle <= clk_) {
+        get_next_ =
+            memory_system_.WillAcceptTransaction(trans_.addr, trans_.is_write);
         if (get_next_) {
-            get_next_ = false;
-            trace_file_ >> trans_;
+            memory_system_.AddTransaction(trans_.addr, trans_.is_write);
         }
-        if (trans_.added_cycle <= clk_) {
-            get_next_ = memory_system_.WillAcceptTransaction(trans_.addr,
-                                                             trans_.is_write);
-            if (get_next_) {
-                memory_system_.AddTransaction(trans_.addr, trans_.is_write);
-            }
+    }
+    clk_++;
+    return;
+}
+
+void TraceBasedCPU::WarmUp(uint64_t num_trans) {
+    Transaction trans;
+    for (uint64_t i = 0; i < num_trans && trace_.Next(trans); i++) {
+        if (trans.added_cycle > clk_) {
+            memory_system_.WarmUpCycles(trans.added_cycle - clk_);
+            clk_ = trans.added_cycle;
         }
+        memory_system_.WarmUp(trans.addr, trans.is_write);
+    }
+    memory_system_.EndWarmUp();
+    return;
+}
+
+void TraceBasedCPU::Serialize(Checkpoint& cp) {
+    CPU::Serialize(cp);
+    cp.Field(trace_);
+    cp.Field(trans_);
+    cp.Field(get_next_);
+    cp.Field(trace_done_);
+}
+
+namespace {
+// request ids are the core in the upper bits and its sequence number below
+const int kCoreShift = 48;
+const uint64_t kSeqMask = (1ull << kCoreShift) - 1;
+}  // namespace
+
+MultiCoreCPU::MultiCoreCPU(const std::string& config_file,
+                           const std::string& output_dir,
+                           const std::vector<std::string>& trace_files,
+                           int mshrs, int rob_size, bool round_robin,
+                           uint64_t start_cycle)
+    : CPU(config_file, output_dir),
+      mshrs_(mshrs),
+      rob_size_(rob_size),
+      round_robin_(round_robin),
+      first_core_(0),
+      start_cycle_(start_cycle) {
+    if (mshrs_ < 1 || rob_size < 0) {
+        std::cerr << "mshrs has to be at least 1 and rob_size at least 0"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    clk_ = start_cycle;
+    for (size_t i = 0; i < trace_files.size(); i++) {
+        cores_.emplace_back(new Core(i, trace_files[i], start_cycle));
+    }
+    auto callback = std::bind(&MultiCoreCPU::RequestDone, this,
+                              std::placeholders::_1, std::placeholders::_2);
+    memory_system_.RegisterRequestCallbacks(callback, callback);
+    // cores wait on their reads through the MSHRs and the ROB
+    memory_system_.SetClosedLoop();
+}
+
+void MultiCoreCPU::ClockTick() {
+    memory_system_.ClockTick();
+    for (size_t i = 0; i < cores_.size(); i++) {
+        IssueFromCore(*cores_[(first_core_ + i) % cores_.size()]);
+    }
+    if (round_robin_) {
+        first_core_ = (first_core_ + 1) % cores_.size();
     }
     clk_++;
     return;
 }
 
+void MultiCoreCPU::IssueFromCore(Core& core) {
+    if (!core.has_trans) {
+        if (core.trace_done || !core.trace.Next(core.trans)) {
+            core.trace_done = true;
+            return;
+        }
+        core.has_trans = true;
+    }
+    if (core.trans.added_cycle + core.delay > clk_) {
+        return;
+    }
+    const Transaction& trans = core.trans;
+    bool blocking = !trans.is_write;
+    if ((blocking && core.in_flight >= mshrs_) ||
+        (rob_size_ > 0 && core.rob.size() >= rob_size_) ||
+        !memory_system_.WillAcceptTransaction(trans.addr, trans.is_write)) {
+        core.delay++;
+        core.stall_cycles++;
+        return;
+    }
+
+    uint64_t seq = core.next_seq++;
+    uint64_t req_id = static_cast<uint64_t>(core.id) << kCoreShift | seq;
+    memory_system_.AddRequest(req_id, trans.addr, trans.is_write, core.id);
+    core.pending[seq] = {clk_, trans.is_write, trans.is_copy};
+    if (trans.is_copy) {
+        core.num_copies++;
+    } else if (trans.is_write) {
+        core.num_writes++;
+    } else {
+        core.num_reads++;
+    }
+    if (blocking) {
+        core.in_flight++;
+    }
+    if (rob_size_ > 0) {
+        core.rob.push_back(!blocking);
+        while (!core.rob.empty() && core.rob.front()) {
+            core.rob.pop_front();
+        }
+    }
+    core.has_trans = false;
+    return;
+}
+
+void MultiCoreCPU::WarmUp(uint64_t num_trans) {
+    for (uint64_t i = 0; i < num_trans; i++) {
+        Core* next_core = nullptr;
+        for (auto& core : cores_) {
+            if (!core->has_trans && !core->trace_done) {
+                core->has_trans = core->trace.Next(core->trans);
+                core->trace_done = !core->has_trans;
+            }
+            if (core->has_trans &&
+                (!next_core ||
+                 core->trans.added_cycle < next_core->trans.added_cycle)) {
+                next_core = core.get();
+            }
+        }
+        if (!next_core) {
+            break;
+        }
+        const Transaction& trans = next_core->trans;
+        if (trans.added_cycle > clk_) {
+            memory_system_.WarmUpCycles(trans.added_cycle - clk_);
+            clk_ = trans.added_cycle;
+        }
+        memory_system_.WarmUp(trans.addr, trans.is_write);
+        next_core->has_trans = false;
+    }
+    memory_system_.EndWarmUp();
+    return;
+}
+
+void MultiCoreCPU::RequestDone(uint64_t req_id, AddressPair addr) {
+    uint64_t core_id = req_id >> kCoreShift;
+    uint64_t seq = req_id & kSeqMask;
+    if (core_id >= cores_.size() ||
+        cores_[core_id]->pending.count(seq) == 0) {
+        std::cerr << "Request " << seq << " of core " << core_id
+                  << " completed but is not pending" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    Core& core = *cores_[core_id];
+    auto it = core.pending.find(seq);
+    uint64_t latency = clk_ - it->second.issue_clk;
+    if (it->second.is_copy) {
+        core.num_copies_done++;
+    } else if (it->second.is_write) {
+        core.num_writes_done++;
+        core.write_latency += latency;
+    } else {
+        core.num_reads_done++;
+        core.read_latency += latency;
+    }
+    if (!it->second.is_write) {
+        core.in_flight--;
+        if (rob_size_ > 0) {
+            // the oldest entry in the window is next_seq - rob.size()
+            core.rob[seq - (core.next_seq - core.rob.size())] = true;
+            while (!core.rob.empty() && core.rob.front()) {
+                core.rob.pop_front();
+            }
+        }
+    }
+    core.pending.erase(it);
+    return;
+}
+
+void MultiCoreCPU::Serialize(Checkpoint& cp) {
+    CPU::Serialize(cp);
+    cp.Expect(cores_.size(), "cores");
+    cp.Field(first_core_);
+    for (auto& core : cores_) {
+        cp.Field(*core);
+    }
+}
+
+void MultiCoreCPU::Pending::Serialize(Checkpoint& cp) {
+    cp.Field(issue_clk);
+    cp.Field(is_write);
+    cp.Field(is_copy);
+}
+
+void MultiCoreCPU::Core::Serialize(Checkpoint& cp) {
+    cp.Field(trace);
+    cp.Field(trans);
+    cp.Field(has_trans);
+    cp.Field(trace_done);
+    cp.Field(delay);
+    cp.Field(next_seq);
+    cp.Field(in_flight);
+    cp.Field(rob);
+    cp.Field(pending);
+    cp.Field(num_reads);
+    cp.Field(num_writes);
+    cp.Field(num_copies);
+    cp.Field(num_reads_done);
+    cp.Field(num_writes_done);
+    cp.Field(num_copies_done);
+    cp.Field(read_latency);
+    cp.Field(write_latency);
+    cp.Field(stall_cycles);
+}
+
+void MultiCoreCPU::PrintStats() {
+    memory_system_.PrintStats();
+    double time = (clk_ - start_cycle_) * memory_system_.GetTCK();
+    double request_bytes =
+        memory_system_.GetBusBits() / 8 * memory_system_.GetBurstLength();
+    std::ofstream json_out(conf_->output_prefix + "cores.json");
+    json_out << "{";
+    for (const auto& core_ptr : cores_) {
+        const Core& core = *core_ptr;
+        uint64_t done =
+            core.num_reads_done + core.num_writes_done + core.num_copies_done;
+        double read_latency =
+            core.num_reads_done > 0
+                ? static_cast<double>(core.read_latency) / core.num_reads_done
+                : 0;
+        double write_latency =
+            core.num_writes_done > 0
+                ? static_cast<double>(core.write_latency) / core.num_writes_done
+                : 0;
+        double bandwidth = time > 0 ? done * request_bytes / time : 0;
+        std::cout << "core " << core.id << ": " << core.num_reads_done
+                  << " reads, " << core.num_writes_done << " writes, "
+                  << core.num_copies_done << " copies done, read latency "
+                  << read_latency << ", " << bandwidth << " GB/s, "
+                  << core.stall_cycles << " stall cycles" << std::endl;
+        json_out << (core.id > 0 ? ",\n" : "") << "\"" << core.id << "\":{"
+                 << "\"average_bandwidth\":" << bandwidth << ","
+                 << "\"average_read_latency\":" << read_latency << ","
+                 << "\"average_write_latency\":" << write_latency << ","
+                 << "\"num_copies\":" << core.num_copies << ","
+                 << "\"num_copies_done\":" << core.num_copies_done << ","
+                 << "\"num_reads\":" << core.num_reads << ","
+                 << "\"num_reads_done\":" << core.num_reads_done << ","
+                 << "\"num_writes\":" << core.num_writes << ","
+                 << "\"num_writes_done\":" << core.num_writes_done << ","
+                 << "\"stall_cycles\":" << core.stall_cycles << "}";
+    }
+    json_out << "}";
+    return;
+}
+
 }  // namespace dramsim3
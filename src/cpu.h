@@ -1,11 +1,16 @@
 #ifndef __CPU_H
 #define __CPU_H
 
+#include <deque>
 #include <fstream>
 #include <functional>
+#include <memory>
 #include <random>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "memory_system.h"
+#include "trace_prefetcher.h"
 
 namespace dramsim3 {
 
@@ -20,10 +25,20 @@ class CPU {
           {
               conf_ = memory_system_.getConfig();
           }
+    virtual ~CPU() {}
     virtual void ClockTick() = 0;
     void ReadCallBack(AddressPair addr) { return; }
     void WriteCallBack(AddressPair addr) { return; }
-    void PrintStats() { memory_system_.PrintStats(); }
+    virtual void PrintStats() { memory_system_.PrintStats(); }
+    // runs the next num_trans transactions through a functional warm-up
+    // of the memory system, then resets the stats. Trace front ends only
+    virtual void WarmUp(uint64_t num_trans);
+
+    // the front end along with the memory system, see Checkpoint. The
+    // restoring run has to be set up with the same traces
+    void SaveCheckpoint(const std::string& file_name);
+    void RestoreCheckpoint(const std::string& file_name);
+    virtual void Serialize(Checkpoint& cp);
 
    protected:
     MemorySystem memory_system_;
@@ -40,6 +55,7 @@ class RandomCPU : public CPU {
 
     // Rowclone added
     AddressPair getRandomAddress(); // for two same rank address
+    void Serialize(Checkpoint& cp) override;
 
    private:
     AddressPair last_addr_;
@@ -57,6 +73,7 @@ class StreamCPU : public CPU {
    public:
     using CPU::CPU;
     void ClockTick() override;
+    void Serialize(Checkpoint& cp) override;
 
    private:
     AddressPair addr_a_, addr_b_, addr_c_, offset_ = 0;
@@ -74,15 +91,92 @@ class StreamCPU : public CPU {
 
 class TraceBasedCPU : public CPU {
    public:
+    // text or binary trace, the run starts with the first transaction
+    // added at or after start_cycle
     TraceBasedCPU(const std::string& config_file, const std::string& output_dir,
-                  const std::string& trace_file);
-    ~TraceBasedCPU() { trace_file_.close(); }
+                  const std::string& trace_file, uint64_t start_cycle = 0);
     void ClockTick() override;
+    void WarmUp(uint64_t num_trans) override;
+    void Serialize(Checkpoint& cp) override;
 
    private:
-    std::ifstream trace_file_;
+    TracePrefetcher trace_;
     Transaction trans_;
     bool get_next_ = true;
+    bool trace_done_ = false;
+};
+
+// One trace per core. A core issues its next transaction once the trace
+// says so, as long as it has fewer than mshrs reads and copies in flight
+// and, with rob_size set, fewer than rob_size transactions that haven't
+// retired in order yet, writes retiring as soon as they are issued. Cycles
+// a core is held back push the rest of its trace back as well. Cores go
+// round robin, or in core order with priority injection
+class MultiCoreCPU : public CPU {
+   public:
+    MultiCoreCPU(const std::string& config_file, const std::string& output_dir,
+                 const std::vector<std::string>& trace_files, int mshrs,
+                 int rob_size, bool round_robin, uint64_t start_cycle = 0);
+    void ClockTick() override;
+    void PrintStats() override;
+    // the transactions of all cores, in the order they are added in
+    void WarmUp(uint64_t num_trans) override;
+    void Serialize(Checkpoint& cp) override;
+
+    // reads and copies of the core in flight, and its ROB entries
+    int InFlight(int core) const { return cores_[core]->in_flight; }
+    size_t RobEntries(int core) const { return cores_[core]->rob.size(); }
+    uint64_t StallCycles(int core) const { return cores_[core]->stall_cycles; }
+    uint64_t Done(int core) const {
+        return cores_[core]->num_reads_done + cores_[core]->num_writes_done +
+               cores_[core]->num_copies_done;
+    }
+
+   private:
+    struct Pending {
+        uint64_t issue_clk;
+        bool is_write;
+        bool is_copy;
+        void Serialize(Checkpoint& cp);
+    };
+
+    struct Core {
+        Core(int id, const std::string& trace_file, uint64_t start_cycle)
+            : id(id), trace(trace_file, start_cycle) {}
+        int id;
+        TracePrefetcher trace;
+        Transaction trans;
+        bool has_trans = false;
+        bool trace_done = false;
+        // how far the trace has been pushed back
+        uint64_t delay = 0;
+        uint64_t next_seq = 0;
+        int in_flight = 0;
+        // one entry per transaction since the oldest one not retired
+        std::deque<bool> rob;
+        std::unordered_map<uint64_t, Pending> pending;
+
+        uint64_t num_reads = 0;
+        uint64_t num_writes = 0;
+        uint64_t num_copies = 0;
+        uint64_t num_reads_done = 0;
+        uint64_t num_writes_done = 0;
+        uint64_t num_copies_done = 0;
+        uint64_t read_latency = 0;
+        uint64_t write_latency = 0;
+        uint64_t stall_cycles = 0;
+        void Serialize(Checkpoint& cp);
+    };
+
+    std::vector<std::unique_ptr<Core>> cores_;
+    int mshrs_;
+    size_t rob_size_;
+    bool round_robin_;
+    size_t first_core_;
+    uint64_t start_cycle_;
+
+    void IssueFromCore(Core& core);
+    void RequestDone(uint64_t req_id, AddressPair addr);
 };
 
 }  // namespace dramsim3
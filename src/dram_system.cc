@@ -1,6 +1,7 @@
 #include "dram_system.h"
 
 #include <assert.h>
+#include <limits>
 
 namespace dramsim3 {
 
@@ -13,27 +14,57 @@ BaseDRAMSystem::BaseDRAMSystem(Config &config, const std::string &output_dir,
                                std::function<void(AddressPair)> write_callback)
     : read_callback_(read_callback),
       write_callback_(write_callback),
+      id_(0),
       last_req_clk_(0),
       config_(config),
       timing_(config_),
+      sync_quantum_(config_.sync_quantum),
 #ifdef THERMAL
       thermal_calc_(config_),
 #endif  // THERMAL
       clk_(0) {
     total_channels_ += config_.channels;
 
-#ifdef ADDR_TRACE
-    std::string addr_trace_name = config_.output_prefix + "addr.trace";
-    address_trace_.open(addr_trace_name);
-#endif
+    if (config_.cmd_trace) {
+        cmd_tracer_.reset(new CommandTracer(config_));
+    }
+    if (config_.addr_trace) {
+        std::string addr_trace_name = config_.output_prefix + "addr.trace";
+        address_trace_.open(addr_trace_name);
+    }
+}
+
+const std::vector<int>& BaseDRAMSystem::AddRequests(const Request* requests,
+                                                    size_t num_requests) {
+    accepted_.assign(config_.channels, 0);
+    channel_full_.assign(config_.channels, false);
+    for (size_t i = 0; i < num_requests; i++) {
+        const Request& req = requests[i];
+        int channel = GetChannel(req.hex_addr);
+        if (channel_full_[channel]) {
+            continue;
+        }
+        if (WillAcceptTransaction(req.hex_addr, req.is_write) &&
+            AddRequest(req.req_id, req.hex_addr, req.is_write,
+                       req.source_id)) {
+            accepted_[channel]++;
+        } else {
+            channel_full_[channel] = true;
+        }
+    }
+    return accepted_;
 }
 
 int BaseDRAMSystem::GetChannel(AddressPair hex_addr) const {
+    if (config_.HasBitFieldMapping()) {
+        return config_.AddressMapping(hex_addr.src_addr).channel;
+    }
     hex_addr >>= config_.shift_bits;
     return (hex_addr >> config_.ch_pos) & config_.ch_mask;
 }
 
 void BaseDRAMSystem::PrintEpochStats() {
+    CatchUpControllers();
     // first epoch, print bracket
     if (clk_ - config_.epoch_period == 0) {
         std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::out);
@@ -51,6 +82,7 @@ void BaseDRAMSystem::PrintEpochStats() {
 }
 
 void BaseDRAMSystem::PrintStats() {
+    CatchUpControllers();
     // Finish epoch output, remove last comma and append ]
     std::ofstream epoch_out(config_.json_epoch_name, std::ios_base::in |
                                                          std::ios_base::out |
@@ -80,11 +112,45 @@ void BaseDRAMSystem::PrintStats() {
 }
 
 void BaseDRAMSystem::ResetStats() {
+    CatchUpControllers();
     for (size_t i = 0; i < ctrls_.size(); i++) {
         ctrls_[i]->ResetStats();
     }
 }
 
+void BaseDRAMSystem::Serialize(Checkpoint &cp) {
+    CatchUpControllers();
+    cp.Expect(config_.channels, "channels");
+    cp.Expect(config_.ranks, "ranks");
+    cp.Expect(config_.bankgroups, "bankgroups");
+    cp.Expect(config_.banks_per_group, "banks per group");
+    cp.Field(clk_);
+    cp.Field(id_);
+    cp.Field(last_req_clk_);
+    cp.Field(completions_);
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        cp.Field(*ctrls_[i]);
+    }
+    if (!cp.IsSaving()) {
+        StartEpochOutput();
+    }
+    return;
+}
+
+void BaseDRAMSystem::EndWarmUp() {
+    ResetStats();
+    StartEpochOutput();
+    return;
+}
+
+void BaseDRAMSystem::StartEpochOutput() {
+    if (clk_ >= static_cast<uint64_t>(config_.epoch_period)) {
+        std::ofstream epoch_out(config_.json_epoch_name, std::ofstream::out);
+        epoch_out << "[";
+    }
+    return;
+}
+
 void BaseDRAMSystem::RegisterCallbacks(
     std::function<void(AddressPair)> read_callback,
     std::function<void(AddressPair)> write_callback) {
@@ -93,6 +159,13 @@ void BaseDRAMSystem::RegisterCallbacks(
     write_callback_ = write_callback;
 }
 
+void BaseDRAMSystem::RegisterRequestCallbacks(
+    std::function<void(uint64_t, AddressPair)> read_callback,
+    std::function<void(uint64_t, AddressPair)> write_callback) {
+    read_req_callback_ = read_callback;
+    write_req_callback_ = write_callback;
+}
+
 // Row Clone added
 const Config* BaseDRAMSystem::getConfig(){
     return ctrls_[0]->getConfig();
@@ -101,7 +174,9 @@ const Config* BaseDRAMSystem::getConfig(){
 JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
                                  std::function<void(AddressPair)> read_callback,
                                  std::function<void(AddressPair)> write_callback)
-    : BaseDRAMSystem(config, output_dir, read_callback, write_callback) {
+    : BaseDRAMSystem(config, output_dir, read_callback, write_callback),
+      ctrl_clk_(0),
+      next_event_clk_(0) {
     if (config_.IsHMC()) {
         std::cerr << "Initialized a memory system with an HMC config file!"
                   << std::endl;
@@ -114,11 +189,23 @@ JedecDRAMSystem::JedecDRAMSystem(Config &config, const std::string &output_dir,
         ctrls_.push_back(new Controller(i, config_, timing_, thermal_calc_));
 #else
         ctrls_.push_back(new Controller(i, config_, timing_));
+#endif  // THERMAL
+        ctrls_[i]->SetCommandTracer(cmd_tracer_.get());
+    }
+
+    if (config_.channel_threads > 1) {
+#ifdef THERMAL
+        // the thermal model is shared by all channels
+        std::cerr << "channel_threads ignored with thermal simulation"
+                  << std::endl;
+#else
+        channel_workers_.reset(new ChannelWorkers(config_, ctrls_));
 #endif  // THERMAL
     }
 }
 
 JedecDRAMSystem::~JedecDRAMSystem() {
+    channel_workers_.reset();
     for (auto it = ctrls_.begin(); it != ctrls_.end(); it++) {
         delete (*it);
     }
@@ -126,51 +213,182 @@ JedecDRAMSystem::~JedecDRAMSystem() {
 
 bool JedecDRAMSystem::WillAcceptTransaction(AddressPair hex_addr,
                                             bool is_write) const {
-    int channel = GetChannel(hex_addr);
-    return ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write);
+    return ChannelWillAccept(GetChannel(hex_addr), hex_addr, is_write);
 }
 
-bool JedecDRAMSystem::AddTransaction(AddressPair hex_addr, bool is_write) {
-// Record trace - Record address trace for debugging or other purposes
-#ifdef ADDR_TRACE
-    address_trace_ << std::hex << hex_addr << std::dec << " "
-                   << (is_write ? "WRITE " : "READ ") << clk_ << std::endl;
-#endif
-
+bool JedecDRAMSystem::AddRequest(uint64_t req_id, AddressPair hex_addr,
+                                 bool is_write, int source_id) {
     int channel = GetChannel(hex_addr);
-    bool ok = ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write);
+    bool ok = ChannelWillAccept(channel, hex_addr, is_write);
 
     assert(ok);
     if (ok) {
-        Transaction trans = Transaction(hex_addr, is_write);
-        ctrls_[channel]->AddTransaction(trans);
+        AddToChannel(channel,
+                     Transaction(hex_addr, is_write, source_id, req_id));
     }
     last_req_clk_ = clk_;
     return ok;
 }
 
+const std::vector<int>& JedecDRAMSystem::AddRequests(const Request* requests,
+                                                     size_t num_requests) {
+    // same as the base version, with the channel decoded once per request
+    accepted_.assign(config_.channels, 0);
+    channel_full_.assign(config_.channels, false);
+    for (size_t i = 0; i < num_requests; i++) {
+        const Request& req = requests[i];
+        int channel = GetChannel(req.hex_addr);
+        if (channel_full_[channel]) {
+            continue;
+        }
+        if (ChannelWillAccept(channel, req.hex_addr, req.is_write)) {
+            AddToChannel(channel, Transaction(req.hex_addr, req.is_write,
+                                              req.source_id, req.req_id));
+            accepted_[channel]++;
+        } else {
+            channel_full_[channel] = true;
+        }
+    }
+    last_req_clk_ = clk_;
+    return accepted_;
+}
+
+bool JedecDRAMSystem::ChannelWillAccept(int channel, AddressPair hex_addr,
+                                        bool is_write) const {
+    if (channel_workers_) {
+        return channel_workers_->WillAcceptTransaction(channel, hex_addr,
+                                                       is_write, clk_);
+    }
+    return ctrls_[channel]->WillAcceptTransaction(hex_addr, is_write);
+}
+
+void JedecDRAMSystem::AddToChannel(int channel, const Transaction &trans) {
+    // Record trace - Record address trace for debugging or other purposes
+    if (config_.addr_trace) {
+        address_trace_ << std::hex << trans.addr << std::dec << " "
+                       << (trans.is_write ? "WRITE " : "READ ") << clk_
+                       << std::endl;
+    }
+    if (channel_workers_) {
+        channel_workers_->AddTransaction(channel, trans, clk_);
+    } else {
+        CatchUpControllers();
+        ctrls_[channel]->AddTransaction(trans);
+        next_event_clk_ = clk_;
+    }
+    return;
+}
+
 void JedecDRAMSystem::ClockTick() {
+    if (channel_workers_) {
+        // the channels run in batches of sync_quantum cycles, completions
+        // are returned at the end of each batch
+        clk_++;
+        if (clk_ % sync_quantum_ == 0) {
+            SyncChannels();
+        }
+        if (clk_ % config_.epoch_period == 0) {
+            PrintEpochStats();
+        }
+        return;
+    }
+
+    if (config_.enable_skip_ahead) {
+        if (clk_ < next_event_clk_) {
+            clk_++;
+            if (clk_ % config_.epoch_period == 0) {
+                PrintEpochStats();
+                // controllers adapt at epochs, look again at what's next
+                next_event_clk_ = clk_;
+            }
+            return;
+        }
+        CatchUpControllers();
+    }
+
     for (size_t i = 0; i < ctrls_.size(); i++) {
         // look ahead and return earlier
-        while (true) {
-            auto pair = ctrls_[i]->ReturnDoneTrans(clk_);
-            if (pair.second == 1) {
-                write_callback_(pair.first);
-            } else if (pair.second == 0) {
-                read_callback_(pair.first);
-            } else {
-                break;
-            }
+        for (const auto &trans : ctrls_[i]->ReturnDoneTrans(clk_)) {
+            ReturnRequest(trans.req_id, trans.addr, trans.is_write);
         }
     }
     for (size_t i = 0; i < ctrls_.size(); i++) {
         ctrls_[i]->ClockTick();
     }
     clk_++;
+    ctrl_clk_ = clk_;
 
     if (clk_ % config_.epoch_period == 0) {
         PrintEpochStats();
     }
+    if (config_.enable_skip_ahead) {
+        UpdateNextEvent();
+    }
+    return;
+}
+
+void JedecDRAMSystem::Serialize(Checkpoint &cp) {
+    BaseDRAMSystem::Serialize(cp);
+    // every controller is at clk_ now
+    ctrl_clk_ = clk_;
+    next_event_clk_ = clk_;
+    if (channel_workers_ && !cp.IsSaving()) {
+        channel_workers_->Restart(clk_);
+    }
+    return;
+}
+
+void JedecDRAMSystem::WarmUp(AddressPair hex_addr, bool is_write) {
+    // a channel is only brought up to clk_ when it's used
+    auto ctrl = ctrls_[GetChannel(hex_addr)];
+    ctrl->WarmUpTo(clk_);
+    ctrl->WarmUp(Transaction(hex_addr, is_write));
+    return;
+}
+
+void JedecDRAMSystem::EndWarmUp() {
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        ctrls_[i]->WarmUpTo(clk_);
+    }
+    ctrl_clk_ = clk_;
+    next_event_clk_ = clk_;
+    if (channel_workers_) {
+        channel_workers_->Restart(clk_);
+    }
+    BaseDRAMSystem::EndWarmUp();
+    return;
+}
+
+void JedecDRAMSystem::CatchUpControllers() {
+    if (channel_workers_) {
+        SyncChannels();
+        return;
+    }
+    if (ctrl_clk_ < clk_) {
+        for (size_t i = 0; i < ctrls_.size(); i++) {
+            ctrls_[i]->SkipCycles(clk_ - ctrl_clk_);
+        }
+        ctrl_clk_ = clk_;
+    }
+    return;
+}
+
+void JedecDRAMSystem::UpdateNextEvent() {
+    next_event_clk_ = std::numeric_limits<uint64_t>::max();
+    for (size_t i = 0; i < ctrls_.size(); i++) {
+        next_event_clk_ =
+            std::min(next_event_clk_, ctrls_[i]->NextEventCycle());
+        if (next_event_clk_ <= clk_) {
+            break;
+        }
+    }
+    return;
+}
+
+void JedecDRAMSystem::SyncChannels() {
+    for (const auto &trans : channel_workers_->Sync(clk_)) {
+        ReturnRequest(trans.req_id, trans.addr, trans.is_write);
+    }
     return;
 }
 
@@ -182,8 +400,15 @@ IdealDRAMSystem::IdealDRAMSystem(Config &config, const std::string &output_dir,
 
 IdealDRAMSystem::~IdealDRAMSystem() {}
 
-bool IdealDRAMSystem::AddTransaction(AddressPair hex_addr, bool is_write) {
-    auto trans = Transaction(hex_addr, is_write);
+void IdealDRAMSystem::Serialize(Checkpoint &cp) {
+    BaseDRAMSystem::Serialize(cp);
+    cp.Field(infinite_buffer_q_);
+    return;
+}
+
+bool IdealDRAMSystem::AddRequest(uint64_t req_id, AddressPair hex_addr,
+                                 bool is_write, int source_id) {
+    auto trans = Transaction(hex_addr, is_write, source_id, req_id);
     trans.added_cycle = clk_;
     infinite_buffer_q_.push_back(trans);
     return true;
@@ -193,11 +418,8 @@ void IdealDRAMSystem::ClockTick() {
     for (auto trans_it = infinite_buffer_q_.begin();
          trans_it != infinite_buffer_q_.end();) {
         if (clk_ - trans_it->added_cycle >= static_cast<uint64_t>(latency_)) {
-            if (trans_it->is_write) {
-                write_callback_(trans_it->addr);
-            } else {
-                read_callback_(trans_it->addr);
-            }
+            ReturnRequest(trans_it->req_id, trans_it->addr,
+                          trans_it->is_write);
             trans_it = infinite_buffer_q_.erase(trans_it++);
         }
         if (trans_it != infinite_buffer_q_.end()) {
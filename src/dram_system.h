@@ -2,10 +2,15 @@
 #define __DRAM_SYSTEM_H
 
 #include <fstream>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "channel_workers.h"
+#include "checkpoint.h"
+#include "cmd_trace.h"
 #include "common.h"
+#include "completion_ring.h"
 #include "configuration.h"
 #include "controller.h"
 #include "timing.h"
@@ -28,13 +33,55 @@ class BaseDRAMSystem {
     void PrintStats();
     void ResetStats();
 
+    // requests registered with RegisterRequestCallbacks get req_id back
+    // when they complete, instead of just the address
+    void RegisterRequestCallbacks(
+        std::function<void(uint64_t, AddressPair)> read_callback,
+        std::function<void(uint64_t, AddressPair)> write_callback);
+
     virtual bool WillAcceptTransaction(AddressPair hex_addr,
                                        bool is_write) const = 0;
-    virtual bool AddTransaction(AddressPair hex_addr, bool is_write) = 0;
+    // source_id tells the requesting cores apart for the scheduling policies
+    bool AddTransaction(AddressPair hex_addr, bool is_write,
+                        int source_id = 0) {
+        return AddRequest(kInternalReqIds | id_++, hex_addr, is_write,
+                          source_id);
+    }
+    // the ids AddTransaction makes up have the top bit set, so they never
+    // collide with the ones a host picks
+    static const uint64_t kInternalReqIds = 1ull << 63;
+    // req_id has to be unique among the requests in flight
+    virtual bool AddRequest(uint64_t req_id, AddressPair hex_addr,
+                            bool is_write, int source_id = 0) = 0;
+    // adds the requests in order, except that once a channel turns one down
+    // the ones after it to the same channel are not added either. Returns
+    // how many were added to each channel, valid until the next call
+    virtual const std::vector<int>& AddRequests(const Request* requests,
+                                                size_t num_requests);
+    // requests completed while no callbacks were registered
+    size_t PollCompletions(Completion* completions, size_t max_completions) {
+        return completions_.Pop(completions, max_completions);
+    }
     virtual void ClockTick() = 0;
+    // saves or restores the state, see Checkpoint. The checkpoint has to be
+    // restored into a system with the same geometry
+    virtual void Serialize(Checkpoint& cp);
+    // functional warm-up, before anything is added: requests only leave the
+    // banks the way their commands would, and cycles go by with just the
+    // refreshes due in them. EndWarmUp goes back to detailed simulation
+    // with the stats reset
+    virtual void WarmUp(AddressPair hex_addr, bool is_write) {}
+    void WarmUpCycles(uint64_t cycles) { clk_ += cycles; }
+    virtual void EndWarmUp();
     int GetChannel(AddressPair hex_addr) const;
+    // the front end waits on callbacks before it sends more, so they have
+    // to be made in the cycle a single threaded run makes them: channels on
+    // threads meet every cycle instead of every sync_quantum
+    void SetClosedLoop() { sync_quantum_ = 1; }
 
     std::function<void(AddressPair req_id)> read_callback_, write_callback_;
+    std::function<void(uint64_t, AddressPair)> read_req_callback_,
+        write_req_callback_;
     static int total_channels_;
 
     // Row Clone added
@@ -47,6 +94,7 @@ class BaseDRAMSystem {
     Timing timing_;
     uint64_t parallel_cycles_;
     uint64_t serial_cycles_;
+    int sync_quantum_;
 
 #ifdef THERMAL
     ThermalCalculator thermal_calc_;
@@ -55,9 +103,37 @@ class BaseDRAMSystem {
     uint64_t clk_;
     std::vector<Controller*> ctrls_;
 
-#ifdef ADDR_TRACE
+    std::unique_ptr<CommandTracer> cmd_tracer_;
     std::ofstream address_trace_;
-#endif  // ADDR_TRACE
+
+    std::vector<int> accepted_;
+    std::vector<bool> channel_full_;
+    CompletionRing completions_;
+
+    // bring the controllers up to clk_ before their state is looked at
+    virtual void CatchUpControllers() {}
+    // the epochs before clk_ were not printed, the epoch output starts here
+    void StartEpochOutput();
+
+    void ReturnRequest(uint64_t req_id, AddressPair hex_addr, bool is_write) {
+        if (is_write) {
+            if (write_req_callback_) {
+                write_req_callback_(req_id, hex_addr);
+            } else if (write_callback_) {
+                write_callback_(hex_addr);
+            } else {
+                completions_.Push({req_id, hex_addr, true});
+            }
+        } else {
+            if (read_req_callback_) {
+                read_req_callback_(req_id, hex_addr);
+            } else if (read_callback_) {
+                read_callback_(hex_addr);
+            } else {
+                completions_.Push({req_id, hex_addr, false});
+            }
+        }
+    }
 };
 
 // hmmm not sure this is the best naming...
@@ -68,8 +144,31 @@ class JedecDRAMSystem : public BaseDRAMSystem {
                     std::function<void(AddressPair)> write_callback);
     ~JedecDRAMSystem();
     bool WillAcceptTransaction(AddressPair hex_addr, bool is_write) const override;
-    bool AddTransaction(AddressPair hex_addr, bool is_write) override;
+    bool AddRequest(uint64_t req_id, AddressPair hex_addr, bool is_write,
+                    int source_id = 0) override;
+    const std::vector<int>& AddRequests(const Request* requests,
+                                        size_t num_requests) override;
     void ClockTick() override;
+    void Serialize(Checkpoint& cp) override;
+    void WarmUp(AddressPair hex_addr, bool is_write) override;
+    void EndWarmUp() override;
+
+   private:
+    bool ChannelWillAccept(int channel, AddressPair hex_addr,
+                           bool is_write) const;
+    void AddToChannel(int channel, const Transaction& trans);
+
+    // skip-ahead clocking, the controllers are only clocked up to ctrl_clk_
+    // and nothing happens in them before next_event_clk_
+    uint64_t ctrl_clk_;
+    uint64_t next_event_clk_;
+    void CatchUpControllers() override;
+    void UpdateNextEvent();
+
+    // set when the channels are simulated on their own threads, the
+    // controllers then keep their own clocks and only meet at syncs
+    std::unique_ptr<ChannelWorkers> channel_workers_;
+    void SyncChannels();
 };
 
 // Model a memorysystem with an infinite bandwidth and a fixed latency (possibly
@@ -85,8 +184,10 @@ class IdealDRAMSystem : public BaseDRAMSystem {
                                bool is_write) const override {
         return true;
     };
-    bool AddTransaction(AddressPair hex_addr, bool is_write) override;
+    bool AddRequest(uint64_t req_id, AddressPair hex_addr, bool is_write,
+                    int source_id = 0) override;
     void ClockTick() override;
+    void Serialize(Checkpoint& cp) override;
 
    private:
     int latency_;
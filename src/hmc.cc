@@ -2,8 +2,9 @@
 
 namespace dramsim3 {
 
-HMCRequest::HMCRequest(HMCReqType req_type, AddressPair hex_addr, int vault)
-    : type(req_type), mem_operand(hex_addr), vault(vault) {
+HMCRequest::HMCRequest(HMCReqType req_type, AddressPair hex_addr, int vault,
+                       uint64_t req_id)
+    : type(req_type), mem_operand(hex_addr), req_id(req_id), vault(vault) {
     is_write = type >= HMCReqType::WR0 && type <= HMCReqType::P_WR256;
     // given that vaults could be 16 (Gen1) or 32(Gen2), using % 4
     // to partition vaults to quads
@@ -109,9 +110,9 @@ HMCRequest::HMCRequest(HMCReqType req_type, AddressPair hex_addr, int vault)
     }
 }
 
-HMCResponse::HMCResponse(uint64_t id, HMCReqType req_type, int dest_link,
-                         int src_quad)
-    : resp_id(id), link(dest_link), quad(src_quad) {
+HMCResponse::HMCResponse(uint64_t id, uint64_t hex_addr, HMCReqType req_type,
+                         int dest_link, int src_quad)
+    : resp_id(id), hex_addr(hex_addr), link(dest_link), quad(src_quad) {
     switch (req_type) {
         case HMCReqType::RD0:
             type = HMCRespType::RD_RS;
@@ -241,8 +242,8 @@ HMCResponse::HMCResponse(uint64_t id, HMCReqType req_type, int dest_link,
 }
 
 HMCMemorySystem::HMCMemorySystem(Config &config, const std::string &output_dir,
-                                 std::function<void(uint64_t)> read_callback,
-                                 std::function<void(uint64_t)> write_callback)
+                                 std::function<void(AddressPair)> read_callback,
+                                 std::function<void(AddressPair)> write_callback)
     : BaseDRAMSystem(config, output_dir, read_callback, write_callback),
       logic_clk_(0),
       logic_ps_(0),
@@ -265,6 +266,7 @@ HMCMemorySystem::HMCMemorySystem(Config &config, const std::string &output_dir,
 #else
         ctrls_.push_back(new Controller(i, config_, timing_));
 #endif  // THERMAL
+        ctrls_[i]->SetCommandTracer(cmd_tracer_.get());
     }
     // initialize vaults and crossbar
     // the first layer of xbar will be num_links * 4 (4 for quadrants)
@@ -340,7 +342,8 @@ bool HMCMemorySystem::WillAcceptTransaction(AddressPair hex_addr,
     return insertable;
 }
 
-bool HMCMemorySystem::AddTransaction(AddressPair hex_addr, bool is_write) {
+bool HMCMemorySystem::AddRequest(uint64_t req_id, AddressPair hex_addr,
+                                 bool is_write, int source_id) {
     // to be compatible with other protocol we have this interface
     // when using this intreface the size of each transaction will be block_size
     HMCReqType req_type;
@@ -390,7 +393,7 @@ bool HMCMemorySystem::AddTransaction(AddressPair hex_addr, bool is_write) {
         }
     }
     int vault = GetChannel(hex_addr);
-    HMCRequest *req = new HMCRequest(req_type, hex_addr, vault);
+    HMCRequest *req = new HMCRequest(req_type, hex_addr, vault, req_id);
     return InsertHMCReq(req);
 }
 
@@ -401,12 +404,16 @@ bool HMCMemorySystem::InsertReqToLink(HMCRequest *req, int link) {
     // 3. create corresponding response
     // 4. increment link_age_counter_ so that arbitrate logic works
     if (link_req_queues_[link].size() < queue_depth_) {
+        if (resp_lookup_table_.count(req->req_id) > 0) {
+            std::cerr << "Request id " << req->req_id << " is already in flight"
+                      << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
         req->link = link;
         link_req_queues_[link].push_back(req);
-        HMCResponse *resp =
-            new HMCResponse(req->mem_operand, req->type, link, req->quad);
-        resp_lookup_table_.insert(
-            std::pair<uint64_t, HMCResponse *>(resp->resp_id, resp));
+        HMCResponse *resp = new HMCResponse(req->req_id, req->mem_operand,
+                                            req->type, link, req->quad);
+        resp_lookup_table_[resp->resp_id] = resp;
         link_age_counter_[link] = 1;
         // stats_.interarrival_latency.AddValue(clk_ - last_req_clk_);
         last_req_clk_ = clk_;
@@ -497,11 +504,8 @@ void HMCMemorySystem::DrainResponses() {
         if (!link_resp_queues_[i].empty()) {
             HMCResponse *resp = link_resp_queues_[i].front();
             if (resp->exit_time <= logic_clk_) {
-                if (resp->type == HMCRespType::RD_RS) {
-                    read_callback_(resp->resp_id);
-                } else {
-                    write_callback_(resp->resp_id);
-                }
+                ReturnRequest(resp->resp_id, resp->hex_addr,
+                              resp->type != HMCRespType::RD_RS);
                 delete (resp);
                 link_resp_queues_[i].erase(link_resp_queues_[i].begin());
             }
@@ -544,15 +548,8 @@ void HMCMemorySystem::DrainResponses() {
 void HMCMemorySystem::DRAMClockTick() {
     for (size_t i = 0; i < ctrls_.size(); i++) {
         // look ahead and return earlier
-        while (true) {
-            auto pair = ctrls_[i]->ReturnDoneTrans(clk_);
-            if (pair.second == 1) {  // write
-                VaultCallback(pair.first);
-            } else if (pair.second == 0) {  // read
-                VaultCallback(pair.first);
-            } else {
-                break;
-            }
+        for (const auto &trans : ctrls_[i]->ReturnDoneTrans(clk_)) {
+            VaultCallback(trans.req_id);
         }
     }
     for (size_t i = 0; i < ctrls_.size(); i++) {
@@ -566,6 +563,16 @@ void HMCMemorySystem::DRAMClockTick() {
     return;
 }
 
+void HMCMemorySystem::Serialize(Checkpoint& cp) {
+    std::cerr << "Checkpoints are not supported for HMC" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
+void HMCMemorySystem::WarmUp(AddressPair hex_addr, bool is_write) {
+    std::cerr << "Functional warm-up is not supported for HMC" << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+}
+
 void HMCMemorySystem::ClockTick() {
     if (dram_ps_ == logic_ps_) {
         DrainResponses();
@@ -613,18 +620,21 @@ std::vector<int> HMCMemorySystem::BuildAgeQueue(std::vector<int> &age_counter) {
 }
 
 void HMCMemorySystem::InsertReqToDRAM(HMCRequest *req) {
-    Transaction trans(req->mem_operand, req->is_write);
+    Transaction trans(req->mem_operand, req->is_write, 0, req->req_id);
     ctrls_[req->vault]->AddTransaction(trans);
     return;
 }
 
 void HMCMemorySystem::VaultCallback(uint64_t req_id) {
-    // we will use hex addr as the req_id and use a multimap to lookup the
-    // requests the vaults cannot directly talk to the CPU so this callback will
-    // be passed to the vaults and is responsible to put the responses back to
+    // the vaults cannot directly talk to the CPU so this callback will be
+    // passed to the vaults and is responsible to put the responses back to
     // response queues
 
     auto it = resp_lookup_table_.find(req_id);
+    if (it == resp_lookup_table_.end()) {
+        std::cerr << "Request id " << req_id << " is not in flight" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
     HMCResponse *resp = it->second;
     // all data from dram received, put packet in xbar and return
     resp_lookup_table_.erase(it);
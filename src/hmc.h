@@ -2,7 +2,7 @@
 #define __HMC_H
 
 #include <functional>
-#include <map>
+#include <unordered_map>
 #include <vector>
 
 #include "dram_system.h"
@@ -78,9 +78,12 @@ enum class HMCLinkType { HOST_TO_DEV, DEV_TO_DEV, SIZE };
 
 class HMCRequest {
    public:
-    HMCRequest(HMCReqType req_type, AddressPair hex_addr, int vault);
+    HMCRequest(HMCReqType req_type, AddressPair hex_addr, int vault,
+               uint64_t req_id);
     HMCReqType type;
     uint64_t mem_operand;
+    // handed back with the response, unique among the requests in flight
+    uint64_t req_id;
     int link;
     int quad;
     int vault;
@@ -92,8 +95,10 @@ class HMCRequest {
 
 class HMCResponse {
    public:
-    HMCResponse(uint64_t id, HMCReqType reqtype, int dest_link, int src_quad);
+    HMCResponse(uint64_t id, uint64_t hex_addr, HMCReqType reqtype,
+                int dest_link, int src_quad);
     uint64_t resp_id;
+    uint64_t hex_addr;
     HMCRespType type;
     int link;
     int quad;
@@ -105,17 +110,22 @@ class HMCResponse {
 class HMCMemorySystem : public BaseDRAMSystem {
    public:
     HMCMemorySystem(Config& config, const std::string& output_dir,
-                    std::function<void(uint64_t)> read_callback,
-                    std::function<void(uint64_t)> write_callback);
+                    std::function<void(AddressPair)> read_callback,
+                    std::function<void(AddressPair)> write_callback);
     ~HMCMemorySystem();
     // assuming there are 2 clock domains one for logic die one for DRAM
     // we can unify them as one but then we'll have to convert all the
     // slow dram time units to faster logic units...
     void ClockTick() override;
+    // the links and crossbar are neither checkpointed nor warmed up, these
+    // just refuse
+    void Serialize(Checkpoint& cp) override;
+    void WarmUp(AddressPair hex_addr, bool is_write) override;
 
     // had to have 3 insert interfaces cuz HMC is so different...
     bool WillAcceptTransaction(AddressPair hex_addr, bool is_write) const override;
-    bool AddTransaction(AddressPair hex_addr, bool is_write) override;
+    bool AddRequest(uint64_t req_id, AddressPair hex_addr, bool is_write,
+                    int source_id = 0) override;
     bool InsertReqToLink(HMCRequest* req, int link);
     bool InsertHMCReq(HMCRequest* req);
 
@@ -139,9 +149,8 @@ class HMCMemorySystem : public BaseDRAMSystem {
     // number of flits xbar can process per logic cycle
     const int xbar_bandwidth_ = 2;
 
-    // had to use a multimap because the controller callback return hex addr
-    // instead of unique id
-    std::multimap<uint64_t, HMCResponse*> resp_lookup_table_;
+    // responses waiting on the vaults, by request id
+    std::unordered_map<uint64_t, HMCResponse*> resp_lookup_table_;
     // these are essentially input/output buffers for xbars
     std::vector<std::vector<HMCRequest*>> link_req_queues_;
     std::vector<std::vector<HMCResponse*>> link_resp_queues_;
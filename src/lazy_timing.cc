@@ -0,0 +1,105 @@
+#include "lazy_timing.h"
+#include <algorithm>
+#include <limits>
+
+namespace dramsim3 {
+
+const int64_t LazyTiming::kNever = std::numeric_limits<int64_t>::min() / 2;
+
+LazyTiming::LazyTiming(const Config& config, const Timing& timing)
+    : config_(config),
+      num_types_(static_cast<int>(CommandType::SIZE)),
+      delays_(num_types_),
+      bank_issues_(config.ranks * config.banks * num_types_, kNever),
+      bankgroup_issues_(config.ranks * config.bankgroups * num_types_),
+      rank_issues_(config.ranks * num_types_),
+      channel_issues_(num_types_),
+      rank_cmd_issues_(config.ranks * num_types_, kNever) {
+    // turn "what a command delays" around into "what delays a command"
+    for (int s = 0; s < static_cast<int>(TimingScope::SIZE); s++) {
+        TimingScope scope = static_cast<TimingScope>(s);
+        const auto& lists = timing.Lists(scope);
+        for (int i = 0; i < static_cast<int>(lists.size()); i++) {
+            for (auto cmd_timing : lists[i]) {
+                auto& delays = delays_[static_cast<int>(cmd_timing.first)];
+                auto it = std::find_if(
+                    delays.begin(), delays.end(), [&](const Delay& d) {
+                        return d.cmd_type == i && d.scope == scope;
+                    });
+                if (it == delays.end()) {
+                    delays.push_back({i, scope, cmd_timing.second});
+                } else {
+                    it->delay = std::max(it->delay, cmd_timing.second);
+                }
+            }
+        }
+    }
+}
+
+void LazyTiming::Issue(const Command& cmd, CommandType timing_type,
+                       uint64_t clk) {
+    int t = static_cast<int>(timing_type);
+    int64_t time = static_cast<int64_t>(clk);
+    int rank = cmd.Rank();
+    if (cmd.IsRankCMD()) {
+        rank_cmd_issues_[rank * num_types_ + t] = time;
+        return;
+    }
+    int bankgroup = rank * config_.bankgroups + cmd.Bankgroup();
+    int bank = bankgroup * config_.banks_per_group + cmd.Bank();
+    bank_issues_[bank * num_types_ + t] = time;
+    bankgroup_issues_[bankgroup * num_types_ + t].Issue(time, cmd.Bank());
+    rank_issues_[rank * num_types_ + t].Issue(time, cmd.Bankgroup());
+    channel_issues_[t].Issue(time, rank);
+    return;
+}
+
+uint64_t LazyTiming::ReadyCycle(int rank, int bankgroup, int bank,
+                                CommandType timing_type) const {
+    int bankgroup_index = rank * config_.bankgroups + bankgroup;
+    int bank_index = bankgroup_index * config_.banks_per_group + bank;
+    int64_t ready = 0;
+    for (const auto& d : delays_[static_cast<int>(timing_type)]) {
+        int64_t issued = kNever;
+        switch (d.scope) {
+            case TimingScope::SAME_BANK:
+                issued = bank_issues_[bank_index * num_types_ + d.cmd_type];
+                break;
+            case TimingScope::OTHER_BANKS_SAME_BANKGROUP:
+                issued =
+                    bankgroup_issues_[bankgroup_index * num_types_ + d.cmd_type]
+                        .NotTo(bank);
+                break;
+            case TimingScope::OTHER_BANKGROUPS_SAME_RANK:
+                issued = rank_issues_[rank * num_types_ + d.cmd_type].NotTo(
+                    bankgroup);
+                break;
+            case TimingScope::OTHER_RANKS:
+                issued = channel_issues_[d.cmd_type].NotTo(rank);
+                break;
+            case TimingScope::SAME_RANK:
+                issued = rank_cmd_issues_[rank * num_types_ + d.cmd_type];
+                break;
+            default:
+                AbruptExit(__FILE__, __LINE__);
+        }
+        ready = std::max(ready, issued + d.delay);
+    }
+    return static_cast<uint64_t>(ready);
+}
+
+void LazyTiming::LastIssue::Serialize(Checkpoint& cp) {
+    cp.Field(latest);
+    cp.Field(other);
+    cp.Field(member);
+}
+
+void LazyTiming::Serialize(Checkpoint& cp) {
+    cp.Field(bank_issues_);
+    cp.Field(bankgroup_issues_);
+    cp.Field(rank_issues_);
+    cp.Field(channel_issues_);
+    cp.Field(rank_cmd_issues_);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,82 @@
+#ifndef __LAZY_TIMING_H
+#define __LAZY_TIMING_H
+
+#include <vector>
+#include "checkpoint.h"
+#include "common.h"
+#include "configuration.h"
+#include "timing.h"
+
+namespace dramsim3 {
+
+// Timing constraints of a channel worked out when they are asked for rather
+// than when a command is issued. Issuing a command only records when it was
+// issued, per command type, to its bank, bankgroup, rank and the channel, so
+// it costs the same however many banks there are. The earliest cycle a
+// command can go to a bank is then the latest of the issue times plus the
+// delays the Timing lists give for the scope each of them is in.
+//
+// Command types are timing types here, see CopyTimingType, and commands
+// have to be issued in cycle order.
+class LazyTiming {
+   public:
+    LazyTiming(const Config& config, const Timing& timing);
+    void Issue(const Command& cmd, CommandType timing_type, uint64_t clk);
+    uint64_t ReadyCycle(int rank, int bankgroup, int bank,
+                        CommandType timing_type) const;
+
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+   private:
+    // The last issue of a command type within a group (the banks of a
+    // bankgroup, the bankgroups of a rank or the ranks of the channel), and
+    // the last one to a member other than the one that got that. A scope
+    // like "other banks in the bankgroup" is whichever of the two was not
+    // to the bank asking
+    struct LastIssue {
+        LastIssue() : latest(kNever), other(kNever), member(-1) {}
+        int64_t latest;
+        int64_t other;
+        int member;
+        void Issue(int64_t clk, int to) {
+            if (to != member) {
+                other = latest;
+                member = to;
+            }
+            latest = clk;
+        }
+        int64_t NotTo(int to) const { return to == member ? other : latest; }
+        void Serialize(Checkpoint& cp);
+    };
+
+    // A command type delaying another one in a scope
+    struct Delay {
+        int cmd_type;
+        TimingScope scope;
+        int delay;
+    };
+
+    // low enough that nothing issued "then" delays anything
+    static const int64_t kNever;
+
+    const Config& config_;
+    int num_types_;
+
+    // for each command type, the delays on it, sorted by scope
+    std::vector<std::vector<Delay> > delays_;
+
+    // [bank][command type], banks numbered as in ChannelState
+    std::vector<int64_t> bank_issues_;
+    // [rank * bankgroups + bankgroup][command type], by bank
+    std::vector<LastIssue> bankgroup_issues_;
+    // [rank][command type], by bankgroup
+    std::vector<LastIssue> rank_issues_;
+    // [command type], by rank
+    std::vector<LastIssue> channel_issues_;
+    // [rank][command type] of rank commands (refresh, self refresh)
+    std::vector<int64_t> rank_cmd_issues_;
+};
+
+}  // namespace dramsim3
+#endif
@@ -21,10 +21,39 @@ int main(int argc, const char **argv) {
     args::ValueFlag<std::string> stream_arg(
         parser, "stream_type", "address stream generator - (random), stream",
         {'s', "stream"}, "");
-    args::ValueFlag<std::string> trace_file_arg(
+    args::ValueFlagList<std::string> trace_file_arg(
         parser, "trace",
-        "Trace file, setting this option will ignore -s option",
+        "Trace file, setting this option will ignore -s option. Given more "
+        "than once, each trace runs on a core of its own",
         {'t', "trace"});
+    args::ValueFlag<int> mshrs_arg(
+        parser, "mshrs", "Reads and copies in flight per core (multi-core)",
+        {"mshrs"}, 16);
+    args::ValueFlag<int> rob_arg(
+        parser, "rob_size",
+        "In order window of transactions per core, 0 for none (multi-core)",
+        {"rob"}, 0);
+    args::ValueFlag<std::string> injection_arg(
+        parser, "injection",
+        "Order cores inject in - (rr) round robin, priority (multi-core)",
+        {"injection"}, "rr");
+    args::ValueFlag<uint64_t> start_cycle_arg(
+        parser, "start_cycle",
+        "Skip the trace transactions added before this cycle",
+        {"start-cycle"}, 0);
+    args::ValueFlag<uint64_t> warmup_arg(
+        parser, "warmup",
+        "Trace transactions to fast forward through before the run, only "
+        "keeping the open rows and refreshes up to date",
+        {"warmup"}, 0);
+    args::ValueFlag<std::string> checkpoint_in_arg(
+        parser, "checkpoint_in",
+        "Checkpoint to restore before the run, saved with the same traces "
+        "and memory geometry",
+        {"checkpoint-in"}, "");
+    args::ValueFlag<std::string> checkpoint_out_arg(
+        parser, "checkpoint_out", "Checkpoint to save after the run",
+        {"checkpoint-out"}, "");
     args::Positional<std::string> config_arg(
         parser, "config", "The config file name (mandatory)");
 
@@ -47,12 +76,27 @@ int main(int argc, const char **argv) {
 
     uint64_t cycles = args::get(num_cycles_arg);
     std::string output_dir = args::get(output_dir_arg);
-    std::string trace_file = args::get(trace_file_arg);
+    std::vector<std::string> trace_files = args::get(trace_file_arg);
     std::string stream_type = args::get(stream_arg);
+    uint64_t start_cycle = args::get(start_cycle_arg);
 
     CPU *cpu;
-    if (!trace_file.empty()) {
-        cpu = new TraceBasedCPU(config_file, output_dir, trace_file);
+    if (trace_files.size() > 1 || mshrs_arg || rob_arg || injection_arg) {
+        if (trace_files.empty()) {
+            std::cerr << "Multi-core runs need at least one trace" << std::endl;
+            return 1;
+        }
+        std::string injection = args::get(injection_arg);
+        if (injection != "rr" && injection != "priority") {
+            std::cerr << "Unknown injection " << injection << std::endl;
+            return 1;
+        }
+        cpu = new MultiCoreCPU(config_file, output_dir, trace_files,
+                               args::get(mshrs_arg), args::get(rob_arg),
+                               injection == "rr", start_cycle);
+    } else if (!trace_files.empty()) {
+        cpu = new TraceBasedCPU(config_file, output_dir, trace_files[0],
+                                start_cycle);
     } else {
         if (stream_type == "stream" || stream_type == "s") {
             cpu = new StreamCPU(config_file, output_dir);
@@ -61,9 +105,18 @@ int main(int argc, const char **argv) {
         }
     }
 
+    if (checkpoint_in_arg) {
+        cpu->RestoreCheckpoint(args::get(checkpoint_in_arg));
+    }
+    if (warmup_arg) {
+        cpu->WarmUp(args::get(warmup_arg));
+    }
     for (uint64_t clk = 0; clk < cycles; clk++) {
         cpu->ClockTick();
     }
+    if (checkpoint_out_arg) {
+        cpu->SaveCheckpoint(args::get(checkpoint_out_arg));
+    }
     cpu->PrintStats();
 
     delete cpu;
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "./../ext/headers/args.hxx"
+#include "json.hpp"
+#include "mapping_stats.h"
+#include "trace_prefetcher.h"
+
+// this will not be used in a library file so it's ok to do this
+using namespace dramsim3;
+
+namespace {
+const size_t kChunkSize = 1 << 16;
+
+std::string Trim(const std::string& s) {
+    size_t first = s.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return "";
+    }
+    size_t last = s.find_last_not_of(" \t\r");
+    return s.substr(first, last - first + 1);
+}
+
+// A candidate is an address_mapping string, optionally followed by
+// "; key = value" [system] settings such as address_xor_ba
+struct Candidate {
+    std::string name;
+    std::unique_ptr<Config> config;
+    std::unique_ptr<MappingStats> stats;
+};
+
+bool ParseCandidate(const std::string& line,
+                    std::map<std::string, std::string>& overrides) {
+    auto parts = StringSplit(line, ';');
+    std::string mapping = parts.empty() ? "" : Trim(parts[0]);
+    if (!mapping.empty()) {
+        overrides["address_mapping"] = mapping;
+    }
+    for (size_t i = 1; i < parts.size(); i++) {
+        size_t equal = parts[i].find('=');
+        if (equal == std::string::npos) {
+            return false;
+        }
+        overrides[Trim(parts[i].substr(0, equal))] =
+            Trim(parts[i].substr(equal + 1));
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, const char** argv) {
+    args::ArgumentParser parser(
+        "Evaluates address mappings on a trace in one pass, without "
+        "simulating it.",
+        "Example: \n"
+        "./build/mappingexplorer configs/DDR4_8Gb_x8_3200.ini -t "
+        "sample_trace.txt -m rochrababgco -m \"rorababgchco; address_xor_ba "
+        "= 20 21\"");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::ValueFlag<std::string> trace_file_arg(
+        parser, "trace", "Text or binary trace (mandatory)", {'t', "trace"});
+    args::ValueFlagList<std::string> mapping_arg(
+        parser, "mapping",
+        "Candidate mapping, an address_mapping string optionally followed by "
+        "\"; key = value\" [system] settings",
+        {'m', "mapping"});
+    args::ValueFlag<std::string> mapping_file_arg(
+        parser, "mapping_file", "File with a candidate mapping per line",
+        {"mappings"}, "");
+    args::ValueFlag<int> threads_arg(parser, "threads",
+                                     "Threads to evaluate the mappings on",
+                                     {"threads"}, 0);
+    args::ValueFlag<uint64_t> window_arg(
+        parser, "window",
+        "Accesses after the previous access to a bank a conflict counts as "
+        "close within",
+        {"window"}, 16);
+    args::ValueFlag<std::string> sort_arg(
+        parser, "sort",
+        "Ranking - (hit) row hit rate, bank, channel imbalance, distance of "
+        "conflicts",
+        {"sort"}, "hit");
+    args::ValueFlag<size_t> top_arg(parser, "top",
+                                    "Mappings to print, 0 for all", {"top"},
+                                    0);
+    args::ValueFlag<std::string> json_arg(
+        parser, "json", "File to write the results of all mappings to",
+        {'j', "json"}, "");
+    args::Positional<std::string> config_arg(
+        parser, "config", "The config file name (mandatory)");
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string config_file = args::get(config_arg);
+    std::string trace_file = args::get(trace_file_arg);
+    if (config_file.empty() || trace_file.empty()) {
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string sort = args::get(sort_arg);
+    if (sort != "hit" && sort != "bank" && sort != "channel" &&
+        sort != "distance") {
+        std::cerr << "Unknown ranking: " << sort << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> lines = args::get(mapping_arg);
+    std::string mapping_file = args::get(mapping_file_arg);
+    if (!mapping_file.empty()) {
+        std::ifstream mappings(mapping_file);
+        if (mappings.fail()) {
+            std::cerr << "Mapping file does not exist" << std::endl;
+            return 1;
+        }
+        std::string line;
+        while (std::getline(mappings, line)) {
+            line = Trim(line.substr(0, line.find('#')));
+            if (!line.empty()) {
+                lines.push_back(line);
+            }
+        }
+    }
+    if (lines.empty()) {
+        std::cerr << "No mappings to evaluate" << std::endl;
+        return 1;
+    }
+
+    std::vector<Candidate> candidates(lines.size());
+    for (size_t i = 0; i < lines.size(); i++) {
+        std::map<std::string, std::string> overrides;
+        if (!ParseCandidate(lines[i], overrides)) {
+            std::cerr << "Cannot parse mapping: " << lines[i] << std::endl;
+            return 1;
+        }
+        candidates[i].name = lines[i];
+        candidates[i].config.reset(new Config(config_file, ".", overrides));
+        candidates[i].stats.reset(new MappingStats(*candidates[i].config,
+                                                   args::get(window_arg)));
+    }
+
+    int num_threads = args::get(threads_arg);
+    if (num_threads <= 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    num_threads = std::min(num_threads, static_cast<int>(candidates.size()));
+
+    // the trace is read once, a chunk at a time, and every thread takes
+    // its share of the candidates through each chunk
+    TracePrefetcher trace(trace_file, 0);
+    std::vector<Transaction> chunk;
+    chunk.reserve(kChunkSize);
+    bool more = true;
+    while (more) {
+        chunk.clear();
+        Transaction trans;
+        while (chunk.size() < kChunkSize && (more = trace.Next(trans))) {
+            chunk.push_back(trans);
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; t++) {
+            threads.emplace_back([&candidates, &chunk, num_threads, t]() {
+                for (size_t i = t; i < candidates.size(); i += num_threads) {
+                    for (const auto& trans : chunk) {
+                        candidates[i].stats->Add(trans);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    std::vector<const Candidate*> ranking;
+    for (const auto& candidate : candidates) {
+        ranking.push_back(&candidate);
+    }
+    std::stable_sort(
+        ranking.begin(), ranking.end(),
+        [&sort](const Candidate* a, const Candidate* b) {
+            const MappingStats& x = *a->stats;
+            const MappingStats& y = *b->stats;
+            if (sort == "bank") {
+                return x.BankImbalance() < y.BankImbalance();
+            } else if (sort == "channel") {
+                return x.ChannelImbalance() < y.ChannelImbalance();
+            } else if (sort == "distance") {
+                return x.MeanConflictDistance() > y.MeanConflictDistance();
+            }
+            return x.RowHitRate() > y.RowHitRate();
+        });
+
+    size_t top = args::get(top_arg);
+    if (top == 0 || top > ranking.size()) {
+        top = ranking.size();
+    }
+    std::cout << ranking[0]->stats->Accesses() << " accesses" << std::endl;
+    std::cout << std::setw(8) << "row_hit" << std::setw(8) << "ch_imb"
+              << std::setw(8) << "ba_imb" << std::setw(10) << "conf_dist"
+              << std::setw(8) << "close" << std::setw(8) << "cp_bank"
+              << "  mapping" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < top; i++) {
+        const MappingStats& stats = *ranking[i]->stats;
+        std::cout << std::setw(8) << stats.RowHitRate() << std::setw(8)
+                  << stats.ChannelImbalance() << std::setw(8)
+                  << stats.BankImbalance() << std::setw(10)
+                  << stats.MeanConflictDistance() << std::setw(8)
+                  << stats.CloseConflictRate() << std::setw(8)
+                  << stats.CopyInBankRate() << "  " << ranking[i]->name
+                  << std::endl;
+    }
+
+    std::string json_file = args::get(json_arg);
+    if (!json_file.empty()) {
+        nlohmann::json results = nlohmann::json::array();
+        for (const auto candidate : ranking) {
+            const MappingStats& stats = *candidate->stats;
+            results.push_back({{"mapping", candidate->name},
+                               {"accesses", stats.Accesses()},
+                               {"row_hit_rate", stats.RowHitRate()},
+                               {"channel_imbalance", stats.ChannelImbalance()},
+                               {"bank_imbalance", stats.BankImbalance()},
+                               {"mean_conflict_distance",
+                                stats.MeanConflictDistance()},
+                               {"close_conflict_rate",
+                                stats.CloseConflictRate()},
+                               {"copy_in_bank_rate", stats.CopyInBankRate()}});
+        }
+        std::ofstream json_out(json_file);
+        json_out << std::setw(2) << results << std::endl;
+    }
+    return 0;
+}
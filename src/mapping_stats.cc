@@ -0,0 +1,101 @@
+#include "mapping_stats.h"
+#include <algorithm>
+
+namespace dramsim3 {
+
+namespace {
+double Imbalance(const std::vector<uint64_t>& accesses, uint64_t total) {
+    if (total == 0) {
+        return 1.0;
+    }
+    uint64_t busiest = *std::max_element(accesses.begin(), accesses.end());
+    return static_cast<double>(busiest) * accesses.size() / total;
+}
+}  // namespace
+
+MappingStats::MappingStats(const Config& config, uint64_t conflict_window)
+    : config_(config),
+      conflict_window_(conflict_window),
+      channel_accesses_(config.channels, 0),
+      bank_accesses_(config.channels * config.ranks * config.banks, 0),
+      open_rows_(bank_accesses_.size(), -1),
+      last_accesses_(bank_accesses_.size(), 0),
+      accesses_(0),
+      row_hits_(0),
+      conflicts_(0),
+      conflict_distance_(0),
+      close_conflicts_(0),
+      copies_(0),
+      copies_in_bank_(0) {}
+
+void MappingStats::Add(const Transaction& trans) {
+    Transaction decoded = trans;
+    decoded.addr.is_copy = trans.is_copy;
+    config_.DecodeAddresses(decoded);
+    Access(decoded.src_address);
+    if (trans.is_copy) {
+        Access(decoded.dest_address);
+        copies_++;
+        if (BankIndex(decoded.src_address) ==
+            BankIndex(decoded.dest_address)) {
+            copies_in_bank_++;
+        }
+    }
+    return;
+}
+
+double MappingStats::RowHitRate() const {
+    return accesses_ == 0 ? 0.0 : static_cast<double>(row_hits_) / accesses_;
+}
+
+double MappingStats::ChannelImbalance() const {
+    return Imbalance(channel_accesses_, accesses_);
+}
+
+double MappingStats::BankImbalance() const {
+    return Imbalance(bank_accesses_, accesses_);
+}
+
+double MappingStats::MeanConflictDistance() const {
+    return conflicts_ == 0 ? 0.0
+                           : static_cast<double>(conflict_distance_) /
+                                 conflicts_;
+}
+
+double MappingStats::CloseConflictRate() const {
+    return accesses_ == 0 ? 0.0
+                          : static_cast<double>(close_conflicts_) / accesses_;
+}
+
+double MappingStats::CopyInBankRate() const {
+    return copies_ == 0 ? 0.0 : static_cast<double>(copies_in_bank_) / copies_;
+}
+
+int MappingStats::BankIndex(const Address& addr) const {
+    int rank = addr.channel * config_.ranks + addr.rank;
+    return (rank * config_.bankgroups + addr.bankgroup) *
+               config_.banks_per_group +
+           addr.bank;
+}
+
+void MappingStats::Access(const Address& addr) {
+    int bank = BankIndex(addr);
+    accesses_++;
+    channel_accesses_[addr.channel]++;
+    bank_accesses_[bank]++;
+    if (open_rows_[bank] == addr.row) {
+        row_hits_++;
+    } else if (open_rows_[bank] != -1) {
+        uint64_t distance = accesses_ - last_accesses_[bank];
+        conflicts_++;
+        conflict_distance_ += distance;
+        if (distance <= conflict_window_) {
+            close_conflicts_++;
+        }
+    }
+    open_rows_[bank] = addr.row;
+    last_accesses_[bank] = accesses_;
+    return;
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,60 @@
+#ifndef __MAPPING_STATS_H
+#define __MAPPING_STATS_H
+
+#include <vector>
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// What an address mapping does to a stream of transactions, without
+// simulating it: how evenly the accesses spread over the channels and
+// banks, how often they hit the open row with every bank keeping its last
+// row open, and how close a row conflict comes after the access before it
+// to the same bank. A copy is an access to its source and then to its
+// destination. Addresses are decoded as the controller does, see
+// Config::DecodeAddresses.
+class MappingStats {
+   public:
+    // conflicts within conflict_window accesses of the previous access to
+    // their bank count as close ones
+    MappingStats(const Config& config, uint64_t conflict_window);
+    void Add(const Transaction& trans);
+
+    uint64_t Accesses() const { return accesses_; }
+    double RowHitRate() const;
+    // accesses of the busiest channel (bank) over the mean, 1 is even
+    double ChannelImbalance() const;
+    double BankImbalance() const;
+    // accesses between a conflict and the previous access to its bank
+    double MeanConflictDistance() const;
+    // share of the accesses that are close conflicts
+    double CloseConflictRate() const;
+    // share of the copies with source and destination in the same bank
+    double CopyInBankRate() const;
+
+   private:
+    const Config& config_;
+    uint64_t conflict_window_;
+
+    std::vector<uint64_t> channel_accesses_;
+    std::vector<uint64_t> bank_accesses_;
+    // by bank, -1 if no row has been opened yet
+    std::vector<int> open_rows_;
+    // by bank, number of the last access to it
+    std::vector<uint64_t> last_accesses_;
+
+    uint64_t accesses_;
+    uint64_t row_hits_;
+    uint64_t conflicts_;
+    uint64_t conflict_distance_;
+    uint64_t close_conflicts_;
+    uint64_t copies_;
+    uint64_t copies_in_bank_;
+
+    int BankIndex(const Address& addr) const;
+    void Access(const Address& addr);
+};
+
+}  // namespace dramsim3
+#endif
@@ -16,6 +16,10 @@ MemorySystem::MemorySystem(const std::string &config_file,
     }
 }
 
+MemorySystem::MemorySystem(const std::string &config_file,
+                           const std::string &output_dir)
+    : MemorySystem(config_file, output_dir, nullptr, nullptr) {}
+
 MemorySystem::~MemorySystem() {
     delete (dram_system_);
     delete (config_);
@@ -42,9 +46,71 @@ bool MemorySystem::WillAcceptTransaction(AddressPair hex_addr,
     return dram_system_->WillAcceptTransaction(hex_addr, is_write);
 }
 
-bool MemorySystem::AddTransaction(AddressPair hex_addr, bool is_write) {
-    return dram_system_->AddTransaction(hex_addr, is_write);
+bool MemorySystem::AddTransaction(AddressPair hex_addr, bool is_write,
+                                  int source_id) {
+    return dram_system_->AddTransaction(hex_addr, is_write, source_id);
+}
+
+void MemorySystem::RegisterRequestCallbacks(
+    std::function<void(uint64_t, AddressPair)> read_callback,
+    std::function<void(uint64_t, AddressPair)> write_callback) {
+    dram_system_->RegisterRequestCallbacks(read_callback, write_callback);
+}
+
+namespace {
+void CheckReqId(uint64_t req_id) {
+    if (req_id & BaseDRAMSystem::kInternalReqIds) {
+        std::cerr << "Request id " << req_id << " has the top bit set, "
+                  << "which is kept for AddTransaction" << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
 }
+}  // namespace
+
+bool MemorySystem::AddRequest(uint64_t req_id, AddressPair hex_addr,
+                              bool is_write, int source_id) {
+    CheckReqId(req_id);
+    return dram_system_->AddRequest(req_id, hex_addr, is_write, source_id);
+}
+
+const std::vector<int> &MemorySystem::AddRequests(const Request *requests,
+                                                  size_t num_requests) {
+    for (size_t i = 0; i < num_requests; i++) {
+        CheckReqId(requests[i].req_id);
+    }
+    return dram_system_->AddRequests(requests, num_requests);
+}
+
+size_t MemorySystem::PollCompletions(Completion *completions,
+                                     size_t max_completions) {
+    return dram_system_->PollCompletions(completions, max_completions);
+}
+
+void MemorySystem::WarmUp(AddressPair hex_addr, bool is_write) {
+    dram_system_->WarmUp(hex_addr, is_write);
+}
+
+void MemorySystem::WarmUpCycles(uint64_t cycles) {
+    dram_system_->WarmUpCycles(cycles);
+}
+
+void MemorySystem::EndWarmUp() { dram_system_->EndWarmUp(); }
+
+void MemorySystem::SetClosedLoop() { dram_system_->SetClosedLoop(); }
+
+void MemorySystem::SaveCheckpoint(const std::string &file_name) {
+    Checkpoint cp(file_name, true);
+    Serialize(cp);
+    cp.Close();
+}
+
+void MemorySystem::RestoreCheckpoint(const std::string &file_name) {
+    Checkpoint cp(file_name, false);
+    Serialize(cp);
+    cp.Close();
+}
+
+void MemorySystem::Serialize(Checkpoint &cp) { dram_system_->Serialize(cp); }
 
 // Row Clone Added
 const Config* MemorySystem::getConfig(){
@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 
 #include "configuration.h"
 #include "dram_system.h"
@@ -16,6 +17,8 @@ class MemorySystem {
     MemorySystem(const std::string &config_file, const std::string &output_dir,
                  std::function<void(AddressPair)> read_callback,
                  std::function<void(AddressPair)> write_callback);
+    // completions have to be polled with PollCompletions
+    MemorySystem(const std::string &config_file, const std::string &output_dir);
     ~MemorySystem();
     void ClockTick();
     void RegisterCallbacks(std::function<void(AddressPair)> read_callback,
@@ -28,7 +31,42 @@ class MemorySystem {
     void ResetStats();
 
     bool WillAcceptTransaction(AddressPair hex_addr, bool is_write) const;
-    bool AddTransaction(AddressPair hex_addr, bool is_write);
+    bool AddTransaction(AddressPair hex_addr, bool is_write,
+                        int source_id = 0);
+
+    // same as above, but completions are reported with the req_id given
+    // here to the request callbacks, which take over from the address only
+    // ones once registered. req_id must be unique among requests in flight
+    // and have the top bit clear
+    void RegisterRequestCallbacks(
+        std::function<void(uint64_t, AddressPair)> read_callback,
+        std::function<void(uint64_t, AddressPair)> write_callback);
+    bool AddRequest(uint64_t req_id, AddressPair hex_addr, bool is_write,
+                    int source_id = 0);
+
+    // batched AddRequest, see BaseDRAMSystem::AddRequests. Without any
+    // callbacks registered completions are kept until polled here
+    const std::vector<int> &AddRequests(const Request *requests,
+                                        size_t num_requests);
+    size_t PollCompletions(Completion *completions, size_t max_completions);
+
+    // functional warm-up before the detailed simulation, fast forwarding
+    // through requests with only the banks and the refreshes kept up to
+    // date, see BaseDRAMSystem::WarmUp. EndWarmUp resets the stats
+    void WarmUp(AddressPair hex_addr, bool is_write);
+    void WarmUpCycles(uint64_t cycles);
+    void EndWarmUp();
+
+    // for front ends that wait on the callbacks, see
+    // BaseDRAMSystem::SetClosedLoop
+    void SetClosedLoop();
+
+    // the whole memory system, so runs can be forked off a warmed up one.
+    // The restoring system needs a config with the same geometry, timings
+    // and policies may differ
+    void SaveCheckpoint(const std::string &file_name);
+    void RestoreCheckpoint(const std::string &file_name);
+    void Serialize(Checkpoint &cp);
 
     // Row Clone added
     const Config* getConfig();
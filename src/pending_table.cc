@@ -0,0 +1,142 @@
+#include "pending_table.h"
+
+namespace dramsim3 {
+
+PendingTable::PendingTable(int capacity) : free_head_(-1), size_(0) {
+    Grow(capacity > 0 ? capacity : 1);
+}
+
+int PendingTable::Count(uint64_t addr) const {
+    const Slot& slot = slots_[FindSlot(addr)];
+    return slot.head < 0 ? 0 : slot.count;
+}
+
+void PendingTable::Insert(const Transaction& trans) {
+    if (free_head_ < 0) {
+        Grow(static_cast<int>(pool_.size()) * 2);
+    }
+    int index = free_head_;
+    free_head_ = pool_[index].next;
+    pool_[index].trans = trans;
+    pool_[index].next = -1;
+
+    uint64_t addr = trans.addr;
+    Slot& slot = slots_[FindSlot(addr)];
+    if (slot.head < 0) {
+        slot.addr = addr;
+        slot.head = index;
+        slot.count = 0;
+    } else {
+        pool_[slot.tail].next = index;
+    }
+    slot.tail = index;
+    slot.count++;
+    size_++;
+}
+
+bool PendingTable::PopFront(uint64_t addr, Transaction& trans) {
+    uint64_t slot_index = FindSlot(addr);
+    Slot& slot = slots_[slot_index];
+    if (slot.head < 0) {
+        return false;
+    }
+    int index = slot.head;
+    trans = pool_[index].trans;
+    slot.head = pool_[index].next;
+    slot.count--;
+    pool_[index].next = free_head_;
+    free_head_ = index;
+    size_--;
+    if (slot.head < 0) {
+        RemoveSlot(slot_index);
+    }
+    return true;
+}
+
+uint64_t PendingTable::Hash(uint64_t addr) const {
+    // addresses are mostly aligned, multiplicative hashing takes the bits
+    // from the top so the zeros at the bottom don't matter
+    return (addr * 0x9E3779B97F4A7C15ull) >> slot_shift_;
+}
+
+uint64_t PendingTable::FindSlot(uint64_t addr) const {
+    uint64_t slot = Hash(addr);
+    while (slots_[slot].head >= 0 && slots_[slot].addr != addr) {
+        slot = (slot + 1) & slot_mask_;
+    }
+    return slot;
+}
+
+void PendingTable::RemoveSlot(uint64_t slot) {
+    // shift the rest of the probe sequence back instead of leaving a
+    // tombstone, so lookups never probe further than they have to
+    uint64_t hole = slot;
+    uint64_t next = (hole + 1) & slot_mask_;
+    while (slots_[next].head >= 0) {
+        uint64_t home = Hash(slots_[next].addr);
+        // move unless home lies cyclically within (hole, next]
+        bool stays = hole <= next ? (hole < home && home <= next)
+                                  : (hole < home || home <= next);
+        if (!stays) {
+            slots_[hole] = slots_[next];
+            hole = next;
+        }
+        next = (next + 1) & slot_mask_;
+    }
+    slots_[hole].head = -1;
+}
+
+void PendingTable::Grow(int capacity) {
+    int old_capacity = static_cast<int>(pool_.size());
+    pool_.resize(capacity);
+    for (int i = capacity - 1; i >= old_capacity; i--) {
+        pool_[i].next = free_head_;
+        free_head_ = i;
+    }
+
+    // every address has at least one entry, so twice as many slots as
+    // entries keeps the table at most half full
+    uint64_t num_slots = 1;
+    slot_shift_ = 64;
+    while (num_slots < static_cast<uint64_t>(capacity) * 2) {
+        num_slots <<= 1;
+        slot_shift_--;
+    }
+    if (num_slots == slots_.size()) {
+        return;
+    }
+    std::vector<Slot> old_slots(num_slots);
+    old_slots.swap(slots_);
+    for (auto& slot : slots_) {
+        slot.head = -1;
+    }
+    slot_mask_ = num_slots - 1;
+    for (const auto& slot : old_slots) {
+        if (slot.head >= 0) {
+            slots_[FindSlot(slot.addr)] = slot;
+        }
+    }
+}
+
+void PendingTable::Serialize(Checkpoint& cp) {
+    cp.Field(slots_);
+    cp.Field(pool_);
+    cp.Field(free_head_);
+    cp.Field(size_);
+    cp.Field(slot_mask_);
+    cp.Field(slot_shift_);
+}
+
+void PendingTable::Entry::Serialize(Checkpoint& cp) {
+    cp.Field(trans);
+    cp.Field(next);
+}
+
+void PendingTable::Slot::Serialize(Checkpoint& cp) {
+    cp.Field(addr);
+    cp.Field(head);
+    cp.Field(tail);
+    cp.Field(count);
+}
+
+}  // namespace dramsim3
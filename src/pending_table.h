@@ -0,0 +1,57 @@
+#ifndef __PENDING_TABLE_H
+#define __PENDING_TABLE_H
+
+#include <vector>
+#include "checkpoint.h"
+#include "common.h"
+
+namespace dramsim3 {
+
+// Transactions waiting on an address, looked up by address in an open
+// addressing table. Transactions on the same address are chained in the
+// order they come in, and the entries come out of a pool that only grows
+// when there are more transactions pending than ever before.
+class PendingTable {
+   public:
+    PendingTable(int capacity);
+    // number of transactions pending on addr
+    int Count(uint64_t addr) const;
+    void Insert(const Transaction& trans);
+    // takes out the oldest transaction pending on addr, false if there's none
+    bool PopFront(uint64_t addr, Transaction& trans);
+    int Size() const { return size_; }
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+   private:
+    struct Entry {
+        Transaction trans;
+        int next;
+        void Serialize(Checkpoint& cp);
+    };
+    // an address with no head is an empty slot
+    struct Slot {
+        uint64_t addr;
+        int head;
+        int tail;
+        int count;
+        void Serialize(Checkpoint& cp);
+    };
+
+    std::vector<Slot> slots_;
+    std::vector<Entry> pool_;
+    int free_head_;
+    int size_;
+    uint64_t slot_mask_;
+    int slot_shift_;
+
+    uint64_t Hash(uint64_t addr) const;
+    // slot holding addr, or the empty slot it would go into
+    uint64_t FindSlot(uint64_t addr) const;
+    void RemoveSlot(uint64_t slot);
+    void Grow(int capacity);
+};
+
+}  // namespace dramsim3
+
+#endif
@@ -1,14 +1,24 @@
 #include "refresh.h"
+#include <algorithm>
 
 namespace dramsim3 {
-Refresh::Refresh(const Config &config, ChannelState &channel_state)
+Refresh::Refresh(const Config &config, ChannelState &channel_state,
+                 const CommandQueue &cmd_queue, SimpleStats &simple_stats)
     : clk_(0),
       config_(config),
       channel_state_(channel_state),
+      cmd_queue_(cmd_queue),
+      simple_stats_(simple_stats),
       refresh_policy_(config.refresh_policy),
       next_rank_(0),
       next_bg_(0),
-      next_bank_(0) {
+      next_bank_(0),
+      elastic_(config.refresh_scheduling == "ELASTIC"),
+      targets_per_rank_(refresh_policy_ == RefreshPolicy::BANK_LEVEL_STAGGERED
+                            ? config.banks
+                            : 1),
+      owed_(config.ranks * targets_per_rank_, 0),
+      idle_cycles_(config.ranks, 0) {
     if (refresh_policy_ == RefreshPolicy::RANK_LEVEL_SIMULTANEOUS) {
         refresh_interval_ = config_.tREFI;
     } else if (refresh_policy_ == RefreshPolicy::BANK_LEVEL_STAGGERED) {
@@ -20,12 +30,82 @@ Refresh::Refresh(const Config &config, ChannelState &channel_state)
 
 void Refresh::ClockTick() {
     if (clk_ % refresh_interval_ == 0 && clk_ > 0) {
-        InsertRefresh();
+        if (elastic_) {
+            RefreshDue();
+        } else {
+            InsertRefresh();
+        }
+    }
+    if (elastic_) {
+        ScheduleElastic();
     }
     clk_++;
     return;
 }
 
+void Refresh::SkipCycles(uint64_t cycles) {
+    // nothing is queued or issued in between, so the queues stay as they are
+    if (elastic_) {
+        for (int i = 0; i < config_.ranks; i++) {
+            idle_cycles_[i] =
+                cmd_queue_.RankQueueEmpty(i) ? idle_cycles_[i] + cycles : 0;
+        }
+    }
+    clk_ += cycles;
+    return;
+}
+
+uint64_t Refresh::NextDueCycle() const {
+    uint64_t interval = static_cast<uint64_t>(refresh_interval_);
+    return clk_ == 0 ? interval : (clk_ + interval - 1) / interval * interval;
+}
+
+uint64_t Refresh::NextRefreshCycle() const {
+    // first cycle (from now on) in which ClockTick inserts a refresh
+    uint64_t next_refresh = NextDueCycle();
+    if (!elastic_) {
+        return next_refresh;
+    }
+    // owed refreshes wait for the read demand to change, which takes a
+    // command, and pull-ins for the rank to have been idle long enough
+    for (int target = 0; target < static_cast<int>(owed_.size()); target++) {
+        int rank = TargetRank(target);
+        if (owed_[target] > 0) {
+            if (WillQueue(target)) {
+                return clk_;
+            }
+        } else if (-owed_[target] < config_.refresh_max_pull_in &&
+                   !channel_state_.IsRankSelfRefreshing(rank) &&
+                   cmd_queue_.RankQueueEmpty(rank)) {
+            // idle cycles are counted before they are checked
+            uint64_t idle = idle_cycles_[rank] + 1;
+            uint64_t threshold =
+                static_cast<uint64_t>(config_.refresh_pull_in_idle);
+            next_refresh = std::min(
+                next_refresh,
+                idle >= threshold ? clk_ : clk_ + threshold - idle);
+        }
+    }
+    return next_refresh;
+}
+
+void Refresh::WarmUpCycles(uint64_t cycles) {
+    // without requests to postpone for or idle ranks to pull in, refreshes
+    // follow the tREFI schedule whatever the refresh scheduling
+    uint64_t end_clk = clk_ + cycles;
+    while (NextDueCycle() < end_clk) {
+        clk_ = NextDueCycle();
+        InsertRefresh();
+        while (channel_state_.IsRefreshWaiting()) {
+            Command ref = channel_state_.PendingRefCommand();
+            channel_state_.WarmUp(ref);
+        }
+        clk_++;
+    }
+    clk_ = end_clk;
+    return;
+}
+
 void Refresh::InsertRefresh() {
     switch (refresh_policy_) {
         // Simultaneous all rank refresh
@@ -81,4 +161,108 @@ void Refresh::IterateNext() {
     }
 }
 
+void Refresh::RefreshDue() {
+    std::vector<int> due;
+    switch (refresh_policy_) {
+        // every rank at once
+        case RefreshPolicy::RANK_LEVEL_SIMULTANEOUS:
+            for (int i = 0; i < config_.ranks; i++) {
+                due.push_back(i);
+            }
+            break;
+        case RefreshPolicy::RANK_LEVEL_STAGGERED:
+            due.push_back(next_rank_);
+            IterateNext();
+            break;
+        case RefreshPolicy::BANK_LEVEL_STAGGERED:
+            due.push_back(next_rank_ * config_.banks +
+                          next_bg_ * config_.banks_per_group + next_bank_);
+            IterateNext();
+            break;
+        default:
+            AbruptExit(__FILE__, __LINE__);
+            break;
+    }
+    for (auto target : due) {
+        int rank = TargetRank(target);
+        if (channel_state_.IsRankSelfRefreshing(rank)) {
+            continue;
+        }
+        owed_[target]++;
+        // one owed past the limit is forced this cycle, not postponed
+        if (owed_[target] > 0 &&
+            owed_[target] <= config_.refresh_max_postpone &&
+            cmd_queue_.RankReads(rank) >= config_.refresh_postpone_reads) {
+            simple_stats_.Increment(CounterStat::NUM_REFS_POSTPONED);
+        }
+    }
+    return;
+}
+
+void Refresh::ScheduleElastic() {
+    for (int i = 0; i < config_.ranks; i++) {
+        idle_cycles_[i] =
+            cmd_queue_.RankQueueEmpty(i) ? idle_cycles_[i] + 1 : 0;
+    }
+    for (int target = 0; target < static_cast<int>(owed_.size()); target++) {
+        if (!WillQueue(target)) {
+            continue;
+        }
+        if (owed_[target] <= 0) {
+            simple_stats_.Increment(CounterStat::NUM_REFS_PULLED_IN);
+        } else if (cmd_queue_.RankReads(TargetRank(target)) >=
+                   config_.refresh_postpone_reads) {
+            simple_stats_.Increment(CounterStat::NUM_REFS_FORCED);
+        }
+        QueueRefresh(target);
+    }
+    return;
+}
+
+bool Refresh::WillQueue(int target) const {
+    int rank = TargetRank(target);
+    if (channel_state_.IsRankSelfRefreshing(rank)) {
+        return false;
+    }
+    if (owed_[target] > 0) {
+        if (owed_[target] <= config_.refresh_max_postpone &&
+            cmd_queue_.RankReads(rank) >= config_.refresh_postpone_reads) {
+            return false;
+        }
+    } else if (-owed_[target] >= config_.refresh_max_pull_in ||
+               idle_cycles_[rank] <
+                   static_cast<uint64_t>(config_.refresh_pull_in_idle)) {
+        return false;
+    }
+    // one at a time, the next one once this one is done
+    if (targets_per_rank_ == 1) {
+        return !channel_state_.IsRefreshQueued(rank, -1, -1);
+    }
+    int bank = target % targets_per_rank_;
+    return !channel_state_.IsRefreshQueued(
+        rank, bank / config_.banks_per_group, bank % config_.banks_per_group);
+}
+
+void Refresh::QueueRefresh(int target) {
+    int rank = TargetRank(target);
+    if (targets_per_rank_ == 1) {
+        channel_state_.RankNeedRefresh(rank, true);
+    } else {
+        int bank = target % targets_per_rank_;
+        channel_state_.BankNeedRefresh(rank, bank / config_.banks_per_group,
+                                       bank % config_.banks_per_group, true);
+    }
+    owed_[target]--;
+    return;
+}
+
+void Refresh::Serialize(Checkpoint& cp) {
+    cp.Field(clk_);
+    cp.Field(next_rank_);
+    cp.Field(next_bg_);
+    cp.Field(next_bank_);
+    cp.Field(owed_);
+    cp.Field(idle_cycles_);
+}
+
 }  // namespace dramsim3
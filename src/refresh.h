@@ -3,28 +3,64 @@
 
 #include <vector>
 #include "channel_state.h"
+#include "checkpoint.h"
+#include "command_queue.h"
 #include "common.h"
 #include "configuration.h"
+#include "simple_stats.h"
 
 namespace dramsim3 {
 
+// Queues the refreshes of a channel. With STRICT refresh scheduling a
+// refresh is queued the moment it is due. With ELASTIC scheduling a due
+// refresh is only owed: it is queued once its rank has fewer than
+// refresh_postpone_reads reads queued, or regardless once more than
+// refresh_max_postpone are owed. When a rank's command queues have been
+// empty for refresh_pull_in_idle cycles, up to refresh_max_pull_in
+// refreshes are done ahead of time and skipped when they come due.
 class Refresh {
    public:
-    Refresh(const Config& config, ChannelState& channel_state);
+    Refresh(const Config& config, ChannelState& channel_state,
+            const CommandQueue& cmd_queue, SimpleStats& simple_stats);
     void ClockTick();
+    void SkipCycles(uint64_t cycles);
+    // functional warm-up, the refreshes due in these cycles are done at
+    // once instead of being queued
+    void WarmUpCycles(uint64_t cycles);
+    uint64_t NextRefreshCycle() const;
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
 
    private:
     uint64_t clk_;
     int refresh_interval_;
     const Config& config_;
     ChannelState& channel_state_;
+    const CommandQueue& cmd_queue_;
+    SimpleStats& simple_stats_;
     RefreshPolicy refresh_policy_;
 
     int next_rank_, next_bg_, next_bank_;
 
-    void InsertRefresh();
+    // ELASTIC scheduling: by refresh target (rank, or bank with per bank
+    // refresh), the refreshes due and not queued yet, below 0 when pulled
+    // in, and by rank the cycles its command queues have been empty
+    bool elastic_;
+    int targets_per_rank_;
+    std::vector<int> owed_;
+    std::vector<uint64_t> idle_cycles_;
 
+    void InsertRefresh();
     void IterateNext();
+    // next cycle on the tREFI schedule, from now on
+    uint64_t NextDueCycle() const;
+
+    void RefreshDue();
+    void ScheduleElastic();
+    // whether the target would be queued this cycle, see ScheduleElastic
+    bool WillQueue(int target) const;
+    void QueueRefresh(int target);
+    int TargetRank(int target) const { return target / targets_per_rank_; }
 };
 
 }  // namespace dramsim3
@@ -0,0 +1,76 @@
+#include "return_queue.h"
+#include <algorithm>
+#include <limits>
+
+namespace dramsim3 {
+
+ReturnQueue::ReturnQueue(const Config& config) : next_clk_(0), size_(0) {
+    // reads are the furthest away from being due, plus the cycle they are
+    // added in, rounded up to a power of 2 so the slot is a mask away
+    uint64_t num_slots = 1;
+    while (num_slots < static_cast<uint64_t>(config.read_delay) + 2) {
+        num_slots <<= 1;
+    }
+    buckets_.resize(num_slots);
+    mask_ = num_slots - 1;
+}
+
+void ReturnQueue::Add(const Transaction& trans) {
+    uint64_t due = std::max(trans.complete_cycle, next_clk_);
+    while (due - next_clk_ > mask_) {
+        Grow();
+    }
+    buckets_[due & mask_].push_back(trans);
+    buckets_[due & mask_].back().complete_cycle = due;
+    size_++;
+}
+
+const std::vector<Transaction>& ReturnQueue::PopDone(uint64_t clk) {
+    done_.clear();
+    // each slot only ever holds transactions due in the same cycle
+    while (size_ > 0 && next_clk_ <= clk) {
+        auto& bucket = buckets_[next_clk_ & mask_];
+        if (!bucket.empty()) {
+            done_.insert(done_.end(), bucket.begin(), bucket.end());
+            size_ -= bucket.size();
+            bucket.clear();
+        }
+        next_clk_++;
+    }
+    if (next_clk_ <= clk) {
+        next_clk_ = clk + 1;
+    }
+    return done_;
+}
+
+uint64_t ReturnQueue::NextDueCycle() const {
+    if (size_ == 0) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+    uint64_t clk = next_clk_;
+    while (buckets_[clk & mask_].empty()) {
+        clk++;
+    }
+    return clk;
+}
+
+void ReturnQueue::Grow() {
+    std::vector<std::vector<Transaction>> buckets(buckets_.size() * 2);
+    uint64_t mask = buckets.size() - 1;
+    for (auto& bucket : buckets_) {
+        for (const auto& trans : bucket) {
+            buckets[trans.complete_cycle & mask].push_back(trans);
+        }
+    }
+    buckets_.swap(buckets);
+    mask_ = mask;
+}
+
+void ReturnQueue::Serialize(Checkpoint& cp) {
+    cp.Field(buckets_);
+    cp.Field(mask_);
+    cp.Field(next_clk_);
+    cp.Field(size_);
+}
+
+}  // namespace dramsim3
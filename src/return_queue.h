@@ -0,0 +1,42 @@
+#ifndef __RETURN_QUEUE_H
+#define __RETURN_QUEUE_H
+
+#include <vector>
+#include "checkpoint.h"
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// Completed transactions waiting to be returned, kept in a timing wheel
+// keyed on the cycle they are due so that returning them doesn't need
+// to look at anything that is not due yet
+class ReturnQueue {
+   public:
+    ReturnQueue(const Config& config);
+    // a transaction is due at its complete_cycle, or at the next cycle
+    // that has not been returned yet if that is already past
+    void Add(const Transaction& trans);
+    // every transaction due by clk, in the order they become due and then
+    // in the order they were added
+    const std::vector<Transaction>& PopDone(uint64_t clk);
+    // cycle the earliest transaction is due, max if there is none
+    uint64_t NextDueCycle() const;
+    bool IsEmpty() const { return size_ == 0; }
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+   private:
+    std::vector<std::vector<Transaction>> buckets_;
+    std::vector<Transaction> done_;
+    uint64_t mask_;
+    // every cycle before this has been returned
+    uint64_t next_clk_;
+    size_t size_;
+
+    void Grow();
+};
+
+}  // namespace dramsim3
+
+#endif
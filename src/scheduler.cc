@@ -0,0 +1,192 @@
+#include "scheduler.h"
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+
+namespace dramsim3 {
+
+SchedulerType GetSchedulerType(const std::string& name) {
+    if (name == "FRFCFS") {
+        return SchedulerType::FRFCFS;
+    } else if (name == "PARBS") {
+        return SchedulerType::PARBS;
+    } else if (name == "ATLAS") {
+        return SchedulerType::ATLAS;
+    } else if (name == "BLISS") {
+        return SchedulerType::BLISS;
+    }
+    std::cerr << "Unsupported scheduler " << name << std::endl;
+    AbruptExit(__FILE__, __LINE__);
+    return SchedulerType::SIZE;
+}
+
+namespace {
+// commands that finish a request, as opposed to the ACT/PRE it needs first
+bool IsColumnCommand(const Command& cmd) {
+    return cmd.IsReadWrite() || cmd.IsReadCopy() || cmd.IsWriteCopy();
+}
+
+// ranks[i] for the sources sorted by less_than, the first one gets the
+// highest rank
+template <class Compare>
+void RankSources(std::vector<uint32_t>& ranks, size_t num_sources,
+                 Compare less_than) {
+    std::vector<int> order(num_sources);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), less_than);
+    ranks.assign(num_sources, 0);
+    for (size_t i = 0; i < num_sources; i++) {
+        ranks[order[i]] = static_cast<uint32_t>(num_sources - i);
+    }
+}
+}  // namespace
+
+PARBSScheduler::PARBSScheduler(const Config& config)
+    : config_(config), batch_left_(0) {}
+
+void PARBSScheduler::Prepare(std::vector<std::vector<Command>>& queues,
+                             uint64_t clk) {
+    if (batch_left_ > 0) {
+        return;
+    }
+    // marked commands per source per bank, queues are in arrival order
+    int num_banks = config_.ranks * config_.banks;
+    std::vector<std::vector<int>> loads;
+    for (auto& queue : queues) {
+        for (auto& cmd : queue) {
+            if (static_cast<size_t>(cmd.source_id) >= loads.size()) {
+                loads.resize(cmd.source_id + 1, std::vector<int>(num_banks, 0));
+            }
+            int bank = cmd.Rank() * config_.banks +
+                       cmd.Bankgroup() * config_.banks_per_group + cmd.Bank();
+            int& load = loads[cmd.source_id][bank];
+            if (load < config_.parbs_marking_cap) {
+                cmd.marked = true;
+                load++;
+                batch_left_++;
+            }
+        }
+    }
+    if (batch_left_ == 0) {
+        return;
+    }
+
+    // shortest job first, by the load on the busiest bank and then by the
+    // total load
+    std::vector<int> max_loads(loads.size()), total_loads(loads.size());
+    for (size_t i = 0; i < loads.size(); i++) {
+        max_loads[i] = *std::max_element(loads[i].begin(), loads[i].end());
+        total_loads[i] = std::accumulate(loads[i].begin(), loads[i].end(), 0);
+    }
+    RankSources(source_ranks_, loads.size(), [&](int a, int b) {
+        return max_loads[a] != max_loads[b] ? max_loads[a] < max_loads[b]
+                                            : total_loads[a] < total_loads[b];
+    });
+    return;
+}
+
+void PARBSScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    if (cmd.marked && IsColumnCommand(cmd)) {
+        batch_left_--;
+    }
+    return;
+}
+
+void PARBSScheduler::Serialize(Checkpoint& cp) {
+    cp.Field(batch_left_);
+    cp.Field(source_ranks_);
+}
+
+ATLASScheduler::ATLASScheduler(const Config& config)
+    : config_(config), next_quantum_clk_(config.atlas_quantum) {}
+
+void ATLASScheduler::Prepare(std::vector<std::vector<Command>>& queues,
+                             uint64_t clk) {
+    if (clk < next_quantum_clk_) {
+        return;
+    }
+    while (next_quantum_clk_ <= clk) {
+        next_quantum_clk_ += config_.atlas_quantum;
+    }
+    total_service_.resize(quantum_service_.size(), 0.0);
+    for (size_t i = 0; i < quantum_service_.size(); i++) {
+        total_service_[i] = config_.atlas_alpha * total_service_[i] +
+                            (1.0 - config_.atlas_alpha) * quantum_service_[i];
+        quantum_service_[i] = 0;
+    }
+    // least attained service first
+    RankSources(source_ranks_, total_service_.size(), [&](int a, int b) {
+        return total_service_[a] < total_service_[b];
+    });
+    return;
+}
+
+void ATLASScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    // cycles the command keeps its bank busy for
+    int service = 0;
+    if (cmd.cmd_type == CommandType::ACTIVATE) {
+        service = config_.tRCD;
+    } else if (cmd.cmd_type == CommandType::PRECHARGE) {
+        service = config_.tRP;
+    } else if (IsColumnCommand(cmd)) {
+        service = config_.burst_cycle;
+    }
+    if (static_cast<size_t>(cmd.source_id) >= quantum_service_.size()) {
+        quantum_service_.resize(cmd.source_id + 1, 0);
+    }
+    quantum_service_[cmd.source_id] += service;
+    return;
+}
+
+void ATLASScheduler::Serialize(Checkpoint& cp) {
+    cp.Field(next_quantum_clk_);
+    cp.Field(total_service_);
+    cp.Field(quantum_service_);
+    cp.Field(source_ranks_);
+}
+
+BLISSScheduler::BLISSScheduler(const Config& config)
+    : config_(config),
+      next_clearing_clk_(config.bliss_clearing_interval),
+      last_source_(-1),
+      served_in_row_(0) {}
+
+void BLISSScheduler::Prepare(std::vector<std::vector<Command>>& queues,
+                             uint64_t clk) {
+    if (clk < next_clearing_clk_) {
+        return;
+    }
+    while (next_clearing_clk_ <= clk) {
+        next_clearing_clk_ += config_.bliss_clearing_interval;
+    }
+    std::fill(blacklist_.begin(), blacklist_.end(), false);
+    return;
+}
+
+void BLISSScheduler::CommandIssued(const Command& cmd, uint64_t clk) {
+    if (!IsColumnCommand(cmd)) {
+        return;
+    }
+    if (cmd.source_id == last_source_) {
+        served_in_row_++;
+    } else {
+        last_source_ = cmd.source_id;
+        served_in_row_ = 1;
+    }
+    if (served_in_row_ > config_.bliss_threshold) {
+        if (static_cast<size_t>(cmd.source_id) >= blacklist_.size()) {
+            blacklist_.resize(cmd.source_id + 1, false);
+        }
+        blacklist_[cmd.source_id] = true;
+    }
+    return;
+}
+
+void BLISSScheduler::Serialize(Checkpoint& cp) {
+    cp.Field(next_clearing_clk_);
+    cp.Field(last_source_);
+    cp.Field(served_in_row_);
+    cp.Field(blacklist_);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,130 @@
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#include <string>
+#include <vector>
+#include "checkpoint.h"
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// Command scheduling policies, chosen with scheduler in the [system] section.
+// The command picking loop in CommandQueue is a template instantiated once
+// per policy, so none of the calls below are virtual. Each policy provides
+//   kFirstReady   whether the first ready command in a queue always wins,
+//                 otherwise the one with the highest Priority does. Ties
+//                 go to the oldest in a queue, and between queues to the
+//                 earliest in the round robin order
+//   Prepare       called before each command is picked
+//   Priority      of a queued command that is ready, row_hit means it's a
+//                 column command to the open row
+//   CommandIssued called with every command picked from the queues
+// Precharges that close a row with hits pending go through the row_hit_cap
+// arbitration in CommandQueue for every policy. Policies that keep state
+// also have a Serialize for checkpoints.
+enum class SchedulerType { FRFCFS, PARBS, ATLAS, BLISS, SIZE };
+
+SchedulerType GetSchedulerType(const std::string& name);
+
+// higher is better, sources not seen yet are ranked last. Source ids are
+// never negative, see Controller::AddTransaction
+inline uint32_t SourceRank(const std::vector<uint32_t>& ranks, int source_id) {
+    return static_cast<size_t>(source_id) < ranks.size() ? ranks[source_id]
+                                                         : 0;
+}
+
+// First ready, first come first served
+class FRFCFSScheduler {
+   public:
+    static const bool kFirstReady = true;
+    FRFCFSScheduler(const Config& config) {}
+    void Prepare(std::vector<std::vector<Command>>& queues, uint64_t clk) {}
+    uint64_t Priority(const Command& cmd, bool row_hit, uint64_t clk) const {
+        return 0;
+    }
+    void CommandIssued(const Command& cmd, uint64_t clk) {}
+};
+
+// Parallelism-aware batch scheduling (Mutlu and Moscibroda, ISCA'08). The
+// oldest parbs_marking_cap commands of each source to each bank make up a
+// batch that is served before anything newer. Within the batch row hits go
+// first, then the sources with the lightest load on their busiest bank
+class PARBSScheduler {
+   public:
+    static const bool kFirstReady = false;
+    PARBSScheduler(const Config& config);
+    void Prepare(std::vector<std::vector<Command>>& queues, uint64_t clk);
+    uint64_t Priority(const Command& cmd, bool row_hit, uint64_t clk) const {
+        return static_cast<uint64_t>(cmd.marked) << 40 |
+               static_cast<uint64_t>(row_hit) << 39 |
+               SourceRank(source_ranks_, cmd.source_id);
+    }
+    void CommandIssued(const Command& cmd, uint64_t clk);
+    void Serialize(Checkpoint& cp);
+
+   private:
+    const Config& config_;
+    // marked commands not served yet, a new batch is formed at 0
+    int batch_left_;
+    std::vector<uint32_t> source_ranks_;
+};
+
+// Adaptive per-thread least-attained-service scheduling (Kim et al.,
+// HPCA'10). Every atlas_quantum cycles sources are ranked by the bank time
+// they have been given, decayed by atlas_alpha. Commands waiting longer
+// than atlas_threshold go first, then the least served sources, then row
+// hits
+class ATLASScheduler {
+   public:
+    static const bool kFirstReady = false;
+    ATLASScheduler(const Config& config);
+    void Prepare(std::vector<std::vector<Command>>& queues, uint64_t clk);
+    uint64_t Priority(const Command& cmd, bool row_hit, uint64_t clk) const {
+        bool starving = clk - cmd.added_cycle >
+                        static_cast<uint64_t>(config_.atlas_threshold);
+        return static_cast<uint64_t>(starving) << 40 |
+               static_cast<uint64_t>(SourceRank(source_ranks_,
+                                                cmd.source_id)) << 1 |
+               static_cast<uint64_t>(row_hit);
+    }
+    void CommandIssued(const Command& cmd, uint64_t clk);
+    void Serialize(Checkpoint& cp);
+
+   private:
+    const Config& config_;
+    uint64_t next_quantum_clk_;
+    std::vector<double> total_service_;
+    std::vector<uint64_t> quantum_service_;
+    std::vector<uint32_t> source_ranks_;
+};
+
+// Blacklisting memory scheduler (Subramanian et al., ICCD'14). A source
+// that has more than bliss_threshold requests served in a row is
+// blacklisted until the next clearing interval, requests from sources that
+// are not blacklisted go first, then row hits
+class BLISSScheduler {
+   public:
+    static const bool kFirstReady = false;
+    BLISSScheduler(const Config& config);
+    void Prepare(std::vector<std::vector<Command>>& queues, uint64_t clk);
+    uint64_t Priority(const Command& cmd, bool row_hit, uint64_t clk) const {
+        bool blacklisted =
+            static_cast<size_t>(cmd.source_id) < blacklist_.size() &&
+            blacklist_[cmd.source_id];
+        return static_cast<uint64_t>(!blacklisted) << 1 |
+               static_cast<uint64_t>(row_hit);
+    }
+    void CommandIssued(const Command& cmd, uint64_t clk);
+    void Serialize(Checkpoint& cp);
+
+   private:
+    const Config& config_;
+    uint64_t next_clearing_clk_;
+    int last_source_;
+    int served_in_row_;
+    std::vector<bool> blacklist_;
+};
+
+}  // namespace dramsim3
+#endif
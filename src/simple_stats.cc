@@ -1,10 +1,113 @@
 #include <iostream>
+#include <limits>
 
 #include "fmt/format.h"
 #include "simple_stats.h"
 
 namespace dramsim3 {
 
+namespace {
+// tail percentiles reported for every histogram
+const std::vector<double> kPercentiles = {50.0, 90.0, 99.0, 99.9};
+}  // namespace
+
+LogLinearHistogram::LogLinearHistogram()
+    : counts_(BucketIndex(std::numeric_limits<int>::max()) + 1, 0),
+      count_(0),
+      sum_(0),
+      min_index_(std::numeric_limits<int>::max()),
+      max_index_(-1) {}
+
+void LogLinearHistogram::Merge(const LogLinearHistogram& other) {
+    for (int i = other.min_index_; i <= other.max_index_; i++) {
+        counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    min_index_ = std::min(min_index_, other.min_index_);
+    max_index_ = std::max(max_index_, other.max_index_);
+}
+
+void LogLinearHistogram::Clear() {
+    for (int i = min_index_; i <= max_index_; i++) {
+        counts_[i] = 0;
+    }
+    count_ = 0;
+    sum_ = 0;
+    min_index_ = std::numeric_limits<int>::max();
+    max_index_ = -1;
+}
+
+void LogLinearHistogram::Serialize(Checkpoint& cp) {
+    // only the buckets that may be non-empty
+    if (!cp.IsSaving()) {
+        Clear();
+    }
+    cp.Field(count_);
+    cp.Field(sum_);
+    cp.Field(min_index_);
+    cp.Field(max_index_);
+    if (max_index_ >= static_cast<int>(counts_.size()) ||
+        (max_index_ >= 0 && min_index_ < 0)) {
+        std::cerr << "Histogram buckets out of range in checkpoint"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    for (int i = min_index_; i <= max_index_; i++) {
+        cp.Field(counts_[i]);
+    }
+}
+
+double LogLinearHistogram::Average() const {
+    return count_ == 0
+               ? 0.0
+               : static_cast<double>(sum_) / static_cast<double>(count_);
+}
+
+uint64_t LogLinearHistogram::ValueAtPercentile(double percentile) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    // rank of the value, counting from 1
+    uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * count_ + 0.5);
+    rank = std::max(rank, static_cast<uint64_t>(1));
+    uint64_t accu_count = 0;
+    for (int i = min_index_; i <= max_index_; i++) {
+        accu_count += counts_[i];
+        if (accu_count >= rank) {
+            return HighestValue(i);
+        }
+    }
+    return HighestValue(max_index_);
+}
+
+std::vector<std::pair<uint64_t, uint64_t> > LogLinearHistogram::Buckets()
+    const {
+    std::vector<std::pair<uint64_t, uint64_t> > buckets;
+    for (int i = min_index_; i <= max_index_; i++) {
+        if (counts_[i] > 0) {
+            buckets.emplace_back(LowestValue(i), counts_[i]);
+        }
+    }
+    return buckets;
+}
+
+uint64_t LogLinearHistogram::LowestValue(int index) {
+    if (index < 2 * kSubBuckets) {
+        return index;
+    }
+    int shift = index / kSubBuckets - 1;
+    return static_cast<uint64_t>(index - kSubBuckets * shift) << shift;
+}
+
+uint64_t LogLinearHistogram::HighestValue(int index) {
+    if (index < 2 * kSubBuckets) {
+        return index;
+    }
+    int shift = index / kSubBuckets - 1;
+    return LowestValue(index) + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
 template <class T>
 void PrintStatText(std::ostream& where, std::string name, T value,
                    std::string description) {
@@ -17,32 +120,51 @@ void PrintStatText(std::ostream& where, std::string name, T value,
 }
 
 SimpleStats::SimpleStats(const Config& config, int channel_id)
-    : config_(config), channel_id_(channel_id) {
+    : config_(config),
+      channel_id_(channel_id),
+      counters_(static_cast<int>(CounterStat::SIZE), 0),
+      epoch_counters_(static_cast<int>(CounterStat::SIZE), 0),
+      vec_counters_(static_cast<int>(VecCounterStat::SIZE)),
+      epoch_vec_counters_(static_cast<int>(VecCounterStat::SIZE)),
+      histo_headers_(static_cast<int>(HistoStat::SIZE)),
+      percentile_headers_(static_cast<int>(HistoStat::SIZE)),
+      histo_bounds_(static_cast<int>(HistoStat::SIZE)),
+      bin_widths_(static_cast<int>(HistoStat::SIZE)),
+      histos_(static_cast<int>(HistoStat::SIZE)),
+      epoch_histos_(static_cast<int>(HistoStat::SIZE)),
+      histo_bins_(static_cast<int>(HistoStat::SIZE)),
+      epoch_histo_bins_(static_cast<int>(HistoStat::SIZE)) {
     // counter stats
-    InitStat("num_cycles", "counter", "Number of DRAM cycles");
-    InitStat("epoch_num", "counter", "Number of epochs");
-    InitStat("num_reads_done", "counter", "Number of read requests issued");
-    InitStat("num_writes_done", "counter", "Number of write requests issued");
-    InitStat("num_write_buf_hits", "counter", "Number of write buffer hits");
-    InitStat("num_read_row_hits", "counter", "Number of read row buffer hits");
-    InitStat("num_write_row_hits", "counter",
+    InitCounterStat(CounterStat::NUM_CYCLES, "num_cycles", "Number of DRAM cycles");
+    InitCounterStat(CounterStat::EPOCH_NUM, "epoch_num", "Number of epochs");
+    InitCounterStat(CounterStat::NUM_READS_DONE, "num_reads_done", "Number of read requests issued");
+    InitCounterStat(CounterStat::NUM_WRITES_DONE, "num_writes_done", "Number of write requests issued");
+    InitCounterStat(CounterStat::NUM_WRITE_BUF_HITS, "num_write_buf_hits", "Number of write buffer hits");
+    InitCounterStat(CounterStat::NUM_READ_ROW_HITS, "num_read_row_hits", "Number of read row buffer hits");
+    InitCounterStat(CounterStat::NUM_WRITE_ROW_HITS, "num_write_row_hits",
              "Number of write row buffer hits");
-    InitStat("num_read_cmds", "counter", "Number of READ/READP commands");
-    InitStat("num_write_cmds", "counter", "Number of WRITE/WRITEP commands");
-    InitStat("num_act_cmds", "counter", "Number of ACT commands");
-    InitStat("num_pre_cmds", "counter", "Number of PRE commands");
-    InitStat("num_ondemand_pres", "counter", "Number of ondemend PRE commands");
-    InitStat("num_ref_cmds", "counter", "Number of REF commands");
-    InitStat("num_refb_cmds", "counter", "Number of REFb commands");
-    InitStat("num_srefe_cmds", "counter", "Number of SREFE commands");
-    InitStat("num_srefx_cmds", "counter", "Number of SREFX commands");
-    InitStat("hbm_dual_cmds", "counter", "Number of cycles dual cmds issued");
+    InitCounterStat(CounterStat::NUM_READ_CMDS, "num_read_cmds", "Number of READ/READP commands");
+    InitCounterStat(CounterStat::NUM_WRITE_CMDS, "num_write_cmds", "Number of WRITE/WRITEP commands");
+    InitCounterStat(CounterStat::NUM_ACT_CMDS, "num_act_cmds", "Number of ACT commands");
+    InitCounterStat(CounterStat::NUM_PRE_CMDS, "num_pre_cmds", "Number of PRE commands");
+    InitCounterStat(CounterStat::NUM_ONDEMAND_PRES, "num_ondemand_pres", "Number of ondemend PRE commands");
+    InitCounterStat(CounterStat::NUM_REF_CMDS, "num_ref_cmds", "Number of REF commands");
+    InitCounterStat(CounterStat::NUM_REFB_CMDS, "num_refb_cmds", "Number of REFb commands");
+    InitCounterStat(CounterStat::NUM_SREFE_CMDS, "num_srefe_cmds", "Number of SREFE commands");
+    InitCounterStat(CounterStat::NUM_SREFX_CMDS, "num_srefx_cmds", "Number of SREFX commands");
+    InitCounterStat(CounterStat::HBM_DUAL_CMDS, "hbm_dual_cmds", "Number of cycles dual cmds issued");
+    InitCounterStat(CounterStat::NUM_WRITE_DRAINS, "num_write_drains", "Number of write buffer drain episodes");
+    InitCounterStat(CounterStat::NUM_RD_TO_WR_TURNAROUNDS, "num_rd_to_wr_turnarounds", "Number of READ to WRITE bus turnarounds");
+    InitCounterStat(CounterStat::NUM_WR_TO_RD_TURNAROUNDS, "num_wr_to_rd_turnarounds", "Number of WRITE to READ bus turnarounds");
+    InitCounterStat(CounterStat::NUM_REFS_POSTPONED, "num_refs_postponed", "Number of refreshes postponed when due");
+    InitCounterStat(CounterStat::NUM_REFS_PULLED_IN, "num_refs_pulled_in", "Number of refreshes pulled in ahead of time");
+    InitCounterStat(CounterStat::NUM_REFS_FORCED, "num_refs_forced", "Number of refreshes forced at the postponement limit");
 
 
     // rowclone added
-    InitStat("num_read_copy_cmds", "counter", "Number of READCOPY commands");
-    InitStat("num_write_copy_cmds", "counter", "Number of WRITECOPY commands");
-    InitStat("num_copies_done", "counter", "Number of copy requests issued");
+    InitCounterStat(CounterStat::NUM_READ_COPY_CMDS, "num_read_copy_cmds", "Number of READCOPY commands");
+    InitCounterStat(CounterStat::NUM_WRITE_COPY_CMDS, "num_write_copy_cmds", "Number of WRITECOPY commands");
+    InitCounterStat(CounterStat::NUM_COPIES_DONE, "num_copies_done", "Number of copy requests issued");
 
     // double stats
     InitStat("act_energy", "double", "Activation energy");
@@ -52,11 +174,11 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
     InitStat("refb_energy", "double", "Refresh-bank energy");
 
     // Vector counter stats
-    InitVecStat("all_bank_idle_cycles", "vec_counter",
+    InitVecCounterStat(VecCounterStat::ALL_BANK_IDLE_CYCLES, "all_bank_idle_cycles",
                 "Cyles of all bank idle in rank", "rank", config_.ranks);
-    InitVecStat("rank_active_cycles", "vec_counter", "Cyles of rank active",
+    InitVecCounterStat(VecCounterStat::RANK_ACTIVE_CYCLES, "rank_active_cycles", "Cyles of rank active",
                 "rank", config_.ranks);
-    InitVecStat("sref_cycles", "vec_counter", "Cyles of rank in SREF mode",
+    InitVecCounterStat(VecCounterStat::SREF_CYCLES, "sref_cycles", "Cyles of rank in SREF mode",
                 "rank", config_.ranks);
 
     // Vector of double stats
@@ -68,9 +190,9 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
                 config_.ranks);
 
     // Histogram stats
-    InitHistoStat("read_latency", "Read request latency (cycles)", 0, 200, 10);
-    InitHistoStat("write_latency", "Write cmd latency (cycles)", 0, 200, 10);
-    InitHistoStat("interarrival_latency",
+    InitHistoStat(HistoStat::READ_LATENCY, "read_latency", "Read request latency (cycles)", 0, 200, 10);
+    InitHistoStat(HistoStat::WRITE_LATENCY, "write_latency", "Write cmd latency (cycles)", 0, 200, 10);
+    InitHistoStat(HistoStat::INTERARRIVAL_LATENCY, "interarrival_latency",
                   "Request interarrival latency (cycles)", 0, 100, 10);
 
     // some irregular stats
@@ -83,13 +205,8 @@ SimpleStats::SimpleStats(const Config& config, int channel_id)
              "Average request interarrival latency (cycles)");
 }
 
-void SimpleStats::AddValue(const std::string name, const int value) {
-    auto& epoch_counts = epoch_histo_counts_[name];
-    if (epoch_counts.count(value) <= 0) {
-        epoch_counts[value] = 1;
-    } else {
-        epoch_counts[value] += 1;
-    }
+void SimpleStats::AddValue(HistoStat stat, const int value) {
+    epoch_histos_[static_cast<int>(stat)].Record(value);
 }
 
 std::string SimpleStats::GetTextHeader(bool is_final) const {
@@ -98,7 +215,9 @@ std::string SimpleStats::GetTextHeader(bool is_final) const {
         "Channel " +
         std::to_string(channel_id_);
     if (!is_final) {
-        header += " of epoch " + std::to_string(counters_.at("epoch_num"));
+        header += " of epoch " +
+                  std::to_string(
+                      counters_[static_cast<int>(CounterStat::EPOCH_NUM)]);
     }
     header += "\n###########################################\n";
     return header;
@@ -144,17 +263,13 @@ void SimpleStats::PrintFinalStats() {
 }
 
 void SimpleStats::Reset() {
-    for (auto& it : counters_) {
-        it.second = 0;
-    }
-    for (auto& it : epoch_counters_) {
-        it.second = 0;
-    }
+    std::fill(counters_.begin(), counters_.end(), 0);
+    std::fill(epoch_counters_.begin(), epoch_counters_.end(), 0);
     for (auto& vec : vec_counters_) {
-        std::fill(vec.second.begin(), vec.second.end(), 0);
+        std::fill(vec.begin(), vec.end(), 0);
     }
     for (auto& vec : epoch_vec_counters_) {
-        std::fill(vec.second.begin(), vec.second.end(), 0);
+        std::fill(vec.begin(), vec.end(), 0);
     }
     for (auto& it : doubles_) {
         it.second = 0.0;
@@ -165,27 +280,43 @@ void SimpleStats::Reset() {
     for (auto& it : calculated_) {
         it.second = 0.0;
     }
-    for (auto& it : histo_counts_) {
-        it.second.clear();
+    for (auto& histo : histos_) {
+        histo.Clear();
     }
-    for (auto& it : epoch_histo_counts_) {
-        it.second.clear();
+    for (auto& histo : epoch_histos_) {
+        histo.Clear();
     }
 }
 
+void SimpleStats::Serialize(Checkpoint& cp) {
+    // the rest is either set up from the config or worked out from these
+    // when the stats are printed
+    cp.Field(counters_);
+    cp.Field(epoch_counters_);
+    cp.Field(vec_counters_);
+    cp.Field(epoch_vec_counters_);
+    cp.Field(histos_);
+    cp.Field(epoch_histos_);
+    cp.Field(histo_bins_);
+    cp.Field(epoch_histo_bins_);
+}
+
 void SimpleStats::InitStat(std::string name, std::string stat_type,
                            std::string description) {
     header_descs_.emplace(name, description);
-    if (stat_type == "counter") {
-        counters_.emplace(name, 0);
-        epoch_counters_.emplace(name, 0);
-    } else if (stat_type == "double") {
+    if (stat_type == "double") {
         doubles_.emplace(name, 0.0);
     } else if (stat_type == "calculated") {
         calculated_.emplace(name, 0.0);
     }
 }
 
+void SimpleStats::InitCounterStat(CounterStat stat, std::string name,
+                                  std::string description) {
+    header_descs_.emplace(name, description);
+    counter_ids_.emplace(name, static_cast<int>(stat));
+}
+
 void SimpleStats::InitVecStat(std::string name, std::string stat_type,
                               std::string description, std::string part_name,
                               int vec_len) {
@@ -195,21 +326,29 @@ void SimpleStats::InitVecStat(std::string name, std::string stat_type,
         std::string actual_desc = description + " " + part_name + trailing;
         header_descs_.emplace(actual_name, actual_desc);
     }
-    if (stat_type == "vec_counter") {
-        vec_counters_.emplace(name, std::vector<uint64_t>(vec_len, 0));
-        epoch_vec_counters_.emplace(name, std::vector<uint64_t>(vec_len, 0));
-    } else if (stat_type == "vec_double") {
+    if (stat_type == "vec_double") {
         vec_doubles_.emplace(name, std::vector<double>(vec_len, 0));
     }
 }
 
-void SimpleStats::InitHistoStat(std::string name, std::string description,
-                                int start_val, int end_val, int num_bins) {
+void SimpleStats::InitVecCounterStat(VecCounterStat stat, std::string name,
+                                     std::string description,
+                                     std::string part_name, int vec_len) {
+    InitVecStat(name, "vec_counter", description, part_name, vec_len);
+    int id = static_cast<int>(stat);
+    vec_counter_ids_.emplace(name, id);
+    vec_counters_[id].resize(vec_len, 0);
+    epoch_vec_counters_[id].resize(vec_len, 0);
+}
+
+void SimpleStats::InitHistoStat(HistoStat stat, std::string name,
+                                std::string description, int start_val,
+                                int end_val, int num_bins) {
+    int id = static_cast<int>(stat);
+    histo_ids_.emplace(name, id);
     int bin_width = (end_val - start_val) / num_bins;
-    bin_widths_.emplace(name, bin_width);
-    histo_bounds_.emplace(name, std::make_pair(start_val, end_val));
-    histo_counts_.emplace(name, std::unordered_map<int, uint64_t>());
-    epoch_histo_counts_.emplace(name, std::unordered_map<int, uint64_t>());
+    bin_widths_[id] = bin_width;
+    histo_bounds_[id] = std::make_pair(start_val, end_val);
 
     // initialize headers, descriptions
     std::vector<std::string> headers;
@@ -227,103 +366,101 @@ void SimpleStats::InitHistoStat(std::string name, std::string description,
     headers.push_back(header);
     header_descs_.emplace(header, description);
 
-    histo_headers_.emplace(name, headers);
+    histo_headers_[id] = headers;
+
+    for (auto percentile : kPercentiles) {
+        header = fmt::format("{}[p{}]", name, percentile);
+        percentile_headers_[id].push_back(header);
+        header_descs_.emplace(header, fmt::format("{} {}th percentile",
+                                                  description, percentile));
+    }
 
     // +2 for front and end
-    histo_bins_.emplace(name, std::vector<uint64_t>(num_bins + 2, 0));
-    epoch_histo_bins_.emplace(name, std::vector<uint64_t>(num_bins + 2, 0));
+    histo_bins_[id].resize(num_bins + 2, 0);
+    epoch_histo_bins_[id].resize(num_bins + 2, 0);
 }
 
 void SimpleStats::UpdateCounters() {
-    for (const auto& it : epoch_counters_) {
-        counters_[it.first] += it.second;
+    for (size_t i = 0; i < epoch_counters_.size(); i++) {
+        counters_[i] += epoch_counters_[i];
     }
-    for (const auto& vec : epoch_vec_counters_) {
-        for (size_t i = 0; i < vec.second.size(); i++) {
-            vec_counters_[vec.first][i] += vec.second[i];
+    for (size_t id = 0; id < epoch_vec_counters_.size(); id++) {
+        const auto& vec = epoch_vec_counters_[id];
+        for (size_t i = 0; i < vec.size(); i++) {
+            vec_counters_[id][i] += vec[i];
         }
     }
 }
 
 void SimpleStats::UpdateHistoBins() {
-    for (auto& name_bins : epoch_histo_bins_) {
-        const auto& name = name_bins.first;
-        auto& bins = name_bins.second;
+    for (size_t id = 0; id < epoch_histo_bins_.size(); id++) {
+        auto& bins = epoch_histo_bins_[id];
+        const auto& bounds = histo_bounds_[id];
         std::fill(bins.begin(), bins.end(), 0);
-        for (const auto it : epoch_histo_counts_[name]) {
-            int value = it.first;
-            uint64_t count = it.second;
+        // values in a bucket are only told apart to its precision, which is
+        // exact for the range the bins usually cover
+        for (const auto& val_cnt : epoch_histos_[id].Buckets()) {
+            uint64_t value = val_cnt.first;
+            uint64_t count = val_cnt.second;
             int bin_idx = 0;
-            if (value < histo_bounds_[name].first) {
+            if (value < static_cast<uint64_t>(bounds.first)) {
                 bin_idx = 0;
-            } else if (value > histo_bounds_[name].second) {
+            } else if (value > static_cast<uint64_t>(bounds.second)) {
                 bin_idx = bins.size() - 1;
             } else {
-                bin_idx =
-                    (value - histo_bounds_[name].first) / bin_widths_[name] + 1;
+                bin_idx = (value - bounds.first) / bin_widths_[id] + 1;
             }
             bins[bin_idx] += count;
         }
     }
 
     // update overall histogram counts based on epoch histo counts
-    for (auto& name_counts : epoch_histo_counts_) {
-        const auto& name = name_counts.first;
-        auto& epoch_counts = name_counts.second;
-        auto& final_counts = histo_counts_[name];
-        for (const auto& val_cnt : epoch_counts) {
-            if (final_counts.count(val_cnt.first) <= 0) {
-                final_counts[val_cnt.first] = val_cnt.second;
-            } else {
-                final_counts[val_cnt.first] += val_cnt.second;
-            }
-        }
-        auto& final_bins = histo_bins_[name];
+    for (size_t id = 0; id < epoch_histos_.size(); id++) {
+        histos_[id].Merge(epoch_histos_[id]);
+        auto& final_bins = histo_bins_[id];
         for (size_t i = 0; i < final_bins.size(); i++) {
-            final_bins[i] += epoch_histo_bins_[name][i];
+            final_bins[i] += epoch_histo_bins_[id][i];
         }
     }
 }
 
-double SimpleStats::GetHistoAvg(const HistoCount& hist_counts) const {
-    uint64_t accu_sum = 0;
-    uint64_t count = 0;
-    for (auto i = hist_counts.begin(); i != hist_counts.end(); i++) {
-        accu_sum += i->first * i->second;
-        count += i->second;
-    }
-    return count == 0
-               ? 0.0
-               : static_cast<double>(accu_sum) / static_cast<double>(count);
-}
-
 void SimpleStats::UpdatePrints(bool epoch) {
     j_data_["channel"] = channel_id_;
 
-    std::unordered_map<std::string, uint64_t>& ref_counters =
-        epoch ? epoch_counters_ : counters_;
-    for (const auto& it : ref_counters) {
-        print_pairs_.emplace_back(it.first, std::to_string(it.second));
-        j_data_[it.first] = it.second;
+    const auto& ref_counters = epoch ? epoch_counters_ : counters_;
+    for (const auto& it : counter_ids_) {
+        print_pairs_.emplace_back(it.first,
+                                  std::to_string(ref_counters[it.second]));
+        j_data_[it.first] = ref_counters[it.second];
     }
-    j_data_["epoch_num"] = counters_["epoch_num"];
+    j_data_["epoch_num"] = counters_[static_cast<int>(CounterStat::EPOCH_NUM)];
 
-    VecStat& ref_vcounter = epoch ? epoch_vec_counters_ : vec_counters_;
-    for (const auto& it : ref_vcounter) {
+    const VecStat& ref_vcounter = epoch ? epoch_vec_counters_ : vec_counters_;
+    for (const auto& it : vec_counter_ids_) {
+        const auto& vec = ref_vcounter[it.second];
         Json j_list;
-        for (size_t i = 0; i < it.second.size(); i++) {
+        for (size_t i = 0; i < vec.size(); i++) {
             std::string name = it.first + "." + std::to_string(i);
-            print_pairs_.emplace_back(name, std::to_string(it.second[i]));
-            j_list[std::to_string(i)] = it.second[i];
+            print_pairs_.emplace_back(name, std::to_string(vec[i]));
+            j_list[std::to_string(i)] = vec[i];
         }
         j_data_[it.first] = j_list;
     }
-    VecStat& ref_hbins = epoch ? epoch_histo_bins_ : histo_bins_;
-    for (const auto& it : ref_hbins) {
-        const auto& names = histo_headers_[it.first];
-        for (size_t i = 0; i < it.second.size(); i++) {
-            print_pairs_.emplace_back(names[i], std::to_string(it.second[i]));
-            j_data_[names[i]] = it.second[i];
+    const VecStat& ref_hbins = epoch ? epoch_histo_bins_ : histo_bins_;
+    for (const auto& it : histo_ids_) {
+        const auto& names = histo_headers_[it.second];
+        const auto& bins = ref_hbins[it.second];
+        for (size_t i = 0; i < bins.size(); i++) {
+            print_pairs_.emplace_back(names[i], std::to_string(bins[i]));
+            j_data_[names[i]] = bins[i];
+        }
+        const auto& histo =
+            epoch ? epoch_histos_[it.second] : histos_[it.second];
+        const auto& pct_names = percentile_headers_[it.second];
+        for (size_t i = 0; i < kPercentiles.size(); i++) {
+            uint64_t value = histo.ValueAtPercentile(kPercentiles[i]);
+            print_pairs_.emplace_back(pct_names[i], std::to_string(value));
+            j_data_[pct_names[i]] = value;
         }
     }
 
@@ -331,12 +468,12 @@ void SimpleStats::UpdatePrints(bool epoch) {
     // huge therefore we only put aggregated histo in each epoch but
     // complete data at the end
     if (!epoch) {
-        for (const auto& name_hist : histo_counts_) {
+        for (const auto& it : histo_ids_) {
             Json j_list;
-            for (const auto& it : name_hist.second) {
-                j_list[std::to_string(it.first)] = it.second;
+            for (const auto& val_cnt : histos_[it.second].Buckets()) {
+                j_list[std::to_string(val_cnt.first)] = val_cnt.second;
             }
-            j_data_[name_hist.first] = j_list;
+            j_data_[it.first] = j_list;
         }
     }
 
@@ -360,43 +497,47 @@ void SimpleStats::UpdatePrints(bool epoch) {
     }
 }
 
-void SimpleStats::UpdateEpochStats() {
-    // push counter values as is
-    UpdateCounters();
+void SimpleStats::UpdateComputedStats(
+    const std::vector<uint64_t>& counters, const VecStat& vec_counters,
+    const std::vector<LogLinearHistogram>& histos) {
+    auto counter = [&counters](CounterStat stat) {
+        return counters[static_cast<int>(stat)];
+    };
+    auto vec_counter = [&vec_counters](VecCounterStat stat, int i) {
+        return vec_counters[static_cast<int>(stat)][i];
+    };
 
     // update computed stats
     doubles_["act_energy"] =
-        epoch_counters_["num_act_cmds"] * config_.act_energy_inc;
+        counter(CounterStat::NUM_ACT_CMDS) * config_.act_energy_inc;
     doubles_["read_energy"] =
-        epoch_counters_["num_read_cmds"] * config_.read_energy_inc;
+        counter(CounterStat::NUM_READ_CMDS) * config_.read_energy_inc;
     doubles_["write_energy"] =
-        epoch_counters_["num_write_cmds"] * config_.write_energy_inc;
+        counter(CounterStat::NUM_WRITE_CMDS) * config_.write_energy_inc;
     doubles_["ref_energy"] =
-        epoch_counters_["num_ref_cmds"] * config_.ref_energy_inc;
+        counter(CounterStat::NUM_REF_CMDS) * config_.ref_energy_inc;
     doubles_["refb_energy"] =
-        epoch_counters_["num_refb_cmds"] * config_.refb_energy_inc;
+        counter(CounterStat::NUM_REFB_CMDS) * config_.refb_energy_inc;
 
     // vector doubles, update first, then push
     double background_energy = 0.0;
     for (int i = 0; i < config_.ranks; i++) {
-        double act_stb = epoch_vec_counters_["rank_active_cycles"][i] *
+        double act_stb = vec_counter(VecCounterStat::RANK_ACTIVE_CYCLES, i) *
                          config_.act_stb_energy_inc;
-        double pre_stb = epoch_vec_counters_["all_bank_idle_cycles"][i] *
+        double pre_stb = vec_counter(VecCounterStat::ALL_BANK_IDLE_CYCLES, i) *
                          config_.pre_stb_energy_inc;
-        double sref_energy =
-            epoch_vec_counters_["sref_cycles"][i] * config_.sref_energy_inc;
+        double sref_energy = vec_counter(VecCounterStat::SREF_CYCLES, i) *
+                             config_.sref_energy_inc;
         vec_doubles_["act_stb_energy"][i] = act_stb;
         vec_doubles_["pre_stb_energy"][i] = pre_stb;
         vec_doubles_["sref_energy"][i] = sref_energy;
         background_energy += act_stb + pre_stb + sref_energy;
     }
 
-    UpdateHistoBins();
-
     // calculated stats
-    uint64_t total_reqs =
-        epoch_counters_["num_reads_done"] + epoch_counters_["num_writes_done"];
-    double total_time = epoch_counters_["num_cycles"] * config_.tCK;
+    uint64_t total_reqs = counter(CounterStat::NUM_READS_DONE) +
+                          counter(CounterStat::NUM_WRITES_DONE);
+    double total_time = counter(CounterStat::NUM_CYCLES) * config_.tCK;
     double avg_bw = total_reqs * config_.request_size_bytes / total_time;
     calculated_["average_bandwidth"] = avg_bw;
 
@@ -404,76 +545,39 @@ void SimpleStats::UpdateEpochStats() {
                           doubles_["write_energy"] + doubles_["ref_energy"] +
                           doubles_["refb_energy"] + background_energy;
     calculated_["total_energy"] = total_energy;
-    calculated_["average_power"] = total_energy / epoch_counters_["num_cycles"];
+    calculated_["average_power"] =
+        total_energy / counter(CounterStat::NUM_CYCLES);
     calculated_["average_read_latency"] =
-        GetHistoAvg(epoch_histo_counts_.at("read_latency"));
+        histos[static_cast<int>(HistoStat::READ_LATENCY)].Average();
     calculated_["average_interarrival"] =
-        GetHistoAvg(epoch_histo_counts_.at("interarrival_latency"));
+        histos[static_cast<int>(HistoStat::INTERARRIVAL_LATENCY)].Average();
+}
+
+void SimpleStats::UpdateEpochStats() {
+    // push counter values as is
+    UpdateCounters();
+    UpdateHistoBins();
+    UpdateComputedStats(epoch_counters_, epoch_vec_counters_, epoch_histos_);
 
     UpdatePrints(true);
-    for (auto& it : epoch_counters_) {
-        it.second = 0;
-    }
+    std::fill(epoch_counters_.begin(), epoch_counters_.end(), 0);
     for (auto& vec : epoch_vec_counters_) {
-        std::fill(vec.second.begin(), vec.second.end(), 0);
+        std::fill(vec.begin(), vec.end(), 0);
     }
-    for (auto& it : epoch_histo_counts_) {
-        it.second.clear();
+    for (auto& histo : epoch_histos_) {
+        histo.Clear();
     }
     return;
 }
 
 void SimpleStats::UpdateFinalStats() {
     UpdateCounters();
-
-    // update computed stats
-    doubles_["act_energy"] = counters_["num_act_cmds"] * config_.act_energy_inc;
-    doubles_["read_energy"] =
-        counters_["num_read_cmds"] * config_.read_energy_inc;
-    doubles_["write_energy"] =
-        counters_["num_write_cmds"] * config_.write_energy_inc;
-    doubles_["ref_energy"] = counters_["num_ref_cmds"] * config_.ref_energy_inc;
-    doubles_["refb_energy"] =
-        counters_["num_refb_cmds"] * config_.refb_energy_inc;
-
-    // vector doubles, update first, then push
-    double background_energy = 0.0;
-    for (int i = 0; i < config_.ranks; i++) {
-        double act_stb =
-            vec_counters_["rank_active_cycles"][i] * config_.act_stb_energy_inc;
-        double pre_stb = vec_counters_["all_bank_idle_cycles"][i] *
-                         config_.pre_stb_energy_inc;
-        double sref_energy =
-            vec_counters_["sref_cycles"][i] * config_.sref_energy_inc;
-        vec_doubles_["act_stb_energy"][i] = act_stb;
-        vec_doubles_["pre_stb_energy"][i] = pre_stb;
-        vec_doubles_["sref_energy"][i] = sref_energy;
-        background_energy += act_stb + pre_stb + sref_energy;
-    }
-
     // histograms
     UpdateHistoBins();
-
-    // calculated stats
-    uint64_t total_reqs =
-        counters_["num_reads_done"] + counters_["num_writes_done"];
-    double total_time = counters_["num_cycles"] * config_.tCK;
-    double avg_bw = total_reqs * config_.request_size_bytes / total_time;
-    calculated_["average_bandwidth"] = avg_bw;
-
-    double total_energy = doubles_["act_energy"] + doubles_["read_energy"] +
-                          doubles_["write_energy"] + doubles_["ref_energy"] +
-                          doubles_["refb_energy"] + background_energy;
-    calculated_["total_energy"] = total_energy;
-    calculated_["average_power"] = total_energy / counters_["num_cycles"];
-    // calculated_["average_read_latency"] = GetHistoAvg("read_latency");
-    calculated_["average_read_latency"] =
-        GetHistoAvg(histo_counts_.at("read_latency"));
-    calculated_["average_interarrival"] =
-        GetHistoAvg(histo_counts_.at("interarrival_latency"));
+    UpdateComputedStats(counters_, vec_counters_, histos_);
 
     UpdatePrints(false);
     return;
 }
 
-}  // namespace dramsim3
\ No newline at end of file
+}  // namespace dramsim3
@@ -1,34 +1,141 @@
 #ifndef __SIMPLE_STATS_
 #define __SIMPLE_STATS_
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "checkpoint.h"
 #include "configuration.h"
 #include "json.hpp"
 
 namespace dramsim3 {
 
+// stats updated during simulation are looked up by these ids, each stat
+// is given its name when it's registered in the SimpleStats constructor
+enum class CounterStat {
+    NUM_CYCLES,
+    EPOCH_NUM,
+    NUM_READS_DONE,
+    NUM_WRITES_DONE,
+    NUM_WRITE_BUF_HITS,
+    NUM_READ_ROW_HITS,
+    NUM_WRITE_ROW_HITS,
+    NUM_READ_CMDS,
+    NUM_WRITE_CMDS,
+    NUM_ACT_CMDS,
+    NUM_PRE_CMDS,
+    NUM_ONDEMAND_PRES,
+    NUM_REF_CMDS,
+    NUM_REFB_CMDS,
+    NUM_SREFE_CMDS,
+    NUM_SREFX_CMDS,
+    HBM_DUAL_CMDS,
+    NUM_WRITE_DRAINS,
+    NUM_RD_TO_WR_TURNAROUNDS,
+    NUM_WR_TO_RD_TURNAROUNDS,
+    NUM_REFS_POSTPONED,
+    NUM_REFS_PULLED_IN,
+    NUM_REFS_FORCED,
+    // rowclone added
+    NUM_READ_COPY_CMDS,
+    NUM_WRITE_COPY_CMDS,
+    NUM_COPIES_DONE,
+    SIZE
+};
+
+enum class VecCounterStat {
+    ALL_BANK_IDLE_CYCLES,
+    RANK_ACTIVE_CYCLES,
+    SREF_CYCLES,
+    SIZE
+};
+
+enum class HistoStat { READ_LATENCY, WRITE_LATENCY, INTERARRIVAL_LATENCY, SIZE };
+
+// HDR style log-linear histogram. Values below 2 * kSubBuckets are counted
+// exactly, above that every power of 2 range is split into kSubBuckets
+// buckets, so a value is never off by more than 1 / kSubBuckets of itself.
+// Recording is constant time and the memory is fixed no matter how many
+// distinct values there are.
+class LogLinearHistogram {
+   public:
+    LogLinearHistogram();
+    void Record(int value) {
+        uint64_t val = value < 0 ? 0 : static_cast<uint64_t>(value);
+        int index = BucketIndex(val);
+        counts_[index]++;
+        count_++;
+        sum_ += val;
+        min_index_ = std::min(min_index_, index);
+        max_index_ = std::max(max_index_, index);
+    }
+    void Merge(const LogLinearHistogram& other);
+    void Clear();
+    uint64_t Count() const { return count_; }
+    double Average() const;
+    // highest value that percentile percent of the recorded values are at or
+    // below, to the precision of the bucket it falls in
+    uint64_t ValueAtPercentile(double percentile) const;
+    // lowest value of every non-empty bucket with its count
+    std::vector<std::pair<uint64_t, uint64_t> > Buckets() const;
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+   private:
+    static const int kSubBucketBits = 7;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static int BucketIndex(uint64_t value) {
+        if (value < 2 * kSubBuckets) {
+            return static_cast<int>(value);
+        }
+        int shift = 63 - __builtin_clzll(value) - kSubBucketBits;
+        return kSubBuckets * shift + static_cast<int>(value >> shift);
+    }
+    static uint64_t LowestValue(int index);
+    static uint64_t HighestValue(int index);
+
+    std::vector<uint64_t> counts_;
+    uint64_t count_;
+    uint64_t sum_;
+    // range of buckets that may be non-empty
+    int min_index_;
+    int max_index_;
+};
+
 class SimpleStats {
    public:
     SimpleStats(const Config& config, int channel_id);
     // incrementing counter
-    void Increment(const std::string name) { epoch_counters_[name] += 1; }
+    void Increment(CounterStat stat) {
+        epoch_counters_[static_cast<int>(stat)] += 1;
+    }
+
+    // increment counter by number
+    void IncrementBy(CounterStat stat, uint64_t num) {
+        epoch_counters_[static_cast<int>(stat)] += num;
+    }
 
     // incrementing for vec counter
-    void IncrementVec(const std::string name, int pos) {
-        epoch_vec_counters_[name][pos] += 1;
+    void IncrementVec(VecCounterStat stat, int pos) {
+        epoch_vec_counters_[static_cast<int>(stat)][pos] += 1;
     }
 
     // increment vec counter by number
-    void IncrementVecBy(const std::string name, int pos, int num) {
-        epoch_vec_counters_[name][pos] += num;
+    void IncrementVecBy(VecCounterStat stat, int pos, int num) {
+        epoch_vec_counters_[static_cast<int>(stat)][pos] += num;
+    }
+
+    // counter value so far, valid until the final stats are printed
+    uint64_t Count(CounterStat stat) const {
+        int i = static_cast<int>(stat);
+        return counters_[i] + epoch_counters_[i];
     }
 
     // add historgram value
-    void AddValue(const std::string name, const int value);
+    void AddValue(HistoStat stat, const int value);
 
     // Epoch update
     void PrintEpochStats();
@@ -39,23 +146,35 @@ class SimpleStats {
     // Reset (usually after one phase of simulation)
     void Reset();
 
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
    private:
-    using VecStat = std::unordered_map<std::string, std::vector<uint64_t> >;
-    using HistoCount = std::unordered_map<int, uint64_t>;
+    using VecStat = std::vector<std::vector<uint64_t> >;
     using Json = nlohmann::json;
     void InitStat(std::string name, std::string stat_type,
                   std::string description);
+    void InitCounterStat(CounterStat stat, std::string name,
+                         std::string description);
     void InitVecStat(std::string name, std::string stat_type,
                      std::string description, std::string part_name,
                      int vec_len);
-    void InitHistoStat(std::string name, std::string description, int start_val,
-                       int end_val, int num_bins);
+    void InitVecCounterStat(VecCounterStat stat, std::string name,
+                            std::string description, std::string part_name,
+                            int vec_len);
+    void InitHistoStat(HistoStat stat, std::string name,
+                       std::string description, int start_val, int end_val,
+                       int num_bins);
 
     void UpdateCounters();
     void UpdateHistoBins();
     void UpdatePrints(bool epoch);
-    double GetHistoAvg(const HistoCount& histo_counts) const;
     std::string GetTextHeader(bool is_final) const;
+    // energy, power, bandwidth and averages from either the epoch or the
+    // overall counters
+    void UpdateComputedStats(const std::vector<uint64_t>& counters,
+                             const VecStat& vec_counters,
+                             const std::vector<LogLinearHistogram>& histos);
     void UpdateEpochStats();
     void UpdateFinalStats();
 
@@ -65,11 +184,17 @@ class SimpleStats {
     // map names to descriptions
     std::unordered_map<std::string, std::string> header_descs_;
 
-    // counter stats, indexed by their name
-    std::unordered_map<std::string, uint64_t> counters_;
-    std::unordered_map<std::string, uint64_t> epoch_counters_;
+    // names of the stats that have ids, the stats are printed in the order
+    // these are iterated in
+    std::unordered_map<std::string, int> counter_ids_;
+    std::unordered_map<std::string, int> vec_counter_ids_;
+    std::unordered_map<std::string, int> histo_ids_;
+
+    // counter stats, indexed by their id
+    std::vector<uint64_t> counters_;
+    std::vector<uint64_t> epoch_counters_;
 
-    // vectored counter stats, first indexed by name then by index
+    // vectored counter stats, first indexed by id then by index
     VecStat vec_counters_;
     VecStat epoch_vec_counters_;
 
@@ -83,13 +208,14 @@ class SimpleStats {
     // calculated stats, similar to double, but not the same
     std::unordered_map<std::string, double> calculated_;
 
-    // histogram stats
-    std::unordered_map<std::string, std::vector<std::string> > histo_headers_;
+    // histogram stats, indexed by their id
+    std::vector<std::vector<std::string> > histo_headers_;
+    std::vector<std::vector<std::string> > percentile_headers_;
 
-    std::unordered_map<std::string, std::pair<int, int> > histo_bounds_;
-    std::unordered_map<std::string, int> bin_widths_;
-    std::unordered_map<std::string, HistoCount> histo_counts_;
-    std::unordered_map<std::string, HistoCount> epoch_histo_counts_;
+    std::vector<std::pair<int, int> > histo_bounds_;
+    std::vector<int> bin_widths_;
+    std::vector<LogLinearHistogram> histos_;
+    std::vector<LogLinearHistogram> epoch_histos_;
     VecStat histo_bins_;
     VecStat epoch_histo_bins_;
 
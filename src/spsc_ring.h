@@ -0,0 +1,54 @@
+#ifndef __SPSC_RING_H
+#define __SPSC_RING_H
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+
+namespace dramsim3 {
+
+// single producer single consumer ring, one thread pushes and another one
+// pops, neither ever waits on the other
+template <typename T>
+class SPSCRing {
+   public:
+    SPSCRing(int capacity) : head_(0), tail_(0) {
+        uint64_t num_items = 1;
+        while (num_items < static_cast<uint64_t>(capacity)) {
+            num_items <<= 1;
+        }
+        items_.resize(num_items);
+        mask_ = num_items - 1;
+    }
+    // false if the ring is full
+    bool Push(const T& item) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        items_[head & mask_] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    // pops up to max_items into items, returns how many
+    size_t Pop(T* items, size_t max_items) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        size_t num_items = 0;
+        while (tail != head && num_items < max_items) {
+            items[num_items++] = items_[tail & mask_];
+            tail++;
+        }
+        tail_.store(tail, std::memory_order_release);
+        return num_items;
+    }
+
+   private:
+    std::vector<T> items_;
+    uint64_t mask_;
+    std::atomic<uint64_t> head_;
+    std::atomic<uint64_t> tail_;
+};
+
+}  // namespace dramsim3
+#endif
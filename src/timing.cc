@@ -565,4 +565,23 @@ Timing::Timing(const Config& config)
             {CommandType::SREF_ENTER, self_refresh_exit}};
 }
 
+const std::vector<std::vector<std::pair<CommandType, int> > >& Timing::Lists(
+    TimingScope scope) const {
+    switch (scope) {
+        case TimingScope::SAME_BANK:
+            return same_bank;
+        case TimingScope::OTHER_BANKS_SAME_BANKGROUP:
+            return other_banks_same_bankgroup;
+        case TimingScope::OTHER_BANKGROUPS_SAME_RANK:
+            return other_bankgroups_same_rank;
+        case TimingScope::OTHER_RANKS:
+            return other_ranks;
+        case TimingScope::SAME_RANK:
+            return same_rank;
+        default:
+            AbruptExit(__FILE__, __LINE__);
+            return same_rank;
+    }
+}
+
 }  // namespace dramsim3
@@ -7,6 +7,17 @@
 
 namespace dramsim3 {
 
+// Which banks a timing constraint of a command applies to, relative to the
+// bank (or rank) the command is issued to
+enum class TimingScope {
+    SAME_BANK,
+    OTHER_BANKS_SAME_BANKGROUP,
+    OTHER_BANKGROUPS_SAME_RANK,
+    OTHER_RANKS,
+    SAME_RANK,
+    SIZE
+};
+
 class Timing {
    public:
     Timing(const Config& config);
@@ -18,6 +29,11 @@ class Timing {
     std::vector<std::vector<std::pair<CommandType, int> > > other_ranks;
     std::vector<std::vector<std::pair<CommandType, int> > > same_rank;
 
+    // the lists above by scope, for each command the commands it delays and
+    // by how much
+    const std::vector<std::vector<std::pair<CommandType, int> > >& Lists(
+        TimingScope scope) const;
+
 };
 
 }  // namespace dramsim3
@@ -0,0 +1,67 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include "./../ext/headers/args.hxx"
+#include "binary_trace.h"
+
+// this will not be used in a library file so it's ok to do this
+using namespace dramsim3;
+
+int main(int argc, const char** argv) {
+    args::ArgumentParser parser(
+        "Converts a text trace to the binary trace format.",
+        "Example: \n"
+        "./build/traceconvert tests/example.trace example.bin");
+    args::HelpFlag help(parser, "help", "Display the help menu", {'h', "help"});
+    args::ValueFlag<uint32_t> interval_arg(
+        parser, "index_interval", "Records between two index entries",
+        {'i', "index-interval"}, 4096);
+    args::Positional<std::string> input_arg(parser, "input",
+                                            "Text trace (mandatory)");
+    args::Positional<std::string> output_arg(parser, "output",
+                                             "Binary trace (mandatory)");
+
+    try {
+        parser.ParseCLI(argc, argv);
+    } catch (args::Help) {
+        std::cout << parser;
+        return 0;
+    } catch (args::ParseError e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::string input = args::get(input_arg);
+    std::string output = args::get(output_arg);
+    if (input.empty() || output.empty()) {
+        std::cerr << parser;
+        return 1;
+    }
+
+    std::ifstream text_trace(input);
+    if (text_trace.fail()) {
+        std::cerr << "Trace file does not exist" << std::endl;
+        return 1;
+    }
+    BinaryTraceWriter writer(output, args::get(interval_arg));
+    std::string line;
+    Transaction trans;
+    // line by line, so a line that doesn't parse is reported as such
+    while (std::getline(text_trace, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        std::istringstream is(line);
+        if (!(is >> trans)) {
+            std::cerr << "Cannot parse trace line: " << line << std::endl;
+            return 1;
+        }
+        writer.Add(trans);
+    }
+    writer.Close();
+    std::cout << writer.NumRecords() << " transactions written to " << output
+              << std::endl;
+    return 0;
+}
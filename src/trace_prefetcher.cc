@@ -0,0 +1,97 @@
+#include "trace_prefetcher.h"
+#include <chrono>
+#include <iostream>
+
+namespace dramsim3 {
+
+namespace {
+const int kRingSize = 1 << 16;
+const int kChunkSize = 1024;
+}  // namespace
+
+TracePrefetcher::TracePrefetcher(const std::string& trace_file,
+                                 uint64_t start_cycle)
+    : start_cycle_(start_cycle),
+      ring_(kRingSize),
+      done_(false),
+      stop_(false),
+      chunk_(kChunkSize),
+      chunk_size_(0),
+      next_(0),
+      taken_(0) {
+    if (BinaryTraceReader::IsBinaryTrace(trace_file)) {
+        binary_trace_.reset(new BinaryTraceReader(trace_file));
+        binary_trace_->Seek(start_cycle);
+    } else {
+        text_trace_.open(trace_file);
+        if (text_trace_.fail()) {
+            std::cerr << "Trace file does not exist" << std::endl;
+            AbruptExit(__FILE__, __LINE__);
+        }
+    }
+    reader_ = std::thread(&TracePrefetcher::ReaderLoop, this);
+}
+
+TracePrefetcher::~TracePrefetcher() {
+    stop_.store(true, std::memory_order_release);
+    reader_.join();
+}
+
+void TracePrefetcher::Serialize(Checkpoint& cp) {
+    cp.Expect(start_cycle_, "trace start cycle");
+    uint64_t taken = taken_;
+    cp.Field(taken);
+    if (taken < taken_) {
+        std::cerr << "Checkpoint is further back in the trace than this run"
+                  << std::endl;
+        AbruptExit(__FILE__, __LINE__);
+    }
+    Transaction trans;
+    while (taken_ < taken && Next(trans)) {
+    }
+}
+
+bool TracePrefetcher::Refill() {
+    while (true) {
+        // anything pushed before done_ is set is popped after seeing it
+        bool done = done_.load(std::memory_order_acquire);
+        chunk_size_ = ring_.Pop(chunk_.data(), chunk_.size());
+        next_ = 0;
+        if (chunk_size_ > 0) {
+            return true;
+        }
+        if (done) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool TracePrefetcher::Read(Transaction& trans) {
+    if (binary_trace_) {
+        return binary_trace_->Next(trans);
+    }
+    return static_cast<bool>(text_trace_ >> trans);
+}
+
+void TracePrefetcher::ReaderLoop() {
+    Transaction trans;
+    // the binary trace is already there, a text one has to be parsed
+    // through up to start_cycle_
+    bool skipping = true;
+    while (!stop_.load(std::memory_order_acquire) && Read(trans)) {
+        if (skipping && trans.added_cycle < start_cycle_) {
+            continue;
+        }
+        skipping = false;
+        while (!ring_.Push(trans)) {
+            if (stop_.load(std::memory_order_acquire)) {
+                return;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+    done_.store(true, std::memory_order_release);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,65 @@
+#ifndef __TRACE_PREFETCHER_H
+#define __TRACE_PREFETCHER_H
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_trace.h"
+#include "checkpoint.h"
+#include "common.h"
+#include "spsc_ring.h"
+
+namespace dramsim3 {
+
+// Reads a text or binary trace on a thread of its own, ahead of the
+// simulation. Parsed transactions go through a ring and are taken out a
+// chunk at a time, so the simulation thread only touches the ring once per
+// chunk and never waits on the file unless it catches up with the reader.
+class TracePrefetcher {
+   public:
+    // starts at the first transaction added at or after start_cycle
+    TracePrefetcher(const std::string& trace_file, uint64_t start_cycle);
+    ~TracePrefetcher();
+    // next transaction of the trace, false once the trace is exhausted
+    bool Next(Transaction& trans) {
+        if (next_ == chunk_size_ && !Refill()) {
+            return false;
+        }
+        trans = chunk_[next_++];
+        // assigning an AddressPair doesn't carry the copy flag over
+        trans.addr.is_copy = trans.is_copy;
+        taken_++;
+        return true;
+    }
+    // saves how far into the trace the simulation is, and skips that far
+    // into it when restoring
+    void Serialize(Checkpoint& cp);
+
+   private:
+    std::ifstream text_trace_;
+    std::unique_ptr<BinaryTraceReader> binary_trace_;
+    uint64_t start_cycle_;
+
+    SPSCRing<Transaction> ring_;
+    std::thread reader_;
+    // set by the reader after its last push
+    std::atomic<bool> done_;
+    std::atomic<bool> stop_;
+
+    // what the simulation thread took out of the ring last
+    std::vector<Transaction> chunk_;
+    size_t chunk_size_;
+    size_t next_;
+    // transactions handed out by Next
+    uint64_t taken_;
+
+    bool Refill();
+    bool Read(Transaction& trans);
+    void ReaderLoop();
+};
+
+}  // namespace dramsim3
+#endif
@@ -0,0 +1,70 @@
+#include "transaction_queue.h"
+
+namespace dramsim3 {
+
+TransactionQueue::TransactionQueue(const Config& config)
+    : config_(config),
+      capacity_(0),
+      next_seq_(0),
+      bank_entries_(config.ranks * config.banks),
+      active_pos_(config.ranks * config.banks, -1) {}
+
+void TransactionQueue::reserve(size_t capacity) {
+    capacity_ = capacity;
+    trans_.reserve(capacity);
+    seqs_.reserve(capacity);
+    return;
+}
+
+void TransactionQueue::push_back(const Transaction& trans) {
+    const auto& addr = trans.src_address;
+    int bank_idx = BankIndex(addr);
+    if (bank_entries_[bank_idx].empty()) {
+        active_pos_[bank_idx] = static_cast<int>(active_banks_.size());
+        active_banks_.push_back(bank_idx);
+    }
+    bank_entries_[bank_idx].push_back({addr.row, next_seq_});
+    trans_.push_back(trans);
+    seqs_.push_back(next_seq_);
+    next_seq_++;
+    return;
+}
+
+void TransactionQueue::erase(const_iterator it) {
+    size_t i = it - trans_.begin();
+    int bank_idx = BankIndex(trans_[i].src_address);
+    auto& entries = bank_entries_[bank_idx];
+    for (auto entry = entries.begin(); entry != entries.end(); entry++) {
+        if (entry->seq == seqs_[i]) {
+            entries.erase(entry);
+            break;
+        }
+    }
+    if (entries.empty()) {
+        // swap the last active bank into the hole
+        int pos = active_pos_[bank_idx];
+        active_banks_[pos] = active_banks_.back();
+        active_pos_[active_banks_[pos]] = pos;
+        active_banks_.pop_back();
+        active_pos_[bank_idx] = -1;
+    }
+    trans_.erase(trans_.begin() + i);
+    seqs_.erase(seqs_.begin() + i);
+    return;
+}
+
+void TransactionQueue::Serialize(Checkpoint& cp) {
+    cp.Field(trans_);
+    cp.Field(seqs_);
+    cp.Field(next_seq_);
+    cp.Field(bank_entries_);
+    cp.Field(active_banks_);
+    cp.Field(active_pos_);
+}
+
+void TransactionQueue::RowEntry::Serialize(Checkpoint& cp) {
+    cp.Field(row);
+    cp.Field(seq);
+}
+
+}  // namespace dramsim3
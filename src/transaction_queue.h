@@ -0,0 +1,98 @@
+#ifndef __TRANSACTION_QUEUE_H
+#define __TRANSACTION_QUEUE_H
+
+#include <algorithm>
+#include <vector>
+#include "channel_state.h"
+#include "checkpoint.h"
+#include "common.h"
+#include "configuration.h"
+
+namespace dramsim3 {
+
+// Transactions waiting in the controller in the order they came in, also
+// indexed by (rank, bankgroup, bank, row) so the oldest one to an open row
+// can be found without going through the whole queue.
+class TransactionQueue {
+   public:
+    using const_iterator = std::vector<Transaction>::const_iterator;
+
+    TransactionQueue(const Config& config);
+    // the queue is full at capacity, same as a reserved vector
+    void reserve(size_t capacity);
+    size_t capacity() const { return capacity_; }
+    size_t size() const { return trans_.size(); }
+    bool empty() const { return trans_.empty(); }
+    const_iterator begin() const { return trans_.begin(); }
+    const_iterator end() const { return trans_.end(); }
+    const Transaction& operator[](size_t i) const { return trans_[i]; }
+    void push_back(const Transaction& trans);
+    void erase(const_iterator it);
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+    // index of the oldest transaction to a row that is open in its bank,
+    // among the banks accept(rank, bankgroup, bank) is true for, -1 if none
+    template <class Accept>
+    int OldestRowHit(const ChannelState& channel_state, Accept accept) const;
+
+   private:
+    struct RowEntry {
+        int row;
+        uint64_t seq;
+        void Serialize(Checkpoint& cp);
+    };
+
+    const Config& config_;
+    size_t capacity_;
+    std::vector<Transaction> trans_;
+    // arrival sequence numbers, increasing along the queue
+    std::vector<uint64_t> seqs_;
+    uint64_t next_seq_;
+
+    // per bank, oldest first
+    std::vector<std::vector<RowEntry>> bank_entries_;
+    // banks with anything queued, and where each of them is in the list
+    std::vector<int> active_banks_;
+    std::vector<int> active_pos_;
+
+    int BankIndex(const Address& addr) const {
+        return addr.rank * config_.banks +
+               addr.bankgroup * config_.banks_per_group + addr.bank;
+    }
+};
+
+template <class Accept>
+int TransactionQueue::OldestRowHit(const ChannelState& channel_state,
+                                   Accept accept) const {
+    uint64_t oldest_seq = next_seq_;
+    for (int bank_idx : active_banks_) {
+        int rank = bank_idx / config_.banks;
+        int bankgroup = bank_idx % config_.banks / config_.banks_per_group;
+        int bank = bank_idx % config_.banks_per_group;
+        if (!channel_state.IsRowOpen(rank, bankgroup, bank)) {
+            continue;
+        }
+        int open_row = channel_state.OpenRow(rank, bankgroup, bank);
+        for (const auto& entry : bank_entries_[bank_idx]) {
+            if (entry.seq >= oldest_seq) {
+                break;
+            }
+            if (entry.row == open_row) {
+                if (accept(rank, bankgroup, bank)) {
+                    oldest_seq = entry.seq;
+                }
+                break;
+            }
+        }
+    }
+    if (oldest_seq == next_seq_) {
+        return -1;
+    }
+    auto it = std::lower_bound(seqs_.begin(), seqs_.end(), oldest_seq);
+    return static_cast<int>(it - seqs_.begin());
+}
+
+}  // namespace dramsim3
+
+#endif
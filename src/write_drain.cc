@@ -0,0 +1,87 @@
+#include "write_drain.h"
+#include <algorithm>
+
+namespace dramsim3 {
+
+WriteDrain::WriteDrain(const Config& config, SimpleStats& simple_stats)
+    : config_(config),
+      simple_stats_(simple_stats),
+      high_watermark_(config.write_high_watermark),
+      low_watermark_(config.write_low_watermark),
+      left_(0),
+      rd_to_wr_penalty_(std::max(config.RL - config.WL + config.tRTRS, 0)),
+      wr_to_rd_penalty_(config.write_delay + config.tWTR_S),
+      last_column_(0),
+      epoch_turnaround_cycles_(0),
+      epoch_read_latency_(0),
+      epoch_reads_(0),
+      last_avg_read_latency_(0.0) {}
+
+void WriteDrain::Start(size_t buffered) {
+    left_ = static_cast<int>(buffered) - low_watermark_;
+    simple_stats_.Increment(CounterStat::NUM_WRITE_DRAINS);
+    return;
+}
+
+void WriteDrain::ColumnIssued(bool is_write) {
+    int column = is_write ? 2 : 1;
+    if (last_column_ == 1 && is_write) {
+        simple_stats_.Increment(CounterStat::NUM_RD_TO_WR_TURNAROUNDS);
+        epoch_turnaround_cycles_ += rd_to_wr_penalty_;
+    } else if (last_column_ == 2 && !is_write) {
+        simple_stats_.Increment(CounterStat::NUM_WR_TO_RD_TURNAROUNDS);
+        epoch_turnaround_cycles_ += wr_to_rd_penalty_;
+    }
+    last_column_ = column;
+    return;
+}
+
+void WriteDrain::EpochUpdate() {
+    if (config_.write_drain_adaptive) {
+        // a tenth of the bus lost to turnarounds is too much, otherwise
+        // reads getting a tenth slower than last epoch is
+        int step = std::max(config_.trans_queue_size / 16, 1);
+        double avg_read_latency =
+            epoch_reads_ > 0
+                ? static_cast<double>(epoch_read_latency_) / epoch_reads_
+                : last_avg_read_latency_;
+        if (epoch_turnaround_cycles_ * 10 >
+            static_cast<uint64_t>(config_.epoch_period)) {
+            low_watermark_ = std::max(low_watermark_ - step, 0);
+            high_watermark_ = std::min(high_watermark_ + step,
+                                       config_.write_high_watermark);
+        } else if (last_avg_read_latency_ > 0 &&
+                   avg_read_latency > 1.1 * last_avg_read_latency_) {
+            low_watermark_ = std::min(low_watermark_ + step,
+                                      high_watermark_ - 1);
+            high_watermark_ = std::max(high_watermark_ - step,
+                                       low_watermark_ + 1);
+        }
+        last_avg_read_latency_ = avg_read_latency;
+    }
+    epoch_turnaround_cycles_ = 0;
+    epoch_read_latency_ = 0;
+    epoch_reads_ = 0;
+    return;
+}
+
+void WriteDrain::Serialize(Checkpoint& cp) {
+    // the watermarks only change when they adapt, otherwise the ones in the
+    // config of the restoring run are kept
+    int high_watermark = high_watermark_;
+    int low_watermark = low_watermark_;
+    cp.Field(high_watermark);
+    cp.Field(low_watermark);
+    if (config_.write_drain_adaptive) {
+        high_watermark_ = high_watermark;
+        low_watermark_ = low_watermark;
+    }
+    cp.Field(left_);
+    cp.Field(last_column_);
+    cp.Field(epoch_turnaround_cycles_);
+    cp.Field(epoch_read_latency_);
+    cp.Field(epoch_reads_);
+    cp.Field(last_avg_read_latency_);
+}
+
+}  // namespace dramsim3
@@ -0,0 +1,71 @@
+#ifndef __WRITE_DRAIN_H
+#define __WRITE_DRAIN_H
+
+#include <cstdint>
+#include "checkpoint.h"
+#include "configuration.h"
+#include "simple_stats.h"
+
+namespace dramsim3 {
+
+// Decides when the controller stops taking reads to drain its write buffer.
+// An episode starts when the buffer reaches the high watermark, or holds
+// more than write_drain_idle writes while the command queue is empty, and
+// drains the buffer down to the low watermark as it was when the episode
+// started, so writes coming in meanwhile can't hold reads off for good.
+// In adaptive mode the watermarks move every epoch: apart if the data bus
+// lost too many cycles to read/write turnarounds, for fewer and longer
+// episodes, and together if reads got slower, for shorter ones.
+class WriteDrain {
+   public:
+    WriteDrain(const Config& config, SimpleStats& simple_stats);
+    bool IsDraining() const { return left_ > 0; }
+    int HighWatermark() const { return high_watermark_; }
+    int LowWatermark() const { return low_watermark_; }
+    bool ShouldStart(size_t buffered, bool cmd_queue_empty) const {
+        int writes = static_cast<int>(buffered);
+        return writes > low_watermark_ &&
+               (writes >= high_watermark_ ||
+                (writes > config_.write_drain_idle && cmd_queue_empty));
+    }
+    void Start(size_t buffered);
+    void WriteMoved() {
+        if (left_ > 0) {
+            left_--;
+        }
+    }
+    // none of the buffered writes can go until reads are served
+    void Stop() { left_ = 0; }
+    // every READ/WRITE put on the bus, to count turnarounds
+    void ColumnIssued(bool is_write);
+    void ReadDone(uint64_t latency) {
+        epoch_read_latency_ += latency;
+        epoch_reads_++;
+    }
+    void EpochUpdate();
+    // saves or restores the state, see Checkpoint
+    void Serialize(Checkpoint& cp);
+
+   private:
+    const Config& config_;
+    SimpleStats& simple_stats_;
+    int high_watermark_;
+    int low_watermark_;
+    // writes left in the current episode
+    int left_;
+
+    // cycles the data bus sits idle on each kind of turnaround
+    int rd_to_wr_penalty_;
+    int wr_to_rd_penalty_;
+    // 0 before the first column command, then 1 for read and 2 for write
+    int last_column_;
+
+    uint64_t epoch_turnaround_cycles_;
+    uint64_t epoch_read_latency_;
+    uint64_t epoch_reads_;
+    double last_avg_read_latency_;
+};
+
+}  // namespace dramsim3
+
+#endif
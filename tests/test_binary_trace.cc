@@ -0,0 +1,143 @@
+#include "catch.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "binary_trace.h"
+#include "trace_prefetcher.h"
+
+TEST_CASE("Binary trace round trip", "[dramsim3]") {
+    std::vector<dramsim3::Transaction> written;
+    uint64_t hex_addr = 1;
+    for (uint64_t i = 0; i < 1000; i++) {
+        hex_addr = hex_addr * 6364136223846793005ull + 1;
+        uint64_t src_addr = (hex_addr >> 16) & ((1ull << 34) - 64);
+        dramsim3::Transaction trans;
+        if (i % 7 == 0) {
+            trans = dramsim3::Transaction(
+                dramsim3::AddressPair(src_addr, src_addr ^ (1 << 20)), false);
+        } else {
+            trans = dramsim3::Transaction(src_addr, i % 3 == 0);
+        }
+        // a few at the same cycle, so some of them straddle index entries
+        trans.added_cycle = i / 3 * 10;
+        written.push_back(trans);
+    }
+    {
+        dramsim3::BinaryTraceWriter writer("test_trace.bin", 16);
+        for (const auto& trans : written) {
+            writer.Add(trans);
+        }
+    }
+    REQUIRE(dramsim3::BinaryTraceReader::IsBinaryTrace("test_trace.bin"));
+    REQUIRE_FALSE(
+        dramsim3::BinaryTraceReader::IsBinaryTrace("tests/example.trace"));
+
+    SECTION("Reads back what was written") {
+        dramsim3::BinaryTraceReader reader("test_trace.bin");
+        REQUIRE(reader.NumRecords() == written.size());
+        dramsim3::Transaction trans;
+        for (const auto& expected : written) {
+            REQUIRE(reader.Next(trans));
+            REQUIRE(trans.added_cycle == expected.added_cycle);
+            REQUIRE(trans.addr.src_addr == expected.addr.src_addr);
+            REQUIRE(trans.is_write == expected.is_write);
+            REQUIRE(trans.is_copy == expected.is_copy);
+            REQUIRE(trans.addr.is_copy == expected.is_copy);
+            if (expected.is_copy) {
+                REQUIRE(trans.addr.dest_addr == expected.addr.dest_addr);
+            }
+        }
+        REQUIRE_FALSE(reader.Next(trans));
+    }
+
+    SECTION("Seeks to the first record at or after a cycle") {
+        dramsim3::BinaryTraceReader reader("test_trace.bin");
+        dramsim3::Transaction trans;
+        for (uint64_t cycle : {0, 5, 480, 490, 1000, 3320}) {
+            reader.Seek(cycle);
+            size_t first = 0;
+            while (written[first].added_cycle < cycle) {
+                first++;
+            }
+            for (size_t i = first; i < first + 5 && i < written.size(); i++) {
+                REQUIRE(reader.Next(trans));
+                REQUIRE(trans.added_cycle == written[i].added_cycle);
+                REQUIRE(trans.addr.src_addr == written[i].addr.src_addr);
+            }
+        }
+        reader.Seek(1000000);
+        REQUIRE_FALSE(reader.Next(trans));
+    }
+
+    SECTION("Seeks backwards") {
+        dramsim3::BinaryTraceReader reader("test_trace.bin");
+        dramsim3::Transaction trans;
+        // back before the first indexed record too, from the end of the
+        // trace and from the middle of it
+        for (uint64_t cycle : {3320, 490, 5, 1000, 0}) {
+            reader.Seek(1000000);
+            reader.Seek(cycle);
+            size_t first = 0;
+            while (written[first].added_cycle < cycle) {
+                first++;
+            }
+            for (size_t i = first; i < written.size(); i++) {
+                REQUIRE(reader.Next(trans));
+                REQUIRE(trans.added_cycle == written[i].added_cycle);
+                REQUIRE(trans.addr.src_addr == written[i].addr.src_addr);
+            }
+            REQUIRE_FALSE(reader.Next(trans));
+            reader.Seek(cycle);
+            REQUIRE(reader.Next(trans));
+            REQUIRE(trans.added_cycle == written[first].added_cycle);
+        }
+    }
+    std::remove("test_trace.bin");
+}
+
+TEST_CASE("Text trace layouts", "[dramsim3]") {
+    std::istringstream is(
+        "COPY 0X100 0X200 10\nREAD 0x40 20\n0x80 WRITE 30\n");
+    dramsim3::Transaction trans;
+    REQUIRE(is >> trans);
+    REQUIRE(trans.is_copy);
+    REQUIRE(trans.addr.src_addr == 0x100);
+    REQUIRE(trans.addr.dest_addr == 0x200);
+    REQUIRE(trans.added_cycle == 10);
+    // nothing carries over from the copy before
+    REQUIRE(is >> trans);
+    REQUIRE_FALSE(trans.is_copy);
+    REQUIRE_FALSE(trans.addr.is_copy);
+    REQUIRE_FALSE(trans.is_write);
+    REQUIRE(trans.addr.src_addr == 0x40);
+    REQUIRE(trans.added_cycle == 20);
+    REQUIRE(is >> trans);
+    REQUIRE(trans.is_write);
+    REQUIRE(trans.addr.src_addr == 0x80);
+    REQUIRE(trans.added_cycle == 30);
+    REQUIRE_FALSE(is >> trans);
+}
+
+TEST_CASE("Trace prefetcher", "[dramsim3]") {
+    std::vector<dramsim3::Transaction> expected;
+    std::ifstream text_trace("tests/Test.trace");
+    dramsim3::Transaction trans;
+    while (text_trace >> trans) {
+        if (trans.added_cycle >= 1000000) {
+            expected.push_back(trans);
+        }
+    }
+    REQUIRE(expected.size() > 1000);
+
+    dramsim3::TracePrefetcher prefetcher("tests/Test.trace", 1000000);
+    for (const auto& exp : expected) {
+        REQUIRE(prefetcher.Next(trans));
+        REQUIRE(trans.added_cycle == exp.added_cycle);
+        REQUIRE(trans.addr.src_addr == exp.addr.src_addr);
+        REQUIRE(trans.addr.dest_addr == exp.addr.dest_addr);
+        REQUIRE(trans.addr.is_copy == exp.is_copy);
+        REQUIRE(trans.is_write == exp.is_write);
+    }
+    REQUIRE_FALSE(prefetcher.Next(trans));
+}
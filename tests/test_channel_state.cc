@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "channel_state.h"
+
+TEST_CASE("Timing table max update", "[channel_state]") {
+    // same as the one in channel_state.cc
+    const int64_t no_timing = std::numeric_limits<int64_t>::min() / 2;
+    const int num_rows = 37;
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<int64_t> cycles(0, 1 << 20);
+    std::uniform_int_distribution<int64_t> delays(0, 64);
+
+    for (uint64_t clk : {0ull, 1000ull, 1ull << 19, 1ull << 40}) {
+        std::vector<int64_t> delay_row(dramsim3::kTimingStride);
+        for (auto& delay : delay_row) {
+            // about a third of the commands unconstrained
+            delay = rng() % 3 == 0 ? no_timing : delays(rng);
+        }
+        std::vector<int64_t> rows(num_rows * dramsim3::kTimingStride);
+        for (auto& time : rows) {
+            time = cycles(rng);
+        }
+        std::vector<int64_t> expected = rows;
+        for (int i = 0; i < num_rows; i++) {
+            for (int j = 0; j < dramsim3::kTimingStride; j++) {
+                int64_t& time = expected[i * dramsim3::kTimingStride + j];
+                if (delay_row[j] != no_timing) {
+                    time = std::max(time, static_cast<int64_t>(clk) +
+                                              delay_row[j]);
+                }
+            }
+        }
+
+        std::vector<int64_t> scalar = rows;
+        dramsim3::MaxTimingRowsScalar(&scalar[0], num_rows, &delay_row[0],
+                                      clk);
+        REQUIRE(scalar == expected);
+        // the AVX2 version if built with it, or the scalar one again
+        std::vector<int64_t> vectorized = rows;
+        dramsim3::MaxTimingRows(&vectorized[0], num_rows, &delay_row[0], clk);
+        REQUIRE(vectorized == scalar);
+
+        // rows outside the range are left alone
+        std::vector<int64_t> partial = rows;
+        dramsim3::MaxTimingRows(&partial[dramsim3::kTimingStride], 1,
+                                &delay_row[0], clk);
+        REQUIRE(std::equal(partial.begin(),
+                           partial.begin() + dramsim3::kTimingStride,
+                           rows.begin()));
+        REQUIRE(std::equal(partial.begin() + dramsim3::kTimingStride,
+                           partial.begin() + 2 * dramsim3::kTimingStride,
+                           expected.begin() + dramsim3::kTimingStride));
+        REQUIRE(std::equal(partial.begin() + 2 * dramsim3::kTimingStride,
+                           partial.end(),
+                           rows.begin() + 2 * dramsim3::kTimingStride));
+    }
+}
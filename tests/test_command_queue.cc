@@ -0,0 +1,54 @@
+#include "catch.hpp"
+#include "channel_state.h"
+#include "command_queue.h"
+#include "configuration.h"
+#include "simple_stats.h"
+#include "timing.h"
+
+TEST_CASE("Command queue wakeups", "[command_queue]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    REQUIRE(config.queue_structure == "PER_BANK");
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::CommandQueue cmd_queue(0, config, channel_state, stats);
+    // issues a command the way the controller does
+    auto issue = [&](const dramsim3::Command& cmd, uint64_t clk) {
+        channel_state.UpdateTimingAndStates(cmd, clk);
+        cmd_queue.UpdateReadyQueues(cmd);
+    };
+
+    dramsim3::Address addr(0, 0, 0, 0, 5, 0);
+    REQUIRE(cmd_queue.AddCommand(
+        dramsim3::Command(dramsim3::CommandType::READ, addr, 0x40)));
+    REQUIRE(cmd_queue.IsQueueReady(0, 0, 0));
+    // another bank, empty and never looked at
+    REQUIRE_FALSE(cmd_queue.IsQueueReady(0, 0, 1));
+
+    uint64_t clk = 0;
+    auto cmd = cmd_queue.GetCommandToIssue();
+    REQUIRE(cmd.cmd_type == dramsim3::CommandType::ACTIVATE);
+    issue(cmd, clk);
+    // the read is tRCD away, so the queue is skipped until then
+    cmd_queue.ClockTick();
+    clk++;
+    REQUIRE_FALSE(cmd_queue.GetCommandToIssue().IsValid());
+    REQUIRE_FALSE(cmd_queue.IsQueueReady(0, 0, 0));
+    REQUIRE(cmd_queue.EarliestReadyCycle() ==
+            static_cast<uint64_t>(config.tRCD));
+    while (clk + 1 < static_cast<uint64_t>(config.tRCD)) {
+        cmd_queue.ClockTick();
+        clk++;
+        REQUIRE_FALSE(cmd_queue.IsQueueReady(0, 0, 0));
+        REQUIRE_FALSE(cmd_queue.GetCommandToIssue().IsValid());
+    }
+    // and woken up right when the read can go
+    cmd_queue.ClockTick();
+    clk++;
+    REQUIRE(cmd_queue.IsQueueReady(0, 0, 0));
+    cmd = cmd_queue.GetCommandToIssue();
+    REQUIRE(cmd.cmd_type == dramsim3::CommandType::READ);
+    REQUIRE(cmd.Row() == 5);
+    issue(cmd, clk);
+    REQUIRE(cmd_queue.QueueEmpty());
+}
@@ -1,6 +1,20 @@
 #define CATCH_CONFIG_MAIN
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
 #include "catch.hpp"
 #include "configuration.h"
+#include "mapping_stats.h"
+
+namespace {
+bool SameAddress(const dramsim3::Address& a, const dramsim3::Address& b) {
+    return a.channel == b.channel && a.rank == b.rank &&
+           a.bankgroup == b.bankgroup && a.bank == b.bank && a.row == b.row &&
+           a.column == b.column;
+}
+}  // namespace
 
 TEST_CASE("Address Mapping", "[config]") {
     dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
@@ -93,3 +107,164 @@ TEST_CASE("Address Mapping", "[config]") {
     }
 }
 
+
+TEST_CASE("Bit field address mapping", "[config]") {
+    // DDR4_8Gb_x8_3200 with the bankgroup moved under the column and the
+    // bank hashed with the low row bits
+    std::ifstream base("configs/DDR4_8Gb_x8_3200.ini");
+    std::stringstream ini;
+    ini << base.rdbuf();
+    std::string content = ini.str();
+    content.replace(content.find("[system]\n"), 9,
+                    "[system]\n"
+                    "address_bits_bg = 6 7\n"
+                    "address_bits_co = 8-14\n"
+                    "address_xor_ba = 18 19\n");
+    std::ofstream("test_bit_field.ini") << content;
+    dramsim3::Config config("test_bit_field.ini", ".");
+    std::remove("test_bit_field.ini");
+
+    REQUIRE(config.HasBitFieldMapping());
+    REQUIRE(config.FieldAddressBits(dramsim3::AddressField::BANK) ==
+            ((0b11ull << 15) | (0b11ull << 18)));
+
+    auto addr = config.AddressMapping((1ull << 6) | (1ull << 15));
+    REQUIRE(addr.bankgroup == 1);
+    REQUIRE(addr.bank == 1);
+    REQUIRE(addr.column == 0);
+    REQUIRE(addr.row == 0);
+
+    addr = config.AddressMapping((1ull << 8) | (1ull << 15) | (1ull << 18));
+    REQUIRE(addr.column == 1);
+    REQUIRE(addr.bank == 0);
+    REQUIRE(addr.row == 1);
+
+    addr = config.AddressMapping((1ull << 17) | (1ull << 19) | (1ull << 33));
+    REQUIRE(addr.rank == 1);
+    REQUIRE(addr.bank == 2);
+    REQUIRE(addr.row == 0b1000000000000010);
+
+    std::vector<uint64_t> hex_addrs;
+    uint64_t hex_addr = 0x12345;
+    for (int i = 0; i < 1000; i++) {
+        hex_addr = hex_addr * 6364136223846793005ull + 1442695040888963407ull;
+        hex_addrs.push_back(hex_addr >> 30);
+    }
+    std::vector<dramsim3::Address> addrs(hex_addrs.size());
+    config.AddressMapping(hex_addrs.data(), hex_addrs.size(), addrs.data());
+    for (size_t i = 0; i < hex_addrs.size(); i++) {
+        auto single = config.AddressMapping(hex_addrs[i]);
+        REQUIRE(addrs[i].bank == single.bank);
+        REQUIRE(addrs[i].row == single.row);
+        REQUIRE(addrs[i].column == single.column);
+        uint64_t row_bits = hex_addrs[i] >> 18;
+        REQUIRE(single.bank == static_cast<int>(((hex_addrs[i] >> 15) ^
+                                                 row_bits) & 0b11));
+    }
+}
+
+TEST_CASE("Restated default address bits", "[config]") {
+    // the bits address_mapping gives every field, written out as
+    // address_bits_ keys, have to decode like address_mapping itself
+    for (std::string ini : {"configs/DDR4_8Gb_x8_2400.ini",
+                            "configs/DDR4_8Gb_x8_3200.ini",
+                            "configs/HBM2_8Gb_x128.ini"}) {
+        dramsim3::Config plain(ini, ".");
+        REQUIRE_FALSE(plain.HasBitFieldMapping());
+        std::map<std::string, std::string> overrides;
+        const char* tokens[] = {"ch", "ra", "bg", "ba", "ro", "co"};
+        for (int i = 0; i < 6; i++) {
+            uint64_t bits =
+                plain.FieldAddressBits(static_cast<dramsim3::AddressField>(i));
+            std::string bits_str;
+            for (int b = 0; b < 64; b++) {
+                if (bits & (1ull << b)) {
+                    bits_str += std::to_string(b) + " ";
+                }
+            }
+            if (!bits_str.empty()) {
+                overrides[std::string("address_bits_") + tokens[i]] = bits_str;
+            }
+        }
+        dramsim3::Config restated(ini, ".", overrides);
+        REQUIRE(restated.HasBitFieldMapping());
+
+        uint64_t hex_addr = 0x12345;
+        for (int i = 0; i < 10000; i++) {
+            hex_addr = hex_addr * 6364136223846793005ull +
+                       1442695040888963407ull;
+            // low addresses bit by bit, then anything up to 2^40
+            uint64_t addr = i < 4096 ? static_cast<uint64_t>(i) << 3
+                                     : hex_addr >> 24;
+            dramsim3::Transaction read(addr, false);
+            dramsim3::Transaction copy(dramsim3::AddressPair(addr, ~addr >> 24),
+                                       false);
+            for (auto trans : {read, copy}) {
+                auto expected = trans;
+                plain.DecodeAddresses(expected);
+                restated.DecodeAddresses(trans);
+                REQUIRE(SameAddress(expected.src_address, trans.src_address));
+                REQUIRE(
+                    SameAddress(expected.dest_address, trans.dest_address));
+            }
+        }
+    }
+}
+
+TEST_CASE("Mapping stats", "[config]") {
+    // the default DDR4_8Gb_x8_3200 layout, through the bit field decode:
+    // bank at bits 15-16, rank at 17 and row from 18
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".",
+                            {{"address_bits_ro", "18-33"}});
+    dramsim3::MappingStats stats(config, 2);
+    stats.Add(dramsim3::Transaction(0x0, false));
+    stats.Add(dramsim3::Transaction(0x40, true));
+    stats.Add(dramsim3::Transaction(1ull << 15, false));
+    // conflicts 2 accesses after the last access to bank 0
+    stats.Add(dramsim3::Transaction(1ull << 18, false));
+    // and a copy within bank 0, conflicting twice right away
+    stats.Add(dramsim3::Transaction(
+        dramsim3::AddressPair(2ull << 18, 3ull << 18), false));
+
+    REQUIRE(stats.Accesses() == 6);
+    REQUIRE(stats.RowHitRate() == Approx(1.0 / 6));
+    REQUIRE(stats.ChannelImbalance() == Approx(1.0));
+    REQUIRE(stats.BankImbalance() == Approx(5.0 * 32 / 6));
+    REQUIRE(stats.MeanConflictDistance() == Approx(4.0 / 3));
+    REQUIRE(stats.CloseConflictRate() == Approx(0.5));
+    REQUIRE(stats.CopyInBankRate() == Approx(1.0));
+}
+
+TEST_CASE("Mapping stats of equal candidates", "[config]") {
+    // a candidate restating the default bank bits is the same mapping, and
+    // has to be decoded the same way as the plain one
+    dramsim3::Config plain("configs/DDR4_8Gb_x8_2400.ini", ".");
+    uint64_t bank_bits = plain.FieldAddressBits(dramsim3::AddressField::BANK);
+    std::string bits_str;
+    for (int b = 0; b < 64; b++) {
+        if (bank_bits & (1ull << b)) {
+            bits_str += std::to_string(b) + " ";
+        }
+    }
+    dramsim3::Config restated("configs/DDR4_8Gb_x8_2400.ini", ".",
+                              {{"address_bits_ba", bits_str}});
+    REQUIRE(restated.HasBitFieldMapping());
+
+    dramsim3::MappingStats plain_stats(plain, 16);
+    dramsim3::MappingStats restated_stats(restated, 16);
+    uint64_t hex_addr = 0x12345;
+    for (int i = 0; i < 10000; i++) {
+        hex_addr = hex_addr * 6364136223846793005ull + 1442695040888963407ull;
+        // sequential lines, every 64th access somewhere else
+        uint64_t addr = (i % 64 == 0 ? hex_addr >> 30 : 0) + i * 64;
+        plain_stats.Add(dramsim3::Transaction(addr, i % 3 == 0));
+        restated_stats.Add(dramsim3::Transaction(addr, i % 3 == 0));
+    }
+    REQUIRE(plain_stats.RowHitRate() > 0.5);
+    REQUIRE(plain_stats.RowHitRate() == restated_stats.RowHitRate());
+    REQUIRE(plain_stats.BankImbalance() == restated_stats.BankImbalance());
+    REQUIRE(plain_stats.MeanConflictDistance() ==
+            restated_stats.MeanConflictDistance());
+    REQUIRE(plain_stats.CloseConflictRate() ==
+            restated_stats.CloseConflictRate());
+}
@@ -0,0 +1,127 @@
+#include "catch.hpp"
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "cpu.h"
+
+namespace {
+// A trace of num transactions at cycle 0, every write_every-th one a write,
+// in a file of its own that is removed again however the test ends
+class TempTrace {
+   public:
+    TempTrace(int num, int write_every, uint64_t hex_addr) {
+        char file_name[] = "test_cpu_XXXXXX";
+        int fd = mkstemp(file_name);
+        REQUIRE(fd >= 0);
+        close(fd);
+        file_name_ = file_name;
+        std::ofstream trace(file_name_);
+        for (int i = 0; i < num; i++) {
+            hex_addr = hex_addr * 6364136223846793005ull + 1;
+            bool is_write = write_every > 0 && i % write_every == 0;
+            trace << "0x" << std::hex
+                  << ((hex_addr >> 16) & ((1ull << 30) - 64)) << std::dec
+                  << (is_write ? " WRITE " : " READ ") << 0 << std::endl;
+        }
+    }
+    ~TempTrace() { std::remove(file_name_.c_str()); }
+    TempTrace(const TempTrace&) = delete;
+    TempTrace& operator=(const TempTrace&) = delete;
+    const std::string& FileName() const { return file_name_; }
+
+   private:
+    std::string file_name_;
+};
+
+struct Occupancy {
+    int max_in_flight = 0;
+    size_t max_rob_entries = 0;
+};
+
+// runs the cores until the memory system is long done
+std::vector<Occupancy> Run(dramsim3::MultiCoreCPU& cpu, int num_cores) {
+    std::vector<Occupancy> occupancy(num_cores);
+    for (int clk = 0; clk < 20000; clk++) {
+        cpu.ClockTick();
+        for (int i = 0; i < num_cores; i++) {
+            occupancy[i].max_in_flight =
+                std::max(occupancy[i].max_in_flight, cpu.InFlight(i));
+            occupancy[i].max_rob_entries =
+                std::max(occupancy[i].max_rob_entries, cpu.RobEntries(i));
+        }
+    }
+    return occupancy;
+}
+}  // namespace
+
+TEST_CASE("Multi-core CPU MSHRs", "[cpu]") {
+    TempTrace trace(32, 0, 1);
+    dramsim3::MultiCoreCPU cpu("configs/DDR4_8Gb_x8_3200.ini", ".",
+                               {trace.FileName()}, 4, 0, true);
+    auto occupancy = Run(cpu, 1);
+    // the reads all want to go at once, and only as many as there are
+    // MSHRs do
+    REQUIRE(occupancy[0].max_in_flight == 4);
+    REQUIRE(cpu.StallCycles(0) > 0);
+    REQUIRE(cpu.Done(0) == 32);
+    REQUIRE(cpu.InFlight(0) == 0);
+}
+
+TEST_CASE("Multi-core CPU reorder buffer", "[cpu]") {
+    SECTION("Holds back a core with a full window") {
+        // 16 MSHRs, but only 4 reads fit in the window
+        TempTrace trace(32, 0, 1);
+        dramsim3::MultiCoreCPU cpu("configs/DDR4_8Gb_x8_3200.ini", ".",
+                                   {trace.FileName()}, 16, 4, true);
+        auto occupancy = Run(cpu, 1);
+        REQUIRE(occupancy[0].max_rob_entries == 4);
+        REQUIRE(occupancy[0].max_in_flight == 4);
+        REQUIRE(cpu.StallCycles(0) > 0);
+        REQUIRE(cpu.Done(0) == 32);
+        REQUIRE(cpu.RobEntries(0) == 0);
+    }
+
+    SECTION("Keeps retired writes in the window") {
+        // W R R W R R ..., a window of 4 from the oldest read holds a write
+        TempTrace trace(32, 3, 1);
+        dramsim3::MultiCoreCPU cpu("configs/DDR4_8Gb_x8_3200.ini", ".",
+                                   {trace.FileName()}, 16, 4, true);
+        auto occupancy = Run(cpu, 1);
+        REQUIRE(occupancy[0].max_rob_entries == 4);
+        REQUIRE(occupancy[0].max_in_flight == 3);
+        REQUIRE(cpu.Done(0) == 32);
+        REQUIRE(cpu.RobEntries(0) == 0);
+    }
+
+    SECTION("Retires writes as they are issued") {
+        TempTrace trace(32, 1, 1);
+        dramsim3::MultiCoreCPU cpu("configs/DDR4_8Gb_x8_3200.ini", ".",
+                                   {trace.FileName()}, 16, 4, true);
+        auto occupancy = Run(cpu, 1);
+        REQUIRE(occupancy[0].max_rob_entries == 0);
+        REQUIRE(cpu.Done(0) == 32);
+    }
+}
+
+TEST_CASE("Multi-core CPU completions", "[cpu]") {
+    // requests of each core come back to it, also to the same addresses
+    TempTrace trace0(40, 4, 1);
+    TempTrace trace1(30, 5, 1);
+    TempTrace trace2(20, 0, 7);
+    dramsim3::MultiCoreCPU cpu(
+        "configs/DDR4_8Gb_x8_3200.ini", ".",
+        {trace0.FileName(), trace1.FileName(), trace2.FileName()}, 2, 8,
+        false);
+    auto occupancy = Run(cpu, 3);
+    REQUIRE(cpu.Done(0) == 40);
+    REQUIRE(cpu.Done(1) == 30);
+    REQUIRE(cpu.Done(2) == 20);
+    for (int i = 0; i < 3; i++) {
+        REQUIRE(occupancy[i].max_in_flight == 2);
+        REQUIRE(cpu.InFlight(i) == 0);
+    }
+}
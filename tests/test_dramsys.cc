@@ -1,6 +1,11 @@
 #include "catch.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "checkpoint.h"
 #include "configuration.h"
 #include "dram_system.h"
+#include "refresh.h"
 
 bool call_back_called = false;
 void dummy_call_back(uint64_t addr) {
@@ -30,3 +35,380 @@ TEST_CASE("Jedec DRAMSystem Testing", "[dramsim3]") {
         REQUIRE(clk == tRC);
     }
 }
+
+std::vector<uint64_t> skip_ahead_done_clks;
+uint64_t skip_ahead_clk = 0;
+void skip_ahead_call_back(uint64_t addr) {
+    skip_ahead_done_clks.push_back(skip_ahead_clk);
+    return;
+}
+
+std::vector<uint64_t> RunSkipAheadTest(
+    bool skip_ahead, const std::string& refresh_scheduling = "STRICT") {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    config.enable_skip_ahead = skip_ahead;
+    config.refresh_scheduling = refresh_scheduling;
+    // with ELASTIC, refreshes are pulled in just before the next request
+    config.refresh_pull_in_idle = 970;
+    dramsim3::JedecDRAMSystem dramsys(config, ".", skip_ahead_call_back,
+                                      skip_ahead_call_back);
+    skip_ahead_done_clks.clear();
+    for (skip_ahead_clk = 0; skip_ahead_clk < 20000; skip_ahead_clk++) {
+        // sparse requests with some row hits and bank conflicts, across
+        // at least one refresh interval
+        if (skip_ahead_clk % 1000 == 0) {
+            uint64_t hex_addr = (skip_ahead_clk / 1000) % 3 << 20;
+            bool is_write = (skip_ahead_clk / 1000) % 4 == 3;
+            dramsys.AddTransaction(hex_addr, is_write);
+        }
+        dramsys.ClockTick();
+    }
+    return skip_ahead_done_clks;
+}
+
+TEST_CASE("Skip-ahead clocking", "[dramsim3]") {
+    auto per_cycle = RunSkipAheadTest(false);
+    auto skip_ahead = RunSkipAheadTest(true);
+    REQUIRE(per_cycle.size() == 20);
+    REQUIRE(skip_ahead == per_cycle);
+}
+
+TEST_CASE("Elastic refresh", "[dramsim3]") {
+    // refreshes are pulled into the gaps between the requests, and skipping
+    // ahead has to stop for them
+    auto per_cycle = RunSkipAheadTest(false, "ELASTIC");
+    REQUIRE(per_cycle.size() == 20);
+    REQUIRE(RunSkipAheadTest(true, "ELASTIC") == per_cycle);
+}
+
+TEST_CASE("Elastic refresh counters", "[dramsim3]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.refresh_scheduling = "ELASTIC";
+    config.refresh_max_postpone = 2;
+    config.refresh_max_pull_in = 3;
+    config.refresh_pull_in_idle = 100;
+    REQUIRE(config.refresh_policy ==
+            dramsim3::RefreshPolicy::RANK_LEVEL_STAGGERED);
+    REQUIRE(config.ranks > 1);
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::CommandQueue cmd_queue(0, config, channel_state, stats);
+    dramsim3::Refresh refresh(config, channel_state, cmd_queue, stats);
+
+    // a read that never issues keeps rank 0 busy, the others stay idle
+    dramsim3::Address addr(0, 0, 0, 0, 0, 0);
+    REQUIRE(cmd_queue.AddCommand(
+        dramsim3::Command(dramsim3::CommandType::READ, addr, 0)));
+    // up to and including the third refresh due to rank 0
+    uint64_t interval = config.tREFI / config.ranks;
+    uint64_t cycles = interval + 2 * config.tREFI + 1;
+    std::vector<int> refreshes(config.ranks, 0);
+    for (uint64_t clk = 0; clk < cycles; clk++) {
+        refresh.ClockTick();
+        // refreshes issue right away
+        while (channel_state.IsRefreshWaiting()) {
+            int rank = channel_state.PendingRefCommand().Rank();
+            refreshes[rank]++;
+            channel_state.RankNeedRefresh(rank, false);
+        }
+    }
+    // two are postponed, the third goes past the limit and is forced
+    REQUIRE(stats.Count(dramsim3::CounterStat::NUM_REFS_POSTPONED) == 2);
+    REQUIRE(stats.Count(dramsim3::CounterStat::NUM_REFS_FORCED) == 1);
+    REQUIRE(refreshes[0] == 1);
+    // the idle ranks pull in as many as they may and then one per due
+    uint64_t pulled_in = 0;
+    for (int rank = 1; rank < config.ranks; rank++) {
+        // refreshes are due to the ranks in turn from the first interval on
+        int due = 0;
+        for (uint64_t clk = interval * (rank + 1); clk < cycles;
+             clk += config.tREFI) {
+            due++;
+        }
+        REQUIRE(refreshes[rank] == config.refresh_max_pull_in + due);
+        pulled_in += refreshes[rank];
+    }
+    REQUIRE(stats.Count(dramsim3::CounterStat::NUM_REFS_PULLED_IN) ==
+            pulled_in);
+}
+
+std::vector<uint64_t> threaded_done_addrs;
+void threaded_call_back(uint64_t addr) {
+    threaded_done_addrs.push_back(addr);
+    return;
+}
+
+std::vector<uint64_t> RunChannelThreadsTest(int channel_threads) {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    config.channel_threads = channel_threads;
+    config.sync_quantum = 100;
+    dramsim3::JedecDRAMSystem dramsys(config, ".", threaded_call_back,
+                                      threaded_call_back);
+    threaded_done_addrs.clear();
+    uint64_t hex_addr = 1;
+    for (int clk = 0; clk < 20000; clk++) {
+        // enough traffic to fill up the queues now and then
+        bool is_write = hex_addr % 5 == 0;
+        if (dramsys.WillAcceptTransaction(hex_addr, is_write)) {
+            dramsys.AddTransaction(hex_addr, is_write);
+            hex_addr = hex_addr * 6364136223846793005ull + 1;
+            hex_addr = (hex_addr >> 16) & ((1ull << 30) - 64);
+        }
+        dramsys.ClockTick();
+    }
+    // the last cycle is a sync, so both have returned the same by now
+    return threaded_done_addrs;
+}
+
+TEST_CASE("Channel threads", "[dramsim3]") {
+    auto serial = RunChannelThreadsTest(1);
+    auto threaded = RunChannelThreadsTest(4);
+    REQUIRE(serial.size() > 500);
+    REQUIRE(threaded == serial);
+}
+
+uint64_t closed_loop_clk = 0;
+std::vector<std::pair<uint64_t, uint64_t>> closed_loop_done;
+void closed_loop_call_back(uint64_t addr) {
+    closed_loop_done.emplace_back(closed_loop_clk, addr);
+    return;
+}
+
+std::vector<std::pair<uint64_t, uint64_t>> RunClosedLoopTest(
+    int channel_threads, bool closed_loop) {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    config.channel_threads = channel_threads;
+    config.sync_quantum = 100;
+    dramsim3::JedecDRAMSystem dramsys(config, ".", closed_loop_call_back,
+                                      closed_loop_call_back);
+    if (closed_loop) {
+        dramsys.SetClosedLoop();
+    }
+    closed_loop_done.clear();
+    // a new read for every one that came back, with up to 16 outstanding
+    uint64_t hex_addr = 1;
+    size_t sent = 0;
+    for (closed_loop_clk = 0; closed_loop_clk < 20000; closed_loop_clk++) {
+        while (sent < closed_loop_done.size() + 16 &&
+               dramsys.WillAcceptTransaction(hex_addr, false)) {
+            dramsys.AddTransaction(hex_addr, false);
+            sent++;
+            hex_addr = hex_addr * 6364136223846793005ull + 1;
+            hex_addr = (hex_addr >> 16) & ((1ull << 30) - 64);
+        }
+        dramsys.ClockTick();
+    }
+    return closed_loop_done;
+}
+
+TEST_CASE("Channel threads in a closed loop", "[dramsim3]") {
+    auto serial = RunClosedLoopTest(1, true);
+    REQUIRE(serial.size() > 500);
+    // completions made late hold the next requests back
+    REQUIRE(RunClosedLoopTest(4, false) != serial);
+    REQUIRE(RunClosedLoopTest(4, true) == serial);
+}
+
+std::vector<uint64_t> RunTimingEngineTest(const std::string& timing_engine) {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.timing_engine = timing_engine;
+    dramsim3::JedecDRAMSystem dramsys(config, ".", threaded_call_back,
+                                      threaded_call_back);
+    threaded_done_addrs.clear();
+    uint64_t hex_addr = 1;
+    for (int clk = 0; clk < 20000; clk++) {
+        bool is_write = hex_addr % 5 == 0;
+        if (dramsys.WillAcceptTransaction(hex_addr, is_write)) {
+            dramsys.AddTransaction(hex_addr, is_write);
+            hex_addr = hex_addr * 6364136223846793005ull + 1;
+            hex_addr = (hex_addr >> 16) & ((1ull << 33) - 64);
+        }
+        dramsys.ClockTick();
+    }
+    return threaded_done_addrs;
+}
+
+TEST_CASE("Lazy timing engine", "[dramsim3]") {
+    auto eager = RunTimingEngineTest("EAGER");
+    REQUIRE(eager.size() > 200);
+    REQUIRE(RunTimingEngineTest("LAZY") == eager);
+    // stops the test run at the first disagreement
+    REQUIRE(RunTimingEngineTest("VALIDATE") == eager);
+}
+
+TEST_CASE("Batched requests and polled completions", "[dramsim3]") {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    dramsim3::JedecDRAMSystem dramsys(config, ".", nullptr, nullptr);
+
+    // more reads than the read queues of all channels can hold
+    std::vector<dramsim3::Request> requests;
+    uint64_t hex_addr = 1;
+    for (uint64_t i = 0; i < 400; i++) {
+        hex_addr = hex_addr * 6364136223846793005ull + 1;
+        requests.push_back({i, (hex_addr >> 16) & ((1ull << 30) - 64),
+                            false, 0});
+    }
+    auto accepted = dramsys.AddRequests(requests.data(), requests.size());
+    REQUIRE(accepted.size() == static_cast<size_t>(config.channels));
+
+    // each channel takes the requests to it in order until it's full
+    std::vector<uint64_t> expected;
+    std::vector<int> seen(config.channels, 0);
+    int total = 0;
+    for (const auto& req : requests) {
+        int channel = dramsys.GetChannel(req.hex_addr);
+        if (seen[channel]++ < accepted[channel]) {
+            expected.push_back(req.req_id);
+        }
+    }
+    for (int channel = 0; channel < config.channels; channel++) {
+        REQUIRE(accepted[channel] <= config.trans_queue_size);
+        total += accepted[channel];
+    }
+    REQUIRE(total == static_cast<int>(expected.size()));
+    REQUIRE(total < 400);
+
+    std::vector<uint64_t> done;
+    dramsim3::Completion completions[16];
+    for (int clk = 0; clk < 20000; clk++) {
+        dramsys.ClockTick();
+        size_t num = dramsys.PollCompletions(completions, 16);
+        for (size_t i = 0; i < num; i++) {
+            REQUIRE_FALSE(completions[i].is_write);
+            done.push_back(completions[i].req_id);
+        }
+    }
+    std::sort(done.begin(), done.end());
+    REQUIRE(done == expected);
+}
+
+TEST_CASE("Copy of a buffered write", "[dramsim3]") {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    dramsim3::JedecDRAMSystem dramsys(config, ".", nullptr, nullptr);
+
+    // the copy turns into a write of the buffered data to its destination,
+    // which has to be written back and still completes under the copy's id
+    uint64_t src = 0x10000;
+    uint64_t dest = src ^ (1 << 20);
+    REQUIRE(dramsys.AddRequest(1, src, true));
+    REQUIRE(dramsys.AddRequest(2, dramsim3::AddressPair(src, dest), false));
+    std::vector<std::pair<uint64_t, bool>> done;
+    dramsim3::Completion completions[16];
+    for (int clk = 0; clk < 20000; clk++) {
+        dramsys.ClockTick();
+        size_t num = dramsys.PollCompletions(completions, 16);
+        for (size_t i = 0; i < num; i++) {
+            done.emplace_back(completions[i].req_id, completions[i].is_write);
+        }
+    }
+    std::vector<std::pair<uint64_t, bool>> expected = {{1, true}, {2, false}};
+    REQUIRE(done == expected);
+    REQUIRE(dramsys.WillAcceptTransaction(dest, true));
+}
+
+// a cycle of traffic for the checkpoint test, with completions polled
+void CheckpointTestCycle(dramsim3::JedecDRAMSystem& dramsys,
+                         uint64_t& hex_addr, std::vector<uint64_t>& done) {
+    bool is_write = hex_addr % 5 == 0;
+    if (dramsys.WillAcceptTransaction(hex_addr, is_write)) {
+        dramsys.AddTransaction(hex_addr, is_write);
+        hex_addr = hex_addr * 6364136223846793005ull + 1;
+        hex_addr = (hex_addr >> 16) & ((1ull << 30) - 64);
+    }
+    dramsys.ClockTick();
+    dramsim3::Completion completions[16];
+    size_t num = dramsys.PollCompletions(completions, 16);
+    for (size_t i = 0; i < num; i++) {
+        done.push_back(completions[i].req_id);
+    }
+}
+
+TEST_CASE("Checkpoint and restore", "[dramsim3]") {
+    dramsim3::Config config("configs/HBM1_4Gb_x128.ini", ".");
+    config.scheduler = "PARBS";
+    dramsim3::JedecDRAMSystem dramsys(config, ".", nullptr, nullptr);
+    uint64_t hex_addr = 1;
+    std::vector<uint64_t> warmup_done;
+    for (int clk = 0; clk < 10000; clk++) {
+        CheckpointTestCycle(dramsys, hex_addr, warmup_done);
+    }
+    {
+        dramsim3::Checkpoint cp("test_checkpoint.bin", true);
+        dramsys.Serialize(cp);
+    }
+
+    // the rest of the run, uninterrupted and off the checkpoint
+    uint64_t restored_addr = hex_addr;
+    std::vector<uint64_t> done;
+    for (int clk = 0; clk < 10000; clk++) {
+        CheckpointTestCycle(dramsys, hex_addr, done);
+    }
+    dramsim3::JedecDRAMSystem restored(config, ".", nullptr, nullptr);
+    {
+        dramsim3::Checkpoint cp("test_checkpoint.bin", false);
+        restored.Serialize(cp);
+    }
+    std::vector<uint64_t> restored_done;
+    for (int clk = 0; clk < 10000; clk++) {
+        CheckpointTestCycle(restored, restored_addr, restored_done);
+    }
+    std::remove("test_checkpoint.bin");
+    REQUIRE(done.size() > 300);
+    REQUIRE(restored_done == done);
+}
+
+// cycles a read to hex_addr takes after a functional warm-up with warm_addr,
+// and warm_cycles more cycles
+uint64_t WarmUpReadLatency(uint64_t warm_addr, uint64_t warm_cycles,
+                           uint64_t hex_addr,
+                           const std::string& refresh_scheduling = "STRICT") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.refresh_scheduling = refresh_scheduling;
+    dramsim3::JedecDRAMSystem dramsys(config, ".", nullptr, nullptr);
+    dramsys.WarmUp(warm_addr, false);
+    dramsys.WarmUpCycles(warm_cycles);
+    dramsys.EndWarmUp();
+    dramsys.AddTransaction(hex_addr, false);
+    dramsim3::Completion completion;
+    for (uint64_t clk = 1; clk < 1000; clk++) {
+        dramsys.ClockTick();
+        if (dramsys.PollCompletions(&completion, 1) == 1) {
+            return clk;
+        }
+    }
+    return 0;
+}
+
+TEST_CASE("Functional warm-up", "[dramsim3]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    // another row in the same bank
+    uint64_t hex_addr = 0x12345640;
+    dramsim3::Address addr = config.AddressMapping(hex_addr);
+    uint64_t other_addr = hex_addr;
+    dramsim3::Address other;
+    do {
+        other_addr += 64;
+        other = config.AddressMapping(other_addr);
+    } while (other.channel != addr.channel || other.rank != addr.rank ||
+             other.bankgroup != addr.bankgroup || other.bank != addr.bank ||
+             other.row == addr.row);
+
+    uint64_t hit = WarmUpReadLatency(hex_addr, 10, hex_addr);
+    uint64_t miss = WarmUpReadLatency(other_addr, 10, hex_addr);
+    REQUIRE(hit > 0);
+    REQUIRE(hit + config.tRCD <= miss);
+    // a refresh in between closes the row
+    uint64_t refreshed =
+        WarmUpReadLatency(hex_addr, 2 * config.tREFI, hex_addr);
+    REQUIRE(refreshed > hit);
+    REQUIRE(refreshed < miss);
+
+    // with ELASTIC refreshes still only come every tREFI in a warm-up, not
+    // whenever a rank has been idle for long enough
+    REQUIRE(config.tRFC < config.tREFI / 4);
+    REQUIRE(WarmUpReadLatency(hex_addr, config.tREFI / 4, hex_addr,
+                              "ELASTIC") == hit);
+    REQUIRE(WarmUpReadLatency(hex_addr, 2 * config.tREFI, hex_addr,
+                              "ELASTIC") == refreshed);
+}
@@ -0,0 +1,108 @@
+#include "catch.hpp"
+#include <limits>
+#include <utility>
+#include <vector>
+#include "simple_stats.h"
+
+namespace {
+// lowest and highest value of the bucket value goes into
+std::pair<uint64_t, uint64_t> BucketOf(int value) {
+    dramsim3::LogLinearHistogram histo;
+    histo.Record(value);
+    return {histo.Buckets()[0].first, histo.ValueAtPercentile(100)};
+}
+}  // namespace
+
+TEST_CASE("Log-linear histogram buckets", "[histogram]") {
+    SECTION("Exact below 256") {
+        dramsim3::LogLinearHistogram histo;
+        for (int value = 0; value < 256; value++) {
+            histo.Record(value);
+        }
+        auto buckets = histo.Buckets();
+        REQUIRE(buckets.size() == 256);
+        for (int value = 0; value < 256; value++) {
+            REQUIRE(buckets[value].first == static_cast<uint64_t>(value));
+            REQUIRE(buckets[value].second == 1);
+        }
+    }
+
+    SECTION("Bucket boundaries") {
+        REQUIRE(BucketOf(255) == std::make_pair<uint64_t, uint64_t>(255, 255));
+        REQUIRE(BucketOf(256) == std::make_pair<uint64_t, uint64_t>(256, 257));
+        REQUIRE(BucketOf(257) == std::make_pair<uint64_t, uint64_t>(256, 257));
+        REQUIRE(BucketOf(258) == std::make_pair<uint64_t, uint64_t>(258, 259));
+        REQUIRE(BucketOf(511) == std::make_pair<uint64_t, uint64_t>(510, 511));
+        REQUIRE(BucketOf(512) == std::make_pair<uint64_t, uint64_t>(512, 515));
+        REQUIRE(BucketOf(1023) ==
+                std::make_pair<uint64_t, uint64_t>(1020, 1023));
+        REQUIRE(BucketOf(1024) ==
+                std::make_pair<uint64_t, uint64_t>(1024, 1031));
+        // negative values count as 0
+        REQUIRE(BucketOf(-5) == std::make_pair<uint64_t, uint64_t>(0, 0));
+    }
+
+    SECTION("Within 1/128 of the value") {
+        std::vector<int> values = {300, 4097, 65535, 1000000,
+                                   std::numeric_limits<int>::max()};
+        for (int value = 256; value < 100000; value = value * 5 / 4 + 1) {
+            values.push_back(value);
+        }
+        for (int value : values) {
+            auto bucket = BucketOf(value);
+            uint64_t val = static_cast<uint64_t>(value);
+            REQUIRE(bucket.first <= val);
+            REQUIRE(val <= bucket.second);
+            REQUIRE((bucket.second - bucket.first + 1) * 128 <= val);
+        }
+    }
+}
+
+TEST_CASE("Log-linear histogram percentiles", "[histogram]") {
+    dramsim3::LogLinearHistogram histo;
+    REQUIRE(histo.ValueAtPercentile(50) == 0);
+    REQUIRE(histo.Buckets().empty());
+
+    SECTION("Exact values") {
+        for (int value = 100; value >= 1; value--) {
+            histo.Record(value);
+        }
+        REQUIRE(histo.Count() == 100);
+        REQUIRE(histo.Average() == Approx(50.5));
+        REQUIRE(histo.ValueAtPercentile(0) == 1);
+        REQUIRE(histo.ValueAtPercentile(1) == 1);
+        REQUIRE(histo.ValueAtPercentile(50) == 50);
+        REQUIRE(histo.ValueAtPercentile(99) == 99);
+        REQUIRE(histo.ValueAtPercentile(100) == 100);
+    }
+
+    SECTION("Bucketed values") {
+        for (int value = 1000; value < 2000; value++) {
+            histo.Record(value);
+        }
+        // the highest value of the bucket the percentile falls in
+        uint64_t p50 = histo.ValueAtPercentile(50);
+        REQUIRE(p50 >= 1499);
+        REQUIRE(p50 <= 1499 + 1499 / 128);
+        REQUIRE(histo.ValueAtPercentile(100) == 1999);
+        REQUIRE(histo.Average() == Approx(1499.5));
+    }
+
+    SECTION("Merge and clear") {
+        dramsim3::LogLinearHistogram other, all;
+        for (int value = 0; value < 3000; value += 7) {
+            (value % 2 ? histo : other).Record(value);
+            all.Record(value);
+        }
+        histo.Merge(other);
+        REQUIRE(histo.Count() == all.Count());
+        REQUIRE(histo.Buckets() == all.Buckets());
+        for (double p : {10.0, 50.0, 90.0, 99.0}) {
+            REQUIRE(histo.ValueAtPercentile(p) == all.ValueAtPercentile(p));
+        }
+        histo.Clear();
+        REQUIRE(histo.Count() == 0);
+        REQUIRE(histo.Buckets().empty());
+        REQUIRE(histo.ValueAtPercentile(99) == 0);
+    }
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <vector>
 #include "catch.hpp"
 #include "configuration.h"
 #include "memory_system.h"
@@ -39,3 +41,26 @@ TEST_CASE("HMC System Testing", "[dramsim3][hmc]") {
         REQUIRE(clk == idle_lat);
     }
 }
+
+TEST_CASE("HMC request ids", "[dramsim3][hmc]") {
+    dramsim3::MemorySystem hmc("configs/HMC_2GB_4Lx16.ini", ".", hmc_callback,
+                               hmc_callback);
+    std::vector<uint64_t> done_ids;
+    auto req_callback = [&done_ids](uint64_t req_id,
+                                    dramsim3::AddressPair hex_addr) {
+        done_ids.push_back(req_id);
+    };
+    hmc.RegisterRequestCallbacks(req_callback, req_callback);
+    hmc_called = false;
+
+    // two reads to the same address used to be told apart by address only
+    hmc.AddRequest(7, 64, false);
+    hmc.AddRequest(8, 64, false);
+    hmc.AddRequest(9, 128, true);
+    for (int clk = 0; clk < 1000 && done_ids.size() < 3; clk++) {
+        hmc.ClockTick();
+    }
+    std::sort(done_ids.begin(), done_ids.end());
+    REQUIRE(done_ids == std::vector<uint64_t>({7, 8, 9}));
+    REQUIRE_FALSE(hmc_called);
+}
@@ -0,0 +1,121 @@
+#include "catch.hpp"
+#include <deque>
+#include <map>
+#include <vector>
+#include "pending_table.h"
+
+namespace {
+dramsim3::Transaction Pending(uint64_t addr, uint64_t req_id) {
+    return dramsim3::Transaction(addr, false, 0, req_id);
+}
+
+// addresses whose home slot is the same in a table of num_slots slots,
+// hashed the way PendingTable does
+std::vector<uint64_t> CollidingAddresses(uint64_t num_slots, size_t num) {
+    int shift = 64;
+    for (uint64_t slots = 1; slots < num_slots; slots <<= 1) {
+        shift--;
+    }
+    std::vector<uint64_t> addrs;
+    uint64_t home = (64 * 0x9E3779B97F4A7C15ull) >> shift;
+    for (uint64_t addr = 64; addrs.size() < num; addr += 64) {
+        if (((addr * 0x9E3779B97F4A7C15ull) >> shift) == home) {
+            addrs.push_back(addr);
+        }
+    }
+    return addrs;
+}
+}  // namespace
+
+TEST_CASE("Pending table", "[pending_table]") {
+    dramsim3::PendingTable table(8);
+    dramsim3::Transaction trans;
+    REQUIRE(table.Size() == 0);
+    REQUIRE(table.Count(0x40) == 0);
+    REQUIRE_FALSE(table.PopFront(0x40, trans));
+
+    SECTION("Same address in the order inserted") {
+        table.Insert(Pending(0x40, 1));
+        table.Insert(Pending(0x80, 2));
+        table.Insert(Pending(0x40, 3));
+        REQUIRE(table.Count(0x40) == 2);
+        REQUIRE(table.Count(0x80) == 1);
+        REQUIRE(table.Size() == 3);
+        REQUIRE(table.PopFront(0x40, trans));
+        REQUIRE(trans.req_id == 1);
+        REQUIRE(table.PopFront(0x40, trans));
+        REQUIRE(trans.req_id == 3);
+        REQUIRE_FALSE(table.PopFront(0x40, trans));
+        REQUIRE(table.Count(0x40) == 0);
+        REQUIRE(table.Count(0x80) == 1);
+        REQUIRE(table.Size() == 1);
+    }
+
+    SECTION("Colliding addresses") {
+        // 8 entries make 16 slots, these all probe from the same one
+        auto addrs = CollidingAddresses(16, 4);
+        for (size_t i = 0; i < addrs.size(); i++) {
+            for (size_t j = 0; j <= i; j++) {
+                table.Insert(Pending(addrs[i], i));
+            }
+        }
+        for (size_t i = 0; i < addrs.size(); i++) {
+            REQUIRE(table.Count(addrs[i]) == static_cast<int>(i + 1));
+        }
+        // taking out the first of the probe sequence keeps the rest found,
+        // and its slot is taken again by the next address inserted
+        REQUIRE(table.PopFront(addrs[0], trans));
+        REQUIRE(table.Count(addrs[0]) == 0);
+        for (size_t i = 1; i < addrs.size(); i++) {
+            REQUIRE(table.Count(addrs[i]) == static_cast<int>(i + 1));
+        }
+        table.Insert(Pending(addrs[0], 10));
+        table.Insert(Pending(addrs[0], 11));
+        REQUIRE(table.Count(addrs[0]) == 2);
+        for (size_t i = 1; i < addrs.size(); i++) {
+            while (table.PopFront(addrs[i], trans)) {
+                REQUIRE(trans.req_id == i);
+            }
+            REQUIRE(table.Count(addrs[i]) == 0);
+        }
+        REQUIRE(table.PopFront(addrs[0], trans));
+        REQUIRE(trans.req_id == 10);
+        REQUIRE(table.Size() == 1);
+    }
+
+    SECTION("Grows and keeps up with a reference") {
+        // more pending than the table was made for, on few enough addresses
+        // that the probe sequences run into each other
+        std::map<uint64_t, std::deque<uint64_t>> expected;
+        uint64_t rand = 1;
+        uint64_t req_id = 0;
+        int size = 0;
+        for (int op = 0; op < 20000; op++) {
+            rand = rand * 6364136223846793005ull + 1;
+            uint64_t addr = ((rand >> 33) % 48) << 6;
+            // inserts win early on so the table fills up, then it drains
+            bool insert = (rand >> 20) % 100 < (op < 10000 ? 60u : 40u);
+            if (insert) {
+                table.Insert(Pending(addr, req_id));
+                expected[addr].push_back(req_id++);
+                size++;
+            } else {
+                bool popped = table.PopFront(addr, trans);
+                REQUIRE(popped == !expected[addr].empty());
+                if (popped) {
+                    REQUIRE(trans.req_id == expected[addr].front());
+                    REQUIRE(trans.addr.src_addr == addr);
+                    expected[addr].pop_front();
+                    size--;
+                }
+            }
+            REQUIRE(table.Size() == size);
+            if (op % 97 == 0) {
+                for (const auto& it : expected) {
+                    REQUIRE(table.Count(it.first) ==
+                            static_cast<int>(it.second.size()));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include "catch.hpp"
+#include <limits>
+#include <map>
+#include <vector>
+#include "configuration.h"
+#include "return_queue.h"
+
+namespace {
+dramsim3::Transaction Done(uint64_t req_id, uint64_t complete_cycle) {
+    dramsim3::Transaction trans(req_id << 6, false, 0, req_id);
+    trans.complete_cycle = complete_cycle;
+    return trans;
+}
+
+std::vector<uint64_t> Ids(const std::vector<dramsim3::Transaction>& done) {
+    std::vector<uint64_t> ids;
+    for (const auto& trans : done) {
+        ids.push_back(trans.req_id);
+    }
+    return ids;
+}
+}  // namespace
+
+TEST_CASE("Return queue", "[return_queue]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    dramsim3::ReturnQueue queue(config);
+    REQUIRE(queue.IsEmpty());
+    REQUIRE(queue.NextDueCycle() == std::numeric_limits<uint64_t>::max());
+
+    SECTION("Same cycle in the order added") {
+        queue.Add(Done(1, 5));
+        queue.Add(Done(2, 3));
+        queue.Add(Done(3, 5));
+        queue.Add(Done(4, 3));
+        REQUIRE(queue.NextDueCycle() == 3);
+        REQUIRE(queue.PopDone(2).empty());
+        REQUIRE(Ids(queue.PopDone(3)) == std::vector<uint64_t>{2, 4});
+        REQUIRE(queue.NextDueCycle() == 5);
+        REQUIRE(Ids(queue.PopDone(5)) == std::vector<uint64_t>{1, 3});
+        REQUIRE(queue.IsEmpty());
+    }
+
+    SECTION("Overdue ones at the next cycle not returned") {
+        queue.PopDone(10);
+        queue.Add(Done(1, 12));
+        queue.Add(Done(2, 4));
+        REQUIRE(queue.NextDueCycle() == 11);
+        REQUIRE(Ids(queue.PopDone(11)) == std::vector<uint64_t>{2});
+        REQUIRE(queue.PopDone(11).empty());
+        REQUIRE(Ids(queue.PopDone(12)) == std::vector<uint64_t>{1});
+    }
+
+    SECTION("Wraps around the wheel") {
+        // every cycle adds some due up to read_delay ahead, so the slots
+        // are reused many times over
+        std::multimap<uint64_t, uint64_t> expected;
+        uint64_t req_id = 0;
+        uint64_t rand = 1;
+        for (uint64_t clk = 0; clk < 2000; clk++) {
+            for (int i = 0; i < 3; i++) {
+                rand = rand * 6364136223846793005ull + 1;
+                uint64_t due = clk + (rand >> 33) % (config.read_delay + 1);
+                queue.Add(Done(req_id, due));
+                expected.emplace(due, req_id++);
+            }
+            if (!queue.IsEmpty()) {
+                REQUIRE(queue.NextDueCycle() == expected.begin()->first);
+            }
+            const auto& done = queue.PopDone(clk);
+            std::vector<uint64_t> expected_ids;
+            while (!expected.empty() && expected.begin()->first <= clk) {
+                expected_ids.push_back(expected.begin()->second);
+                expected.erase(expected.begin());
+            }
+            REQUIRE(Ids(done) == expected_ids);
+            for (const auto& trans : done) {
+                REQUIRE(trans.complete_cycle == clk);
+            }
+        }
+    }
+
+    SECTION("Grows for ones due further ahead") {
+        queue.Add(Done(1, 3));
+        queue.Add(Done(2, 10000));
+        queue.Add(Done(3, 3 + 1024));
+        REQUIRE(queue.NextDueCycle() == 3);
+        REQUIRE(Ids(queue.PopDone(3)) == std::vector<uint64_t>{1});
+        REQUIRE(queue.NextDueCycle() == 3 + 1024);
+        // popping a stretch returns them in the order they are due
+        REQUIRE(Ids(queue.PopDone(20000)) == std::vector<uint64_t>{3, 2});
+        REQUIRE(queue.IsEmpty());
+    }
+}
@@ -0,0 +1,125 @@
+#include "catch.hpp"
+#include <vector>
+#include "channel_state.h"
+#include "command_queue.h"
+#include "configuration.h"
+#include "scheduler.h"
+#include "simple_stats.h"
+#include "timing.h"
+
+namespace {
+dramsim3::Command Read(int source_id, int bank, int row, uint64_t clk = 0) {
+    dramsim3::Address addr(0, 0, 0, bank, row, 0);
+    dramsim3::Command cmd(dramsim3::CommandType::READ, addr, row << 16);
+    cmd.source_id = source_id;
+    cmd.added_cycle = clk;
+    return cmd;
+}
+
+// source of the first command a queue with the commands picks
+int FirstPickedSource(const std::string& scheduler,
+                      const std::vector<dramsim3::Command>& cmds) {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.scheduler = scheduler;
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::CommandQueue cmd_queue(0, config, channel_state, stats);
+    for (const auto& cmd : cmds) {
+        REQUIRE(cmd_queue.AddCommand(cmd));
+    }
+    auto cmd = cmd_queue.GetCommandToIssue();
+    REQUIRE(cmd.cmd_type == dramsim3::CommandType::ACTIVATE);
+    return cmd.source_id;
+}
+}  // namespace
+
+TEST_CASE("PARBS ranks the lighter source first", "[scheduler]") {
+    // source 0 has three requests to the bank, source 1 arrives last with
+    // one, so within the batch it has the shortest job
+    std::vector<dramsim3::Command> cmds = {Read(0, 0, 0, 0), Read(0, 0, 1, 1),
+                                           Read(0, 0, 2, 2), Read(1, 0, 3, 3)};
+    REQUIRE(FirstPickedSource("FRFCFS", cmds) == 0);
+    REQUIRE(FirstPickedSource("PARBS", cmds) == 1);
+}
+
+TEST_CASE("PARBS serves the batch first", "[scheduler]") {
+    // with one marked command per source per bank, source 1's second
+    // request to its bank is left out of the batch and waits for it
+    std::vector<dramsim3::Command> cmds = {Read(0, 0, 0, 0), Read(1, 1, 0, 1),
+                                           Read(1, 1, 1, 2)};
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.parbs_marking_cap = 1;
+    dramsim3::PARBSScheduler parbs(config);
+    std::vector<std::vector<dramsim3::Command>> queues = {cmds};
+    parbs.Prepare(queues, 0);
+    const auto& queue = queues[0];
+    REQUIRE(queue[0].marked);
+    REQUIRE(queue[1].marked);
+    REQUIRE_FALSE(queue[2].marked);
+    // the unmarked row hit loses to a marked miss
+    REQUIRE(parbs.Priority(queue[0], false, 3) >
+            parbs.Priority(queue[2], true, 3));
+    // equal loads, so row hits decide within the batch
+    REQUIRE(parbs.Priority(queue[1], true, 3) >
+            parbs.Priority(queue[0], false, 3));
+}
+
+TEST_CASE("ATLAS serves the least attained service first", "[scheduler]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.atlas_quantum = 100;
+    config.atlas_threshold = 50;
+    dramsim3::ATLASScheduler atlas(config);
+    std::vector<std::vector<dramsim3::Command>> queues;
+    // source 0 keeps the banks busy during the first quantum, source 1
+    // gets a single access
+    for (int i = 0; i < 4; i++) {
+        atlas.CommandIssued(Read(0, i, 0, i), i);
+    }
+    atlas.CommandIssued(Read(1, 0, 1, 4), 4);
+    atlas.Prepare(queues, 100);
+
+    auto heavy = Read(0, 0, 0, 90);
+    auto light = Read(1, 1, 0, 90);
+    // a miss from the less served source goes before a row hit
+    REQUIRE(atlas.Priority(light, false, 100) >
+            atlas.Priority(heavy, true, 100));
+    // among the same source row hits go first
+    REQUIRE(atlas.Priority(light, true, 100) >
+            atlas.Priority(light, false, 100));
+    // and starving commands before everything else
+    heavy.added_cycle = 0;
+    REQUIRE(atlas.Priority(heavy, false, 100) >
+            atlas.Priority(light, true, 100));
+}
+
+TEST_CASE("BLISS blacklists a source served in a row", "[scheduler]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.bliss_threshold = 2;
+    config.bliss_clearing_interval = 1000;
+    dramsim3::BLISSScheduler bliss(config);
+    std::vector<std::vector<dramsim3::Command>> queues;
+    auto streaming = Read(0, 0, 0);
+    auto other = Read(1, 1, 0);
+    REQUIRE(bliss.Priority(streaming, true, 0) >
+            bliss.Priority(other, false, 0));
+
+    // only column commands count, and more than bliss_threshold in a row
+    dramsim3::Command act = streaming;
+    act.cmd_type = dramsim3::CommandType::ACTIVATE;
+    bliss.CommandIssued(act, 0);
+    bliss.CommandIssued(streaming, 1);
+    bliss.CommandIssued(streaming, 2);
+    bliss.Prepare(queues, 3);
+    REQUIRE(bliss.Priority(streaming, true, 3) >
+            bliss.Priority(other, false, 3));
+    bliss.CommandIssued(streaming, 3);
+    bliss.Prepare(queues, 4);
+    REQUIRE(bliss.Priority(other, false, 4) >
+            bliss.Priority(streaming, true, 4));
+
+    // until the blacklist is cleared
+    bliss.Prepare(queues, 1000);
+    REQUIRE(bliss.Priority(streaming, true, 1000) >
+            bliss.Priority(other, false, 1000));
+}
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "catch.hpp"
+#include "channel_state.h"
+#include "configuration.h"
+#include "controller.h"
+#include "timing.h"
+#include "transaction_queue.h"
+
+namespace {
+dramsim3::Transaction MakeTransaction(int bankgroup, int bank, int row) {
+    dramsim3::Transaction trans(0x0, false);
+    trans.src_address = dramsim3::Address(0, 0, bankgroup, bank, row, 0);
+    return trans;
+}
+}  // namespace
+
+TEST_CASE("Row hits overtake older misses", "[transaction_queue]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    auto accept_all = [](int, int, int) { return true; };
+
+    dramsim3::TransactionQueue queue(config);
+    queue.reserve(config.trans_queue_size);
+    queue.push_back(MakeTransaction(0, 0, 3));
+    queue.push_back(MakeTransaction(0, 0, 5));
+    queue.push_back(MakeTransaction(1, 0, 5));
+    // no row is open yet
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == -1);
+
+    dramsim3::Address open_addr(0, 0, 0, 0, 5, 0);
+    channel_state.UpdateTimingAndStates(
+        dramsim3::Command(dramsim3::CommandType::ACTIVATE, open_addr, 0x0), 0);
+    REQUIRE(channel_state.IsRowOpen(0, 0, 0));
+    // the younger hit goes ahead of the older miss to the same bank
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == 1);
+    // unless its bank cannot take it
+    REQUIRE(queue.OldestRowHit(channel_state,
+                               [](int rank, int bankgroup, int bank) {
+                                   return !(rank == 0 && bankgroup == 0 &&
+                                            bank == 0);
+                               }) == -1);
+
+    // the oldest of the hits to different banks
+    dramsim3::Address other_addr(0, 0, 1, 0, 5, 0);
+    channel_state.UpdateTimingAndStates(
+        dramsim3::Command(dramsim3::CommandType::ACTIVATE, other_addr, 0x0),
+        config.tRRD_L);
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == 1);
+    queue.erase(queue.begin() + 1);
+    REQUIRE(queue.size() == 2);
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == 1);
+    REQUIRE(queue[1].src_address.bankgroup == 1);
+    queue.erase(queue.begin() + 1);
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == -1);
+}
+
+TEST_CASE("Copies are bucketed by their source", "[transaction_queue]") {
+    // the bank a copy is indexed under is its source address decoded like
+    // any other transaction, the way the queue mapped it before copies
+    // carried their decoded addresses
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    dramsim3::Timing timing(config);
+    dramsim3::ChannelState channel_state(config, timing);
+    auto accept_all = [](int, int, int) { return true; };
+
+    uint64_t src = (3ull << 15) | (5ull << 18) | 0x1c0;
+    uint64_t dest = (1ull << 15) | (9ull << 18);
+    dramsim3::Transaction copy(dramsim3::AddressPair(src, dest), false);
+    config.DecodeAddresses(copy);
+    auto expected = config.AddressMapping(dramsim3::AddressPair(src, dest));
+    REQUIRE(copy.src_address.bankgroup == expected.bankgroup);
+    REQUIRE(copy.src_address.bank == expected.bank);
+    REQUIRE(copy.src_address.row == expected.row);
+    REQUIRE(copy.dest_address.bank != copy.src_address.bank);
+
+    dramsim3::TransactionQueue queue(config);
+    queue.reserve(config.trans_queue_size);
+    queue.push_back(copy);
+    // the destination bank being open is no row hit
+    channel_state.UpdateTimingAndStates(
+        dramsim3::Command(dramsim3::CommandType::ACTIVATE, copy.dest_address,
+                          dest),
+        0);
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == -1);
+    channel_state.UpdateTimingAndStates(
+        dramsim3::Command(dramsim3::CommandType::ACTIVATE, expected, src),
+        config.tRRD_L);
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == 0);
+    queue.erase(queue.begin());
+    REQUIRE(queue.OldestRowHit(channel_state, accept_all) == -1);
+}
+
+TEST_CASE("Transactions moved per cycle", "[transaction_queue]") {
+    // reads to different banks, so each of them has its own command queue
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    REQUIRE(config.queue_structure == "PER_BANK");
+    std::vector<uint64_t> hex_addrs;
+    std::set<int> banks;
+    for (uint64_t hex_addr = 0; hex_addrs.size() < 4; hex_addr += 64) {
+        auto addr = config.AddressMapping(hex_addr);
+        int bank = addr.rank * config.banks +
+                   addr.bankgroup * config.banks_per_group + addr.bank;
+        if (addr.channel == 0 && banks.insert(bank).second) {
+            hex_addrs.push_back(hex_addr);
+        }
+    }
+
+    for (int trans_per_cycle : {1, 4}) {
+        config.trans_per_cycle = trans_per_cycle;
+        dramsim3::Timing timing(config);
+        dramsim3::Controller controller(0, config, timing);
+        for (auto hex_addr : hex_addrs) {
+            REQUIRE(controller.WillAcceptTransaction(hex_addr, false));
+            controller.AddTransaction(dramsim3::Transaction(hex_addr, false));
+        }
+        controller.ClockTick();
+        REQUIRE(controller.QueueUsage() == trans_per_cycle);
+        // commands stay queued until their reads go out
+        controller.ClockTick();
+        REQUIRE(controller.QueueUsage() == std::min(2 * trans_per_cycle, 4));
+    }
+}
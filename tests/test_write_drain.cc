@@ -0,0 +1,132 @@
+#include "catch.hpp"
+#include "configuration.h"
+#include "controller.h"
+#include "simple_stats.h"
+#include "timing.h"
+#include "write_drain.h"
+
+TEST_CASE("Write drain episodes", "[write_drain]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.write_high_watermark = 16;
+    config.write_low_watermark = 8;
+    config.write_drain_idle = 4;
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::WriteDrain drain(config, stats);
+    REQUIRE_FALSE(drain.IsDraining());
+
+    SECTION("Starts at the high watermark") {
+        REQUIRE_FALSE(drain.ShouldStart(15, false));
+        REQUIRE(drain.ShouldStart(16, false));
+    }
+
+    SECTION("Starts early when the command queue is idle") {
+        REQUIRE_FALSE(drain.ShouldStart(4, true));
+        // but never at or below the low watermark
+        REQUIRE_FALSE(drain.ShouldStart(8, true));
+        REQUIRE(drain.ShouldStart(9, true));
+        REQUIRE_FALSE(drain.ShouldStart(9, false));
+    }
+
+    SECTION("Drains down to the low watermark") {
+        drain.Start(18);
+        REQUIRE(stats.Count(dramsim3::CounterStat::NUM_WRITE_DRAINS) == 1);
+        // writes buffered in the meantime don't make the episode longer
+        for (int i = 0; i < 10; i++) {
+            REQUIRE(drain.IsDraining());
+            drain.WriteMoved();
+        }
+        REQUIRE_FALSE(drain.IsDraining());
+        drain.WriteMoved();
+        REQUIRE_FALSE(drain.IsDraining());
+    }
+
+    SECTION("Stops for reads") {
+        drain.Start(16);
+        drain.Stop();
+        REQUIRE_FALSE(drain.IsDraining());
+    }
+
+    SECTION("Counts turnarounds") {
+        drain.ColumnIssued(true);
+        drain.ColumnIssued(false);
+        drain.ColumnIssued(false);
+        drain.ColumnIssued(true);
+        REQUIRE(stats.Count(
+                    dramsim3::CounterStat::NUM_WR_TO_RD_TURNAROUNDS) == 1);
+        REQUIRE(stats.Count(
+                    dramsim3::CounterStat::NUM_RD_TO_WR_TURNAROUNDS) == 1);
+    }
+
+    SECTION("Keeps the watermarks unless adaptive") {
+        drain.ReadDone(100);
+        drain.EpochUpdate();
+        drain.ReadDone(200);
+        drain.EpochUpdate();
+        REQUIRE(drain.HighWatermark() == 16);
+        REQUIRE(drain.LowWatermark() == 8);
+    }
+}
+
+TEST_CASE("Adaptive write drain", "[write_drain]") {
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".");
+    config.trans_queue_size = 32;
+    config.write_high_watermark = 16;
+    config.write_low_watermark = 8;
+    config.write_drain_adaptive = true;
+    config.epoch_period = 1000;
+    dramsim3::SimpleStats stats(config, 0);
+    dramsim3::WriteDrain drain(config, stats);
+    int step = config.trans_queue_size / 16;
+
+    // reads getting slower bring the watermarks together
+    drain.ReadDone(100);
+    drain.EpochUpdate();
+    REQUIRE(drain.HighWatermark() == 16);
+    drain.ReadDone(120);
+    drain.EpochUpdate();
+    REQUIRE(drain.HighWatermark() == 16 - step);
+    REQUIRE(drain.LowWatermark() == 8 + step);
+    // down to one apart
+    for (int i = 0; i < 10; i++) {
+        drain.ReadDone(200 << i);
+        drain.EpochUpdate();
+    }
+    REQUIRE(drain.LowWatermark() < drain.HighWatermark());
+    REQUIRE(drain.HighWatermark() - drain.LowWatermark() <= step);
+
+    // and turnarounds taking over a tenth of the bus move them apart, but
+    // no higher than the configured high watermark
+    for (int epoch = 0; epoch < 10; epoch++) {
+        for (int i = 0; i < config.epoch_period / 10; i++) {
+            drain.ColumnIssued(true);
+            drain.ColumnIssued(false);
+        }
+        drain.EpochUpdate();
+    }
+    REQUIRE(drain.HighWatermark() == config.write_high_watermark);
+    REQUIRE(drain.LowWatermark() == 0);
+}
+
+TEST_CASE("Write drain on a queue of one", "[write_drain]") {
+    // no room for watermarks below the queue size, the defaults still work
+    dramsim3::Config config("configs/DDR4_8Gb_x8_3200.ini", ".",
+                            {{"trans_queue_size", "1"}});
+    REQUIRE(config.write_high_watermark == 1);
+    REQUIRE(config.write_low_watermark == 0);
+
+    dramsim3::Timing timing(config);
+    dramsim3::Controller controller(0, config, timing);
+    REQUIRE(controller.WillAcceptTransaction(0x0, true));
+    controller.AddTransaction(dramsim3::Transaction(0x0, true));
+    REQUIRE_FALSE(controller.WillAcceptTransaction(0x40, true));
+    // one write is the high watermark, so it moves on right away
+    controller.ClockTick();
+    REQUIRE(controller.QueueUsage() == 1);
+    REQUIRE(controller.WillAcceptTransaction(0x40, true));
+
+    // two is enough for the usual default
+    dramsim3::Config config2("configs/DDR4_8Gb_x8_3200.ini", ".",
+                             {{"trans_queue_size", "2"}});
+    REQUIRE(config2.write_high_watermark == 1);
+    REQUIRE(config2.write_low_watermark == 0);
+}